@@ -8,8 +8,36 @@
 #include <learnopengl/shader.h>
 #include <learnopengl/camera.h>
 #include <learnopengl/model.h>
+#include <learnopengl/frustum_culling.h>
+#include <learnopengl/occlusion_culling.h>
+#include <learnopengl/portal_visibility.h>
+#include <learnopengl/pvs.h>
+#include <learnopengl/render_queue.h>
+#include <learnopengl/program_cache.h>
+#include <learnopengl/shader_variants.h>
+#include <learnopengl/static_geometry.h>
+#include <learnopengl/texture_array.h>
+#include <learnopengl/texture_streamer.h>
+#include <learnopengl/ktx_texture.h>
+#include <learnopengl/texture_cache.h>
+#include <learnopengl/mip_streamer.h>
+#include <learnopengl/gltf_model.h>
+#include <learnopengl/lod.h>
+#include <learnopengl/clustered_lighting.h>
+#include <learnopengl/deferred_shading.h>
+#include <learnopengl/shadow_atlas.h>
+#include <learnopengl/frame_governor.h>
+#include <learnopengl/frame_pacer.h>
+#include <learnopengl/gpu_profiler.h>
+#include <learnopengl/cpu_profiler.h>
+#include <learnopengl/async_logger.h>
+#include <learnopengl/benchmark.h>
+#include <learnopengl/input_recorder.h>
 
 #include <iostream>
+#include <string>
+#include <algorithm>
+#include <cstdlib>
 
 #define STB_IMAGE_IMPLEMENTATION 
 #include <learnopengl/stb_image.h>
@@ -37,6 +65,9 @@ bool firstMouse = true;
 float deltaTime = 0.0f;
 float lastFrame = 0.0f;
 
+// Grabacion y reproduccion de la entrada (--record / --replay)
+InputRecorder inputRecorder;
+
 // Funcion para calcular la interseccin de rayos con un tringulo
 bool rayIntersectsTriangle(glm::vec3 rayOrigin, glm::vec3 rayDir, glm::vec3 v0, glm::vec3 v1, glm::vec3 v2, float& t) {
     const float EPSILON = 0.0000001f;
@@ -79,13 +110,70 @@ bool checkRayCollision(glm::vec3 rayOrigin, glm::vec3 rayDirection, float rayLen
     return false;
 }
 
-int main()
+int main(int argc, char** argv)
 {
+    // --benchmark [frames] [--png directorio] [--egl]: recorrido fijo sin ventana y estadisticas de tiempos
+    // --record archivo / --replay archivo: graba la entrada o repite una grabacion exactamente
+    BenchmarkRun benchmark;
+    bool useEGL = false;
+    std::string recordPath, replayPath;
+    for (int i = 1; i < argc; i++)
+    {
+        std::string arg = argv[i];
+        if (arg == "--benchmark") {
+            benchmark.active = true;
+            if (i + 1 < argc && argv[i + 1][0] != '-')
+                benchmark.frameCount = (unsigned int)std::atoi(argv[++i]);
+        }
+        else if (arg == "--png" && i + 1 < argc)
+            benchmark.pngDirectory = argv[++i];
+        else if (arg == "--egl")
+            useEGL = true;
+        else if (arg == "--record" && i + 1 < argc)
+            recordPath = argv[++i];
+        else if (arg == "--replay" && i + 1 < argc)
+            replayPath = argv[++i];
+        else
+            std::cout << "Argumento desconocido: " << arg << std::endl;
+    }
+    if (benchmark.active && !benchmark.loadPath("model/recorrido_benchmark.txt"))
+        return -1;
+    if (benchmark.active && (!recordPath.empty() || !replayPath.empty())) {
+        std::cout << "El benchmark sigue su propio recorrido; se ignoran --record y --replay" << std::endl;
+        recordPath.clear();
+        replayPath.clear();
+    }
+    if (!replayPath.empty() && !inputRecorder.startReplay(replayPath))
+        return -1;
+    if (!recordPath.empty() && replayPath.empty() && !inputRecorder.startRecording(recordPath))
+        return -1;
+
     // glfw: initialize and configure
+    if (benchmark.active) {
+        // Sin pantalla: plataforma nula de GLFW 3.4 con un contexto OSMesa (o EGL con --egl), asi
+        // corre con Mesa llvmpipe en maquinas sin GPU. La escena se dibuja igualmente en un FBO.
+#ifdef GLFW_PLATFORM_NULL
+        glfwInitHint(GLFW_PLATFORM, GLFW_PLATFORM_NULL);
+#else
+        std::cout << "BENCHMARK::Esta version de GLFW no tiene plataforma nula, se abrira una ventana" << std::endl;
+#endif
+    }
     glfwInit();
     glfwWindowHint(GLFW_CONTEXT_VERSION_MAJOR, 3);
     glfwWindowHint(GLFW_CONTEXT_VERSION_MINOR, 3);
     glfwWindowHint(GLFW_OPENGL_PROFILE, GLFW_OPENGL_CORE_PROFILE);
+    if (benchmark.active) {
+        glfwWindowHint(GLFW_VISIBLE, GLFW_FALSE);
+#ifdef GLFW_OSMESA_CONTEXT_API
+        glfwWindowHint(GLFW_CONTEXT_CREATION_API, useEGL ? GLFW_EGL_CONTEXT_API : GLFW_OSMESA_CONTEXT_API);
+#elif defined(GLFW_EGL_CONTEXT_API)
+        // GLFW 3.2 no tiene OSMesa: EGL si se pidio y si no el contexto nativo
+        if (useEGL)
+            glfwWindowHint(GLFW_CONTEXT_CREATION_API, GLFW_EGL_CONTEXT_API);
+#else
+        std::cout << "BENCHMARK::Esta version de GLFW no permite elegir el contexto, se usa el nativo" << std::endl;
+#endif
+    }
 
 #ifdef __APPLE__
     glfwWindowHint(GLFW_OPENGL_FORWARD_COMPAT, GL_TRUE);
@@ -100,6 +188,8 @@ int main()
         return -1;
     }
     glfwMakeContextCurrent(window);
+    if (benchmark.active)
+        glfwSwapInterval(0);
     glfwSetFramebufferSizeCallback(window, framebuffer_size_callback);
     glfwSetCursorPosCallback(window, mouse_callback);
     glfwSetScrollCallback(window, scroll_callback);
@@ -117,245 +207,642 @@ int main()
     // configure global opengl state
     glEnable(GL_DEPTH_TEST);
 
-    // build and compile shaders
-    Shader modelShader("shaders/shader_exercise16_mloading.vs", "shaders/shader_exercise16_mloading.fs");
-    Shader lampShader("shaders/lamp.vs", "shaders/lamp.fs");
-
-    // load models
-    Model casaModel("model/casa/casa.obj");
-    Model lampModel("model/lamp/lamp.obj");
-    Model ghostModel("model/ghost/ghost.obj");
-    Model mueble("model/mueble/cuelgaRopa.obj");
-    // Recoge todos los vrtices del modelo para las pruebas de colisin
-    std::vector<glm::vec3> modelVertices;
-    for (auto& mesh : casaModel.meshes) {
-        for (auto& vertex : mesh.vertices) {
-            modelVertices.push_back(vertex.Position);
-        }
-    }
-    glm::vec3 lastSafePosition = camera.Position;
-    // draw in wireframe
-    //glPolygonMode(GL_FRONT_AND_BACK, GL_LINE);
-
-    // camera settings
-    camera.MovementSpeed = 1;
-
-    // Posicin de la luz (posicin de la lmpara)
-    glm::vec3 lightPos1(7.52944, 1.12457, -60.3977);  // Posicin de la primera lmpara
-    glm::vec3 lightPos2(2.46593, 1.7368, -64.9968);   // Posicin de la segunda lmpara
-    glm::vec3 lightPos3(3.94016, 1.22564, -69.8362);
-    glm::vec3 lightPos4(3.56388, 1.79457, -65.1359);
-    glm::vec3 lightPos5(8.18261, 2.52822, -60.7235);
-    glm::vec3 lightPos6(6.81825, 1.88915, -61.0953);
-    glm::vec3 lightPos7(8.26567, 1.73277, -59.5191);
-    glm::vec3 lightPos8(3.99078, 3.69825, -69.4986);
-    glm::vec3 lightPos9(1.93347, 1.80134, -70.0527);
-    glm::vec3 lightPos10(2.69675, 2.24108, -68.8472);
-
-    // Reducir la atenuacin para hacer la luz ms uniforme y de mayor alcance
-    float constant = 1.0f;
-    float linear = 0.1f;    // Disminuir para aumentar el alcance de la luz
-    float quadratic = 0.012f; // Disminuir para que la luz caiga menos con la distancia
-    while (!glfwWindowShouldClose(window))
+    // Todo lo que tiene objetos de GL va en este bloque: sus destructores se llaman antes de
+    // glfwTerminate, con el contexto todavia activo
     {
-        // Per-frame time logic
-        float currentFrame = glfwGetTime();
-        deltaTime = currentFrame - lastFrame;
-        lastFrame = currentFrame;
-
-        // Input
-        processInput(window);
-        // Guarda la posicin actual antes de procesar el input
-        glm::vec3 initialPosition = camera.Position;
-
-        // Print the camera position
-        std::cout << "Camera Position - X: " << camera.Position.x << " Y: " << camera.Position.y << " Z: " << camera.Position.z << std::endl;
-
-        // Determinar la direccin de los rayos para cada direccin de movimiento
-        glm::vec3 forwardDirection = glm::normalize(camera.Front);
-        glm::vec3 backwardDirection = -forwardDirection;
-        glm::vec3 rightDirection = glm::normalize(camera.Right);
-        glm::vec3 leftDirection = -rightDirection;
-
-        float rayLength = 0.5f;  // Longitud del rayo para detectar colisiones cercanas
-
-        bool canMoveForward = !checkRayCollision(camera.Position, forwardDirection, rayLength, modelVertices);
-        bool canMoveBackward = !checkRayCollision(camera.Position, backwardDirection, rayLength, modelVertices);
-        bool canMoveRight = !checkRayCollision(camera.Position, rightDirection, rayLength, modelVertices);
-        bool canMoveLeft = !checkRayCollision(camera.Position, leftDirection, rayLength, modelVertices);
-
-        // input
-        bool isWalking = false; // Variable para detectar si la cmara se est moviendo
-
-        if (glfwGetKey(window, GLFW_KEY_W) == GLFW_PRESS && canMoveForward) {
-            camera.ProcessKeyboard(FORWARD, deltaTime * 5.0f); // Aumenta la velocidad de la cmara
-            isWalking = true;
-        }
-        if (glfwGetKey(window, GLFW_KEY_S) == GLFW_PRESS && canMoveBackward) {
-            camera.ProcessKeyboard(BACKWARD, deltaTime * 5.0f); // Aumenta la velocidad de la cmara
-            isWalking = true;
-        }
-        if (glfwGetKey(window, GLFW_KEY_A) == GLFW_PRESS && canMoveLeft) {
-            camera.ProcessKeyboard(LEFT, deltaTime * 5.0f); // Aumenta la velocidad de la cmara
-            isWalking = true;
-        }
-        if (glfwGetKey(window, GLFW_KEY_D) == GLFW_PRESS && canMoveRight) {
-            camera.ProcessKeyboard(RIGHT, deltaTime * 5.0f); // Aumenta la velocidad de la cmara
-            isWalking = true;
-        }
-        if (glfwGetKey(window, GLFW_KEY_ESCAPE) == GLFW_PRESS)
-            glfwSetWindowShouldClose(window, true);
-
-        // Simula el movimiento de caminata aplicando un efecto senoidal a la altura de la cmara
-        if (isWalking) {
-            timeWalking += deltaTime * walkSpeed;
-            camera.Position.y = fixedHeight + walkAmplitude * std::sin(timeWalking);
-        }
-        else {
-            // Si no est caminando, regresa a la altura base
-            camera.Position.y = fixedHeight;
+        // build and compile shaders
+        // Los programas salen de la cache de binarios o se mandan a compilar todos a la vez; el estado
+        // del enlazado se comprueba despues de cargar los modelos (ProgramCache::finishAll)
+        CachedShader modelShader("shaders/shader_exercise16_mloading.vs", "shaders/shader_exercise16_mloading.fs");
+        CachedShader lampShader("shaders/lamp.vs", "shaders/lamp.fs");
+        ShaderVariants houseShaders("shaders/house_static.vs", "shaders/house_static.fs"); // casa, una variante por tipo de material
+        OcclusionCuller occlusion("shaders/occlusion_box.vs", "shaders/occlusion_box.fs");
+        bool occlusionKeyPressed = false;
+
+        // Camino deferred opcional para la casa (tecla G), con las mismas variantes por material
+        ShaderVariants gbufferShaders("shaders/house_static.vs", "shaders/house_gbuffer.fs");
+        DeferredRenderer deferred("shaders/deferred_light.vs", "shaders/deferred_light.fs",
+                                  "shaders/deferred_ambient.vs", "shaders/deferred_ambient.fs");
+        bool deferredKeyPressed = false;
+
+        // Zonas de CPU del bucle; P exporta las ultimas a cpu_trace.json (chrome://tracing o Perfetto)
+        CpuProfiler::instance().setThreadName("render");
+        bool traceKeyPressed = false;
+
+        // Los mensajes del bucle van al log asincrono; la posicion de la camara como mucho 10 por segundo
+        AsyncLogger::instance().setLevel(LOG_CAMERA, LOG_DEBUG);
+        AsyncLogger::instance().setRateLimit(LOG_CAMERA, 10);
+
+        // load models
+        Model casaModel("model/casa/casa.obj");
+        Model lampModel("model/lamp/lamp.obj");
+        Model ghostModel("model/ghost/ghost.obj");
+
+        // Carga de texturas en segundo plano: capas de los arrays de la casa y mips de las cocinadas.
+        // Las cocinadas empiezan con sus mips de 64x64 o menos y cada frame se piden los niveles que
+        // hacen falta segun lo que ocupan en pantalla, sin pasar de budgetBytes. El benchmark y las
+        // repeticiones las cargan enteras para que cada frame se vea igual.
+        TextureStreamer textureStreamer;
+        MipStreamer mipStreamer(textureStreamer);
+        mipStreamer.budgetBytes = 96 * 1024 * 1024;
+        if (benchmark.active || inputRecorder.mode == INPUT_REPLAY)
+            mipStreamer.residentSize = 1 << 30;
+        TextureCache::instance().streaming = &mipStreamer;
+
+        // Una sola textura de GL por archivo (o por contenido igual) aunque la usen varios modelos, y
+        // la version comprimida por bloques de TextureCooker (.ktx junto a cada imagen) si existe
+        shareModelTextures(casaModel);
+        shareModelTextures(lampModel);
+        shareModelTextures(ghostModel);
+
+        // Props en glTF: sin assimp, los buffers van del .bin a la GPU sin pasar por Vertex y sus
+        // texturas ya salen de la cache
+        GltfModel relojGigante("model/silent_hill_1_meshes_-_relojGigante/scene.gltf");
+        GltfModel vela("model/silent_hill_1_meshes_-_vela2/scene.gltf");
+        TextureCache::instance().report();
+
+        // Reloj de pie junto a la primera lampara (estatico, como la casa)
+        glm::mat4 relojTransform = glm::mat4(1.0f);
+        relojTransform = glm::translate(relojTransform, glm::vec3(8.3f, 0.0f, -61.4f));
+        relojTransform = glm::rotate(relojTransform, glm::radians(-90.0f), glm::vec3(0.0f, 1.0f, 0.0f));
+        relojTransform = glm::scale(relojTransform, glm::vec3(0.0035f, 0.0035f, 0.0035f));
+        AABB relojBounds = transformAABB(relojGigante.bounds, relojTransform);
+
+        // Vela en el suelo al lado del reloj (el modelo ya esta en metros)
+        glm::mat4 velaTransform = glm::mat4(1.0f);
+        velaTransform = glm::translate(velaTransform, glm::vec3(8.7f, 0.0f, -62.3f));
+        velaTransform = glm::scale(velaTransform, glm::vec3(1.5f, 1.5f, 1.5f));
+        AABB velaBounds = transformAABB(vela.bounds, velaTransform);
+
+        // Matriz de la casa (estatica) y cajas envolventes de cada mesh en coordenadas de mundo para el frustum culling
+        glm::mat4 casaTransform = glm::mat4(1.0f);
+        casaTransform = glm::translate(casaTransform, glm::vec3(0.0, 0.0, 10.0));
+        casaTransform = glm::scale(casaTransform, glm::vec3(0.1f, 0.1f, 0.1f));
+        std::vector<AABB> casaBounds = computeModelBounds(casaModel, casaTransform);
+        AABB ghostLocalBounds = computeModelAABB(ghostModel);
+        unsigned int ghostOcclusionId = (unsigned int)casaModel.meshes.size(); // los ids 0..N-1 son los meshes de la casa
+        unsigned int relojOcclusionId = ghostOcclusionId + 1;
+        unsigned int velaOcclusionId = relojOcclusionId + 1;
+        occlusion.resize(velaOcclusionId + 1);
+        Frustum frustum;
+        CullingStats cullingStats;
+        float lastCullingReport = 0.0f;
+
+        // Recoge todos los vrtices del modelo para las pruebas de colisin
+        std::vector<glm::vec3> modelVertices;
+        for (auto& mesh : casaModel.meshes) {
+            for (auto& vertex : mesh.vertices) {
+                modelVertices.push_back(vertex.Position);
+            }
         }
+        glm::vec3 lastSafePosition = camera.Position;
+        // draw in wireframe
+        //glPolygonMode(GL_FRONT_AND_BACK, GL_LINE);
+
+        // camera settings
+        camera.MovementSpeed = 1;
+
+        // Posicin de la luz (posicin de la lmpara)
+        glm::vec3 lightPos1(7.52944, 1.12457, -60.3977);  // Posicin de la primera lmpara
+        glm::vec3 lightPos2(2.46593, 1.7368, -64.9968);   // Posicin de la segunda lmpara
+        glm::vec3 lightPos3(3.94016, 1.22564, -69.8362);
+        glm::vec3 lightPos4(3.56388, 1.79457, -65.1359);
+        glm::vec3 lightPos5(8.18261, 2.52822, -60.7235);
+        glm::vec3 lightPos6(6.81825, 1.88915, -61.0953);
+        glm::vec3 lightPos7(8.26567, 1.73277, -59.5191);
+        glm::vec3 lightPos8(3.99078, 3.69825, -69.4986);
+        glm::vec3 lightPos9(1.93347, 1.80134, -70.0527);
+        glm::vec3 lightPos10(2.69675, 2.24108, -68.8472);
+
+        // Reducir la atenuacin para hacer la luz ms uniforme y de mayor alcance
+        float constant = 1.0f;
+        float linear = 0.1f;    // Disminuir para aumentar el alcance de la luz
+        float quadratic = 0.012f; // Disminuir para que la luz caiga menos con la distancia
+
+        // Celdas (habitaciones) y portales (puertas/ventanas) de la casa para la visibilidad por portales
+        std::vector<glm::vec3> lightPositions = { lightPos1, lightPos2, lightPos3, lightPos4, lightPos5,
+                                                  lightPos6, lightPos7, lightPos8, lightPos9, lightPos10 };
+        CellPortalGraph cells;
+        cells.load("model/celdas_casa.txt");
+        cells.assignMeshes(casaBounds);
+
+        // Todas las luces van al shader de la casa por clusters (houseShaders); modelShader sigue con las 4 fijas.
+        // Con el corte por defecto (5%) el alcance salia de unos 36 m y cada luz llegaba a toda la casa
+        // (las habitaciones miden unos 10 m): al 20% queda en unos 14.6 m, lo que cruza una habitacion
+        ClusteredLights clusteredLights;
+        clusteredLights.setAttenuation(constant, linear, quadratic);
+        clusteredLights.intensityCutoff = 0.2f;
+        cells.assignLights(lightPositions, clusteredLights.lightRange());
+        std::vector<PointLight> frameLights;
+
+        // PVS precalculado con PVSBaker (si no existe o esta desactualizado se ignora)
+        uint32_t casaVertexCount = 0;
+        for (auto& mesh : casaModel.meshes)
+            casaVertexCount += (uint32_t)mesh.vertices.size();
+        PVSData pvs;
+        pvs.load("model/casa_pvs.bin", (uint32_t)casaModel.meshes.size(), casaVertexCount);
+
+        // Cola de render: los draws del frame se ordenan por estado antes de ejecutarse
+        RenderQueue renderQueue;
+
+        // La casa completa en un solo VBO/EBO: un multi-draw por material con los meshes visibles.
+        // Con useTextureArrays las texturas difusas del mismo tamano se juntan en arrays y casi toda
+        // la casa queda en uno o dos materiales. Cada material se dibuja con la variante de house_static
+        // que corresponde a sus texturas (array o 2D, mapas de normales/especular/emision, alpha test).
+        // Las texturas de los arrays se decodifican en otros hilos y se suben poco a poco en el bucle
+        // (textureStreamer.update); hasta que llegan la casa se ve gris.
+        bool useTextureArrays = true;
+        TextureArrays casaTextureArrays;
+        StaticGeometry casaGeometry(casaModel, useTextureArrays ? &casaTextureArrays : nullptr, &textureStreamer);
+        std::vector<VisibleMesh> casaVisible;
+
+        // La casa ya esta en el VBO/EBO de casaGeometry: fuera los buffers de cada Mesh (los vertices
+        // siguen en memoria para las colisiones y el PVS)
+        releaseMeshBuffers(casaModel);
+
+        // casaModel no se dibuja: las difusas 2D que ya estan en los arrays (copiadas de ellas en la
+        // GPU si no hay .ktx) se borran para no tenerlas dos veces en memoria
+        releaseArrayedTextures(casaModel, casaGeometry);
+
+        // Tiempos de GPU por pasada; la cola mide cada programa por separado
+        GpuProfiler gpuProfiler;
+        renderQueue.profiler = &gpuProfiler;
+        renderQueue.setProgramName(modelShader.ID, "fantasma");
+        // Las variantes que usan los materiales se compilan al cargar, no en el primer frame que se ven
+        for (unsigned int features : casaGeometry.featureMasks())
+            renderQueue.setProgramName(houseShaders.get(features).ID, "casa");
+        for (unsigned int features : relojGigante.featureMasks())
+            renderQueue.setProgramName(houseShaders.get(features).ID, "casa");
+        for (unsigned int features : vela.featureMasks())
+            renderQueue.setProgramName(houseShaders.get(features).ID, "casa");
+        renderQueue.setProgramName(lampShader.ID, "lamparas");
+        for (unsigned int features : casaGeometry.featureMasks())
+            if (!(features & MATERIAL_EMISSIVE_MAP))
+                renderQueue.setProgramName(gbufferShaders.get(features).ID, "casa (G-buffer)");
+
+        // Niveles de detalle de los props (se generan al cargar). lodBias > 0 baja el detalle en todos.
+        LodModel lampLod(lampModel);
+        LodModel ghostLod(ghostModel);
+        float lodBias = 0.0f;
+
+        // Sombras de todas las luces: la casa y los props glTF se dibujan una sola vez en el atlas estatico y
+        // cada frame solo se actualizan las caras por las que pasan las lamparas o el fantasma
+        ShadowAtlas shadows("shaders/shadow_depth.vs", "shaders/shadow_depth.fs", (unsigned int)lightPositions.size(), clusteredLights.lightRange());
+        shadows.addStaticProp(relojGigante, relojTransform);
+        shadows.addStaticProp(vela, velaTransform);
+        shadows.renderStatic(lightPositions, casaGeometry, casaTransform);
+        std::vector<ShadowCaster> shadowCasters;
+        AABB lampLocalBounds = computeModelAABB(lampModel);
+
+        // Todos los programas estan pedidos: errores de enlazado y binarios nuevos a la cache
+        ProgramCache::instance().finishAll();
+        ProgramCache::instance().report();
+
+        // La escena se dibuja a una resolucion interna y se reescala a la ventana. El governor mide
+        // el tiempo de CPU de cada frame, toma el de GPU del profiler y ajusta esa resolucion, el sesgo de LOD, el presupuesto
+        // de caras de sombra y el numero de luces para mantener los 16.6 ms.
+        ScaledRenderTarget sceneTarget;
+        FrameGovernor governor;
+        governor.enabled = !benchmark.active && inputRecorder.mode != INPUT_REPLAY;   // medir siempre la misma carga
+
+        // Como mucho un frame en cola en la GPU para que la vista con el raton responda antes.
+        // targetFps > 0 activa ademas el limitador (dormir y luego esperar activamente).
+        FramePacer pacer;
+        pacer.maxFramesInFlight = 1;
+        pacer.targetFps = 0.0f;
+
+        // El benchmark y las repeticiones tienen que ver lo mismo en cada frame: todo cargado antes de empezar
+        if (benchmark.active || inputRecorder.mode == INPUT_REPLAY)
+            textureStreamer.finish();
+
+        // Diametro en pixeles de una caja, para pedir los mips de las texturas de lo que hay dentro
+        auto screenSize = [&](const AABB& box) {
+            return projectedSize((box.min + box.max) * 0.5f, glm::length(box.max - box.min) * 0.5f, camera.Position, camera.Zoom, (float)SCR_HEIGHT);
+        };
+
+        // Props glTF estaticos: portales, frustum y occlusion query, y el nivel de detalle por tamano en pantalla
+        auto submitProp = [&](GltfModel& prop, const glm::mat4& propTransform, const AABB& propBounds, unsigned int occlusionId) {
+            GLuint query = 0;
+            cullingStats.tested++;
+            if (!cells.isPointVisible((propBounds.min + propBounds.max) * 0.5f)) {
+                cullingStats.portalCulled++;
+                return;
+            }
+            if (!frustum.intersects(propBounds)) {
+                cullingStats.culled++;
+                return;
+            }
+            if (!occlusion.test(occlusionId, propBounds, camera.Position, query)) {
+                cullingStats.occluded++;
+                return;
+            }
+            for (size_t i = 0; i < prop.materialCount(); i++)
+                mipStreamer.requestTextures(prop.materialTextures(i), screenSize(propBounds));
+            unsigned int level = prop.selectLevel(0, propTransform, camera.Position, camera.Zoom, (float)SCR_HEIGHT, lodBias);
+            prop.submit(renderQueue, houseShaders, propTransform, camera.Position, level, query);
+            cullingStats.drawn++;
+        };
+
+        // La lampara proyecta sombra siempre (salvo sobre su propia luz) y se dibuja si su habitacion es visible
+        auto submitLamp = [&](unsigned int instance, const glm::mat4& lampTransform, const glm::vec3& lightPos) {
+            AABB lampBounds = transformAABB(lampLocalBounds, lampTransform);
+            shadowCasters.push_back({ lampBounds, lampTransform, &lampLod, (int)instance });
+            if (!cells.isPointVisible(lightPos))
+                return;
+            for (const Mesh& mesh : lampModel.meshes)
+                mipStreamer.requestTextures(mesh.textures, screenSize(lampBounds));
+            float depth = glm::length(glm::vec3(lampTransform[3]) - camera.Position);
+            unsigned int level = lampLod.selectLevel(instance, lampTransform, camera.Position, camera.Zoom, (float)SCR_HEIGHT, lodBias);
+            for (unsigned int i = 0; i < lampLod.meshCount(); i++)
+                lampLod.submitMesh(renderQueue, RENDER_PASS_OPAQUE, lampShader.ID, i, level, lampTransform, depth).setLightPos(lightPos);
+        };
+
+        while (!glfwWindowShouldClose(window))
+        {
+            CpuZone frameZone("frame");
+
+            // Esperar a la GPU (y al limitador) antes de leer la entrada, asi se usa la mas reciente
+            {
+                CpuZone pacingZone("pacing");
+                pacer.beginFrame();
+            }
+            {
+                CpuZone eventsZone("eventos");
+                glfwPollEvents();
+            }
 
+            // Per-frame time logic
+            float currentFrame = benchmark.active ? benchmark.time() : (float)glfwGetTime();
+
+            // Grabando se guarda la entrada del frame; reproduciendo, el tiempo y la entrada salen del archivo
+            currentFrame = inputRecorder.beginFrame(window, currentFrame);
+            if (inputRecorder.mode == INPUT_REPLAY) {
+                for (const glm::vec2& move : inputRecorder.replayMouseMoves())
+                    camera.ProcessMouseMovement(move.x, move.y);
+                for (float scroll : inputRecorder.replayScrolls())
+                    camera.ProcessMouseScroll(scroll);
+                if (inputRecorder.replayFinished())
+                    glfwSetWindowShouldClose(window, true);
+            }
+            deltaTime = currentFrame - lastFrame;
+            lastFrame = currentFrame;
+            governor.beginFrame();
+            gpuProfiler.beginFrame();
+
+            // Niveles de mip para lo que se vio el frame anterior y como mucho 2 ms por frame subiendo
+            // texturas que ya han decodificado los hilos
+            {
+                CpuZone streamingZone("subida de texturas");
+                mipStreamer.update();
+                textureStreamer.update(2.0f);
+            }
 
+            // Input
+            {
+                CpuZone inputZone("input");
+                if (benchmark.active)
+                    benchmark.beginFrame(camera);
+                else
+                    processInput(window);
+            }
+            // Guarda la posicin actual antes de procesar el input
+            glm::vec3 initialPosition = camera.Position;
+
+            // Print the camera position
+            logMessage(LOG_CAMERA, LOG_DEBUG, "Camera Position - X: {} Y: {} Z: {}", camera.Position.x, camera.Position.y, camera.Position.z);
+
+            // Determinar la direccin de los rayos para cada direccin de movimiento
+            glm::vec3 forwardDirection = glm::normalize(camera.Front);
+            glm::vec3 backwardDirection = -forwardDirection;
+            glm::vec3 rightDirection = glm::normalize(camera.Right);
+            glm::vec3 leftDirection = -rightDirection;
+
+            float rayLength = 0.5f;  // Longitud del rayo para detectar colisiones cercanas
+
+            bool canMoveForward, canMoveBackward, canMoveRight, canMoveLeft;
+            {
+                CpuZone collisionZone("colision");
+                canMoveForward = !checkRayCollision(camera.Position, forwardDirection, rayLength, modelVertices);
+                canMoveBackward = !checkRayCollision(camera.Position, backwardDirection, rayLength, modelVertices);
+                canMoveRight = !checkRayCollision(camera.Position, rightDirection, rayLength, modelVertices);
+                canMoveLeft = !checkRayCollision(camera.Position, leftDirection, rayLength, modelVertices);
+            }
 
+            // input
+            bool isWalking = false; // Variable para detectar si la cmara se est moviendo
 
-        // Render
-        glClearColor(0.0f, 0.0f, 0.0f, 1.0f); // Fondo completamente negro para asegurar oscuridad en la escena
-        glClear(GL_COLOR_BUFFER_BIT | GL_DEPTH_BUFFER_BIT);
-
-        // Configuraciones de la proyeccin y vista
-        glm::mat4 projection = glm::perspective(glm::radians(camera.Zoom), (float)SCR_WIDTH / (float)SCR_HEIGHT, 0.1f, 100.0f);
-        glm::mat4 view = camera.GetViewMatrix();
-
-        // Renderizar la casa
-        modelShader.use();
-        modelShader.setMat4("projection", projection);
-        modelShader.setMat4("view", view);
-        modelShader.setVec3("lightPos1", lightPos1);
-        modelShader.setVec3("lightPos2", lightPos2);
-        modelShader.setVec3("lightPos3", lightPos3);
-        modelShader.setVec3("lightPos4", lightPos4);
-
-        modelShader.setVec3("viewPos", camera.Position);
-        modelShader.setVec3("lightColor", glm::vec3(1.0f, 0.8f, 0.6f)); // Luz clida
-
-        // Configuracin de atenuacin de la luz puntual
-        modelShader.setFloat("constant", constant);
-        modelShader.setFloat("linear", linear);
-        modelShader.setFloat("quadratic", quadratic);
-
-        glm::mat4 model = glm::mat4(1.0f);
-        model = glm::translate(model, glm::vec3(0.0, 0.0, 10.0));
-        model = glm::scale(model, glm::vec3(0.1f, 0.1f, 0.1f));
-        modelShader.setMat4("model", model);
-        casaModel.Draw(modelShader);
-
-        // Renderizar la primera lmpara 1
-        lampShader.use(); // Usar el shader especfico para la lmpara
-
-        lampShader.setVec3("lightPos", lightPos1);
-        lampShader.setVec3("viewPos", camera.Position);
-        lampShader.setVec3("lightColor", glm::vec3(1.0f, 0.8f, 0.6f)); // Color clido de la luz
-
-        model = glm::mat4(1.0f);  // Reinicializar la matriz model para la lmpara
-        float time = glfwGetTime();
-        float oscillation = sin(time) * 0.05f; // Oscilacin leve
-        float angle = sin(time) * glm::radians(5.0f); // ngulo pequeo para un balanceo suave
-
-        // Cambia la posicin base a una nueva ubicacin
-        model = glm::translate(model, glm::vec3(7.52944f, 0.9f, -60.3977f)); // Nueva posicin base
-        model = glm::rotate(model, angle, glm::vec3(0.0f, 0.0f, 1.0f)); // Aplicar una rotacin 
-        model = glm::translate(model, glm::vec3(oscillation, 0.0f, 0.0f)); // Oscilacin ligera
-
-        // Escala de la lmpara
-        model = glm::scale(model, glm::vec3(0.1f, 0.1f, 0.1f));
-
-        // Configurar las matrices en el shader de la lmpara
-        lampShader.setMat4("projection", projection);
-        lampShader.setMat4("view", view);
-        lampShader.setMat4("model", model);
-
-        // Renderizar el modelo de la primera lmpara
-        lampModel.Draw(lampShader);
-
-        // Renderizar la segunda lmpara2
-        lampShader.use(); // Usar el shader especfico para la lmpara
+            if (inputRecorder.getKey(window, GLFW_KEY_W) == GLFW_PRESS && canMoveForward) {
+                camera.ProcessKeyboard(FORWARD, deltaTime * 5.0f); // Aumenta la velocidad de la cmara
+                isWalking = true;
+            }
+            if (inputRecorder.getKey(window, GLFW_KEY_S) == GLFW_PRESS && canMoveBackward) {
+                camera.ProcessKeyboard(BACKWARD, deltaTime * 5.0f); // Aumenta la velocidad de la cmara
+                isWalking = true;
+            }
+            if (inputRecorder.getKey(window, GLFW_KEY_A) == GLFW_PRESS && canMoveLeft) {
+                camera.ProcessKeyboard(LEFT, deltaTime * 5.0f); // Aumenta la velocidad de la cmara
+                isWalking = true;
+            }
+            if (inputRecorder.getKey(window, GLFW_KEY_D) == GLFW_PRESS && canMoveRight) {
+                camera.ProcessKeyboard(RIGHT, deltaTime * 5.0f); // Aumenta la velocidad de la cmara
+                isWalking = true;
+            }
+            if (inputRecorder.getKey(window, GLFW_KEY_ESCAPE) == GLFW_PRESS)
+                glfwSetWindowShouldClose(window, true);
+
+            // O activa/desactiva el occlusion culling
+            bool occlusionKeyDown = inputRecorder.getKey(window, GLFW_KEY_O) == GLFW_PRESS;
+            if (occlusionKeyDown && !occlusionKeyPressed) {
+                occlusion.enabled = !occlusion.enabled;
+                logMessage(LOG_CULLING, LOG_INFO, "Occlusion culling: {}", occlusion.enabled ? "activado" : "desactivado");
+            }
+            occlusionKeyPressed = occlusionKeyDown;
 
-        lampShader.setVec3("lightPos", lightPos2);
-        lampShader.setVec3("viewPos", camera.Position);
-        lampShader.setVec3("lightColor", glm::vec3(1.0f, 0.8f, 0.6f)); // Color clido de la luz
+            // G alterna entre forward por clusters y deferred
+            bool deferredKeyDown = inputRecorder.getKey(window, GLFW_KEY_G) == GLFW_PRESS;
+            if (deferredKeyDown && !deferredKeyPressed) {
+                deferred.enabled = !deferred.enabled;
+                logMessage(LOG_RENDER, LOG_INFO, "Deferred shading: {}", deferred.enabled ? "activado" : "desactivado");
+            }
+            deferredKeyPressed = deferredKeyDown;
+
+            // P exporta el trace de CPU
+            bool traceKeyDown = inputRecorder.getKey(window, GLFW_KEY_P) == GLFW_PRESS;
+            if (traceKeyDown && !traceKeyPressed)
+                CpuProfiler::instance().exportChromeTrace("cpu_trace.json");
+            traceKeyPressed = traceKeyDown;
+
+            // Simula el movimiento de caminata aplicando un efecto senoidal a la altura de la cmara
+            if (isWalking) {
+                timeWalking += deltaTime * walkSpeed;
+                camera.Position.y = fixedHeight + walkAmplitude * std::sin(timeWalking);
+            }
+            else {
+                // Si no est caminando, regresa a la altura base
+                camera.Position.y = fixedHeight;
+            }
 
-        model = glm::mat4(1.0f);  // Reinicializar la matriz model para la segunda lmpara
-        oscillation = sin(time + 1.0f) * 0.05f; // Oscilacin leve diferente para la segunda lmpara
-        angle = sin(time + 1.0f) * glm::radians(5.0f); // ngulo pequeo para un balanceo suave
 
-        // Oscilacin y rotacin de la segunda lmpara
-        model = glm::translate(model, glm::vec3(2.7847, 0.85, -65.2366)); // Posicin base
-        model = glm::rotate(model, angle, glm::vec3(0.0f, 0.0f, 1.0f)); // Aplicar una rotacin 
-        model = glm::translate(model, glm::vec3(oscillation, 0.0f, 0.0f)); // Oscilacin ligera
 
-        // Escala de la lmpara
-        model = glm::scale(model, glm::vec3(0.1f, 0.1f, 0.1f));
 
-        // Configurar las matrices en el shader de la lmpara
-        lampShader.setMat4("projection", projection);
-        lampShader.setMat4("view", view);
-        lampShader.setMat4("model", model);
+            // Calidad del frame segun el governor
+            const FrameGovernor::QualityLevel& quality = governor.quality();
+            lodBias = quality.lodBias;
+            shadows.faceBudget = quality.shadowBudget;
+            int framebufferWidth, framebufferHeight;
+            glfwGetFramebufferSize(window, &framebufferWidth, &framebufferHeight);
+            sceneTarget.resize((int)(framebufferWidth * quality.renderScale), (int)(framebufferHeight * quality.renderScale));
+            sceneTarget.bind();
 
-        // Renderizar el modelo de la segunda lmpara
-        lampModel.Draw(lampShader);
+            // Render
+            glClearColor(0.0f, 0.0f, 0.0f, 1.0f); // Fondo completamente negro para asegurar oscuridad en la escena
+            glClear(GL_COLOR_BUFFER_BIT | GL_DEPTH_BUFFER_BIT);
 
-        //-----------------
-        // Renderizar la tercera lmpara 3
-        lampShader.use(); // Usar el shader especfico para la lmpara
+            // Configuraciones de la proyeccin y vista
+            glm::mat4 projection = glm::perspective(glm::radians(camera.Zoom), (float)SCR_WIDTH / (float)SCR_HEIGHT, 0.1f, 100.0f);
+            glm::mat4 view = camera.GetViewMatrix();
+            frustum.update(projection * view);
+            cells.computeVisibility(camera.Position, projection * view);
 
-        lampShader.setVec3("lightPos", lightPos3);
-        lampShader.setVec3("viewPos", camera.Position);
-        lampShader.setVec3("lightColor", glm::vec3(1.0f, 0.8f, 0.6f)); // Color clido de la luz
+            // Luces que llegan a alguna habitacion visible y al frustum, asignadas a los clusters
+            frameLights.clear();
+            float lightRange = clusteredLights.lightRange();
+            for (unsigned int i = 0; i < lightPositions.size(); i++)
+            {
+                AABB reach = { lightPositions[i] - glm::vec3(lightRange), lightPositions[i] + glm::vec3(lightRange) };
+                if (cells.isLightVisible(i) && frustum.intersects(reach))
+                    frameLights.push_back({ lightPositions[i], glm::vec3(1.0f), (int)i });
+            }
+            if (frameLights.size() > quality.maxLights) {
+                // Con poco margen solo se quedan las mas cercanas a la camara
+                std::partial_sort(frameLights.begin(), frameLights.begin() + quality.maxLights, frameLights.end(),
+                                  [&](const PointLight& a, const PointLight& b) {
+                                      return glm::length(a.position - camera.Position) < glm::length(b.position - camera.Position);
+                                  });
+                frameLights.resize(quality.maxLights);
+            }
+            clusteredLights.update(frameLights, view, projection, 0.1f, 100.0f);
+            const uint8_t* pvsBits = pvs.lookup(camera.Position);
+            cullingStats.reset();
+            shadowCasters.clear();
+
+            // Renderizar la casa (los mismos uniforms sirven para modelShader y las variantes de la casa)
+            auto setHouseUniforms = [&](auto& shader) {
+                shader.use();
+                shader.setMat4("projection", projection);
+                shader.setMat4("view", view);
+                shader.setVec3("lightPos1", lightPos1);
+                shader.setVec3("lightPos2", lightPos2);
+                shader.setVec3("lightPos3", lightPos3);
+                shader.setVec3("lightPos4", lightPos4);
+
+                shader.setVec3("viewPos", camera.Position);
+                shader.setVec3("lightColor", glm::vec3(1.0f, 0.8f, 0.6f)); // Luz clida
+
+                // Configuracin de atenuacin de la luz puntual
+                shader.setFloat("constant", constant);
+                shader.setFloat("linear", linear);
+                shader.setFloat("quadratic", quadratic);
+            };
+            {
+                CpuZone uniformZone("uniforms");
+                setHouseUniforms(modelShader);
+                houseShaders.forEach([&](ShaderVariant& variant) {
+                    setHouseUniforms(variant);
+                    clusteredLights.bind(variant, (float)sceneTarget.width, (float)sceneTarget.height);
+                });
+            }
 
-        model = glm::mat4(1.0f);  // Reinicializar la matriz model para la tercera lmpara
-        oscillation = sin(time + 2.0f) * 0.05f; // Oscilacin leve diferente para la tercera lmpara
-        angle = sin(time + 2.0f) * glm::radians(5.0f); // ngulo pequeo para un balanceo suave
+            // Los meshes visibles de la casa van a la cola de render (se dibujan ordenados al final del frame)
+            glm::mat4 model = casaTransform;
+            cullMeshes((unsigned int)casaModel.meshes.size(), casaBounds, frustum, occlusion, 0, camera.Position, cullingStats, casaVisible, &cells.meshMask(), pvsBits);
+            for (const VisibleMesh& visible : casaVisible)
+                mipStreamer.requestTextures(casaGeometry.meshTextures(visible.index), screenSize(casaBounds[visible.index]));
+            if (deferred.enabled) {
+                // La casa va al G-buffer y se ilumina con volumenes de luz; el resto se dibuja en forward encima
+                deferred.resize(sceneTarget.width, sceneTarget.height);
+                gbufferShaders.forEach([&](ShaderVariant& variant) {
+                    variant.use();
+                    variant.setMat4("projection", projection);
+                    variant.setMat4("view", view);
+                    variant.setFloat("roughness", 0.8f);
+                });
+                deferred.beginGeometryPass();
+                casaGeometry.submit(renderQueue, gbufferShaders, casaVisible, model, 0, MATERIAL_EMISSIVE_MAP);
+                {
+                    CpuZone submitZone("envio de draws");
+                    renderQueue.execute();
+                }
+                GpuScope lightingScope(gpuProfiler, "luces deferred");
+                deferred.lightingPass(frameLights, clusteredLights.lightRange(), frustum, view, projection, camera.Position,
+                                      glm::vec3(1.0f, 0.8f, 0.6f), constant, linear, quadratic, 0.1f, sceneTarget.fbo);
+                // Los materiales con emision no caben en el G-buffer: van en forward con el resto
+                casaGeometry.submit(renderQueue, houseShaders, casaVisible, model, MATERIAL_EMISSIVE_MAP);
+            }
+            else {
+                casaGeometry.submit(renderQueue, houseShaders, casaVisible, model);
+            }
 
-        // Cambia la posicin base a una nueva ubicacin
-        model = glm::translate(model, glm::vec3(3.68961f, 0.88f, -69.9629f)); // Nueva posicin base
-        model = glm::rotate(model, angle, glm::vec3(0.0f, 0.0f, 1.0f)); // Aplicar una rotacin 
-        model = glm::translate(model, glm::vec3(oscillation, 0.0f, 0.0f)); // Oscilacin ligera
+            // Uniforms de las lmparas que no cambian entre una y otra (lightPos va en cada comando)
+            lampShader.use(); // Usar el shader especfico para la lmpara
+            lampShader.setVec3("viewPos", camera.Position);
+            lampShader.setVec3("lightColor", glm::vec3(1.0f, 0.8f, 0.6f)); // Color clido de la luz
+            lampShader.setMat4("projection", projection);
+            lampShader.setMat4("view", view);
+
+            // Renderizar la primera lmpara 1
+            model = glm::mat4(1.0f);  // Reinicializar la matriz model para la lmpara
+            float time = currentFrame;
+            float oscillation = sin(time) * 0.05f; // Oscilacin leve
+            float angle = sin(time) * glm::radians(5.0f); // ngulo pequeo para un balanceo suave
+
+            // Cambia la posicin base a una nueva ubicacin
+            model = glm::translate(model, glm::vec3(7.52944f, 0.9f, -60.3977f)); // Nueva posicin base
+            model = glm::rotate(model, angle, glm::vec3(0.0f, 0.0f, 1.0f)); // Aplicar una rotacin 
+            model = glm::translate(model, glm::vec3(oscillation, 0.0f, 0.0f)); // Oscilacin ligera
+
+            // Escala de la lmpara
+            model = glm::scale(model, glm::vec3(0.1f, 0.1f, 0.1f));
+
+            // Renderizar el modelo de la primera lmpara (solo si su habitacin es visible)
+            submitLamp(0, model, lightPos1);
+
+            // Renderizar la segunda lmpara2
+            model = glm::mat4(1.0f);  // Reinicializar la matriz model para la segunda lmpara
+            oscillation = sin(time + 1.0f) * 0.05f; // Oscilacin leve diferente para la segunda lmpara
+            angle = sin(time + 1.0f) * glm::radians(5.0f); // ngulo pequeo para un balanceo suave
+
+            // Oscilacin y rotacin de la segunda lmpara
+            model = glm::translate(model, glm::vec3(2.7847, 0.85, -65.2366)); // Posicin base
+            model = glm::rotate(model, angle, glm::vec3(0.0f, 0.0f, 1.0f)); // Aplicar una rotacin 
+            model = glm::translate(model, glm::vec3(oscillation, 0.0f, 0.0f)); // Oscilacin ligera
+
+            // Escala de la lmpara
+            model = glm::scale(model, glm::vec3(0.1f, 0.1f, 0.1f));
+
+            // Renderizar el modelo de la segunda lmpara
+            submitLamp(1, model, lightPos2);
+
+            //-----------------
+            // Renderizar la tercera lmpara 3
+            model = glm::mat4(1.0f);  // Reinicializar la matriz model para la tercera lmpara
+            oscillation = sin(time + 2.0f) * 0.05f; // Oscilacin leve diferente para la tercera lmpara
+            angle = sin(time + 2.0f) * glm::radians(5.0f); // ngulo pequeo para un balanceo suave
+
+            // Cambia la posicin base a una nueva ubicacin
+            model = glm::translate(model, glm::vec3(3.68961f, 0.88f, -69.9629f)); // Nueva posicin base
+            model = glm::rotate(model, angle, glm::vec3(0.0f, 0.0f, 1.0f)); // Aplicar una rotacin 
+            model = glm::translate(model, glm::vec3(oscillation, 0.0f, 0.0f)); // Oscilacin ligera
+
+            // Escala de la lmpara
+            model = glm::scale(model, glm::vec3(0.1f, 0.1f, 0.1f));
+
+            // Renderizar el modelo de la tercera lmpara
+            submitLamp(2, model, lightPos3);
+
+            //----------------
+
+            // Renderizar el fantasma (usa el shader del modelo, ya configurado para la casa)
+
+            // Definir la posicin base del fantasma
+            glm::vec3 ghostBasePosition = glm::vec3(7.45636f, 0.3, -58.3212f);
+
+            // Calcular la posicin oscilante del fantasma en el eje Z
+            float ghostPositionZ = ghostBasePosition.z + sin(time) * 10.0f; // Oscilacin en el eje Z
+
+            // Configurar la matriz de modelo para el fantasma
+            model = glm::mat4(1.0f);  // Reinicializar la matriz model para el fantasma
+            model = glm::translate(model, glm::vec3(ghostBasePosition.x, ghostBasePosition.y, ghostPositionZ));
+            model = glm::scale(model, glm::vec3(0.06f, 0.06f, 0.06f));
+
+            // Renderizar el modelo del fantasma (se salta si esta fuera de la vista o detras de una pared)
+            AABB ghostBounds = transformAABB(ghostLocalBounds, model);
+            shadowCasters.push_back({ ghostBounds, model, &ghostLod, -1 });
+            GLuint ghostQuery = 0;
+            cullingStats.tested++;
+            if (!cells.isPointVisible((ghostBounds.min + ghostBounds.max) * 0.5f)) {
+                cullingStats.portalCulled++;
+            }
+            else if (!frustum.intersects(ghostBounds)) {
+                cullingStats.culled++;
+            }
+            else if (!occlusion.test(ghostOcclusionId, ghostBounds, camera.Position, ghostQuery)) {
+                cullingStats.occluded++;
+            }
+            else {
+                float ghostDepth = glm::length((ghostBounds.min + ghostBounds.max) * 0.5f - camera.Position);
+                unsigned int ghostLevel = ghostLod.selectLevel(0, model, camera.Position, camera.Zoom, (float)SCR_HEIGHT, lodBias);
+                for (const Mesh& mesh : ghostModel.meshes)
+                    mipStreamer.requestTextures(mesh.textures, screenSize(ghostBounds));
+                for (unsigned int i = 0; i < ghostLod.meshCount(); i++)
+                    ghostLod.submitMesh(renderQueue, RENDER_PASS_OPAQUE, modelShader.ID, i, ghostLevel, model, ghostDepth, ghostQuery);
+                cullingStats.drawn++;
+            }
 
-        // Escala de la lmpara
-        model = glm::scale(model, glm::vec3(0.1f, 0.1f, 0.1f));
-
-        // Configurar las matrices en el shader de la lmpara
-        lampShader.setMat4("projection", projection);
-        lampShader.setMat4("view", view);
-        lampShader.setMat4("model", model);
+            // Reloj de pie y vela (glTF, con las variantes de la casa); su sombra ya esta en el atlas estatico
+            submitProp(relojGigante, relojTransform, relojBounds, relojOcclusionId);
+            submitProp(vela, velaTransform, velaBounds, velaOcclusionId);
 
-        // Renderizar el modelo de la tercera lmpara
-        lampModel.Draw(lampShader);
+            // Caras de sombra afectadas por objetos en movimiento (dentro del presupuesto del frame)
+            {
+                GpuScope shadowScope(gpuProfiler, "sombras");
+                shadows.update(shadowCasters, camera.Position, sceneTarget.width, sceneTarget.height, sceneTarget.fbo);
+            }
+            houseShaders.forEach([&](ShaderVariant& variant) { shadows.bind(variant, 12); });
 
-        //----------------
+            // Dibujar todo lo encolado, ordenado por programa, texturas y profundidad
+            {
+                CpuZone submitZone("envio de draws");
+                renderQueue.execute();
+            }
 
-        // Renderizar el fantasma
-        modelShader.use();  // Volver a usar el shader del modelo para el fantasma
+            // Queries de oclusion con la profundidad de todo el frame (su resultado se usa en el siguiente)
+            {
+                GpuScope occlusionScope(gpuProfiler, "oclusion");
+                occlusion.issueQueries(projection, view);
+            }
 
-        // Definir la posicin base del fantasma
-        glm::vec3 ghostBasePosition = glm::vec3(7.45636f, 0.3, -58.3212f);
+            // Reescalar la escena a la ventana
+            {
+                GpuScope blitScope(gpuProfiler, "reescalado");
+                sceneTarget.blitToScreen(framebufferWidth, framebufferHeight);
+            }
 
-        // Calcular la posicin oscilante del fantasma en el eje Z
-        float ghostPositionZ = ghostBasePosition.z + sin(time) * 10.0f; // Oscilacin en el eje Z
+            // Reporte del culling una vez por segundo
+            if (currentFrame - lastCullingReport >= 1.0f) {
+                logMessage(LOG_CULLING, LOG_INFO, "Culling - Meshes probados: {} Por PVS: {} Por portales: {} Fuera de vista: {} Ocluidos: {} Dibujados: {}",
+                           cullingStats.tested, cullingStats.pvsCulled, cullingStats.portalCulled, cullingStats.culled, cullingStats.occluded, cullingStats.drawn);
+                logMessage(LOG_RENDER, LOG_INFO, "Cambios de estado - Sin ordenar: {} (programas {}, texturas {}, VAOs {}) Ordenado: {} (programas {}, texturas {}, VAOs {})",
+                           renderQueue.unsortedStats.total(), renderQueue.unsortedStats.programChanges, renderQueue.unsortedStats.textureBinds, renderQueue.unsortedStats.vaoBinds,
+                           renderQueue.sortedStats.total(), renderQueue.sortedStats.programChanges, renderQueue.sortedStats.textureBinds, renderQueue.sortedStats.vaoBinds);
+                logMessage(LOG_RENDER, LOG_INFO, "Luces - En clusters: {} Asignaciones: {} Max por cluster: {} Caras de sombra actualizadas: {} Pendientes: {}",
+                           clusteredLights.lightCount, clusteredLights.totalAssignments, clusteredLights.maxLightsPerCluster, shadows.facesUpdated, shadows.facesPending);
+                logMessage(LOG_PERF, LOG_INFO, "Frame - CPU: {} ms GPU: {} ms Espera fence: {} ms Limitador: {} ms Nivel de calidad: {} Resolucion interna: {}x{}",
+                           governor.cpuMs, governor.gpuMs, pacer.fenceWaitMs, pacer.limiterWaitMs, governor.qualityLevel(), sceneTarget.width, sceneTarget.height);
+                logMessage(LOG_PERF, LOG_INFO, "Texturas - Mips en streaming: {} KB de {} KB Pendientes de subir: {}",
+                           mipStreamer.residentBytes() / 1024, mipStreamer.budgetBytes / 1024, textureStreamer.pending());
+                gpuProfiler.report();
+                lastCullingReport = currentFrame;
+            }
 
-        // Configurar la matriz de modelo para el fantasma
-        model = glm::mat4(1.0f);  // Reinicializar la matriz model para el fantasma
-        model = glm::translate(model, glm::vec3(ghostBasePosition.x, ghostBasePosition.y, ghostPositionZ));
-        model = glm::scale(model, glm::vec3(0.06f, 0.06f, 0.06f));
-        modelShader.setMat4("model", model);
+            // glfw: swap buffers (los eventos se leen al principio del siguiente frame)
+            gpuProfiler.endFrame();
+            governor.endFrame(gpuProfiler.frameMs());
+            if (benchmark.active && benchmark.endFrame(gpuProfiler, sceneTarget.fbo, sceneTarget.width, sceneTarget.height))
+                glfwSetWindowShouldClose(window, true);
+            CpuZone swapZone("swap");
+            glfwSwapBuffers(window);
+            pacer.endFrame();
+        }
 
-        // Renderizar el modelo del fantasma
-        ghostModel.Draw(modelShader);
+        if (benchmark.active)
+            benchmark.report();
+        if (inputRecorder.mode == INPUT_REPLAY)
+            gpuProfiler.report();
+        inputRecorder.stop();
 
-        // glfw: swap buffers and poll IO events
-        glfwSwapBuffers(window);
-        glfwPollEvents();
+        // El reporte del profiler va por el log y apunta a los nombres de sus pasadas
+        AsyncLogger::instance().flush();
     }
 
     // glfw: terminate, clearing all previously allocated GLFW resources
@@ -366,16 +853,16 @@ int main()
 // process all input: query GLFW whether relevant keys are pressed/released this frame and react accordingly
 void processInput(GLFWwindow* window)
 {
-    if (glfwGetKey(window, GLFW_KEY_ESCAPE) == GLFW_PRESS)
+    if (inputRecorder.getKey(window, GLFW_KEY_ESCAPE) == GLFW_PRESS)
         glfwSetWindowShouldClose(window, true);
 
-    if (glfwGetKey(window, GLFW_KEY_W) == GLFW_PRESS)
+    if (inputRecorder.getKey(window, GLFW_KEY_W) == GLFW_PRESS)
         camera.ProcessKeyboard(FORWARD, deltaTime);
-    if (glfwGetKey(window, GLFW_KEY_S) == GLFW_PRESS)
+    if (inputRecorder.getKey(window, GLFW_KEY_S) == GLFW_PRESS)
         camera.ProcessKeyboard(BACKWARD, deltaTime);
-    if (glfwGetKey(window, GLFW_KEY_A) == GLFW_PRESS)
+    if (inputRecorder.getKey(window, GLFW_KEY_A) == GLFW_PRESS)
         camera.ProcessKeyboard(LEFT, deltaTime);
-    if (glfwGetKey(window, GLFW_KEY_D) == GLFW_PRESS)
+    if (inputRecorder.getKey(window, GLFW_KEY_D) == GLFW_PRESS)
         camera.ProcessKeyboard(RIGHT, deltaTime);
 }
 
@@ -401,11 +888,13 @@ void mouse_callback(GLFWwindow* window, double xpos, double ypos)
     lastX = xpos;
     lastY = ypos;
 
-    camera.ProcessMouseMovement(xoffset, yoffset);
+    if (inputRecorder.mouseMoved(xoffset, yoffset))
+        camera.ProcessMouseMovement(xoffset, yoffset);
 }
 
 // glfw: whenever the mouse scroll wheel scrolls, this callback is called
 void scroll_callback(GLFWwindow* window, double xoffset, double yoffset)
 {
-    camera.ProcessMouseScroll(yoffset);
+    if (inputRecorder.scrolled(yoffset))
+        camera.ProcessMouseScroll(yoffset);
 }
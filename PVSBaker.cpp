@@ -0,0 +1,376 @@
+#include <glad/glad.h>
+#include <GLFW/glfw3.h>
+
+#include <glm/glm.hpp>
+#include <glm/gtc/matrix_transform.hpp>
+
+#include <learnopengl/shader.h>
+#include <learnopengl/model.h>
+#include <learnopengl/frustum_culling.h>
+#include <learnopengl/pvs.h>
+
+#include <iostream>
+#include <vector>
+#include <thread>
+#include <atomic>
+#include <chrono>
+#include <cstdlib>
+
+#define STB_IMAGE_IMPLEMENTATION
+#include <learnopengl/stb_image.h>
+
+// Generador offline del PVS de la casa.
+// Uso: PVSBaker [tamCelda] [salida]   (por defecto 1.0 y model/casa_pvs.bin)
+//
+// Para cada celda caminable de la rejilla se rasteriza la casa por software (buffer de profundidad +
+// id de mesh) en las 6 caras de un cubo desde varios puntos de la celda, y se guarda que meshes
+// aparecen. Las celdas se reparten entre todos los hilos de la maquina.
+
+// settings del bake (los mismos valores que usa MainCode_TerrorHouse.cpp)
+const char* CASA_PATH = "model/casa/casa.obj";
+const float FIXED_HEIGHT = 0.2f;                  // fixedHeight
+const float WALK_AMPLITUDE = 0.2f;                // walkAmplitude
+const int SAMPLES_PER_AXIS = 2;                   // puntos por celda en X y en Z
+const int FACE_RESOLUTION = 96;                   // resolucion de cada cara del cubo
+const float NEAR_PLANE = 0.1f;
+const float FAR_PLANE = 100.0f;
+const float FLOOR_SEARCH_DISTANCE = 2.0f;         // una celda es caminable si hay suelo a esta distancia por debajo
+const bool DILATE = true;                         // une cada celda con sus vecinas para cubrir errores de muestreo
+
+struct BakeTriangle
+{
+    glm::vec3 v0, v1, v2;
+    unsigned int mesh;
+};
+
+// Buffers de un hilo para rasterizar una cara
+struct FaceBuffer
+{
+    std::vector<float> depth;
+    std::vector<int> id;
+
+    FaceBuffer() : depth(FACE_RESOLUTION * FACE_RESOLUTION), id(FACE_RESOLUTION * FACE_RESOLUTION) {}
+
+    void clear()
+    {
+        std::fill(depth.begin(), depth.end(), 1.0f);
+        std::fill(id.begin(), id.end(), -1);
+    }
+};
+
+// Misma prueba que en MainCode_TerrorHouse.cpp
+bool rayIntersectsTriangle(glm::vec3 rayOrigin, glm::vec3 rayDir, glm::vec3 v0, glm::vec3 v1, glm::vec3 v2, float& t) {
+    const float EPSILON = 0.0000001f;
+    glm::vec3 edge1 = v1 - v0;
+    glm::vec3 edge2 = v2 - v0;
+    glm::vec3 h = glm::cross(rayDir, edge2);
+    float a = glm::dot(edge1, h);
+    if (a > -EPSILON && a < EPSILON) {
+        return false;
+    }
+    float f = 1.0f / a;
+    glm::vec3 s = rayOrigin - v0;
+    float u = f * glm::dot(s, h);
+    if (u < 0.0f || u > 1.0f) {
+        return false;
+    }
+    glm::vec3 q = glm::cross(s, edge1);
+    float v = f * glm::dot(rayDir, q);
+    if (v < 0.0f || u + v > 1.0f) {
+        return false;
+    }
+    t = f * glm::dot(edge2, q);
+    return t > EPSILON;
+}
+
+// Rasteriza un triangulo ya en clip space (recortado contra el plano cercano) sobre la cara
+void rasterizeClipTriangle(const glm::vec4& c0, const glm::vec4& c1, const glm::vec4& c2, int mesh, FaceBuffer& face)
+{
+    const float half = FACE_RESOLUTION * 0.5f;
+    glm::vec3 p[3];
+    const glm::vec4* c[3] = { &c0, &c1, &c2 };
+    for (int i = 0; i < 3; i++)
+    {
+        float invW = 1.0f / c[i]->w;
+        p[i] = glm::vec3((c[i]->x * invW + 1.0f) * half, (c[i]->y * invW + 1.0f) * half, c[i]->z * invW * 0.5f + 0.5f);
+    }
+
+    float area = (p[1].x - p[0].x) * (p[2].y - p[0].y) - (p[1].y - p[0].y) * (p[2].x - p[0].x);
+    if (std::fabs(area) < 1e-8f)
+        return;
+    float invArea = 1.0f / area;
+
+    int minX = std::max(0, (int)std::floor(std::min(p[0].x, std::min(p[1].x, p[2].x))));
+    int maxX = std::min(FACE_RESOLUTION - 1, (int)std::ceil(std::max(p[0].x, std::max(p[1].x, p[2].x))));
+    int minY = std::max(0, (int)std::floor(std::min(p[0].y, std::min(p[1].y, p[2].y))));
+    int maxY = std::min(FACE_RESOLUTION - 1, (int)std::ceil(std::max(p[0].y, std::max(p[1].y, p[2].y))));
+
+    for (int y = minY; y <= maxY; y++)
+    {
+        for (int x = minX; x <= maxX; x++)
+        {
+            float px = x + 0.5f, py = y + 0.5f;
+            float w0 = ((p[1].x - px) * (p[2].y - py) - (p[1].y - py) * (p[2].x - px)) * invArea;
+            float w1 = ((p[2].x - px) * (p[0].y - py) - (p[2].y - py) * (p[0].x - px)) * invArea;
+            float w2 = 1.0f - w0 - w1;
+            if (w0 < 0.0f || w1 < 0.0f || w2 < 0.0f)
+                continue;
+            float z = w0 * p[0].z + w1 * p[1].z + w2 * p[2].z;
+            int index = y * FACE_RESOLUTION + x;
+            if (z >= 0.0f && z < face.depth[index])
+            {
+                face.depth[index] = z;
+                face.id[index] = mesh;
+            }
+        }
+    }
+}
+
+// Recorta contra el plano cercano (z >= -w en clip space de OpenGL) y rasteriza
+void rasterizeTriangle(const BakeTriangle& triangle, const glm::mat4& viewProjection, FaceBuffer& face)
+{
+    glm::vec4 in[3] = {
+        viewProjection * glm::vec4(triangle.v0, 1.0f),
+        viewProjection * glm::vec4(triangle.v1, 1.0f),
+        viewProjection * glm::vec4(triangle.v2, 1.0f)
+    };
+
+    // Rechazo rapido si los tres vertices estan fuera del mismo lado
+    if ((in[0].x > in[0].w && in[1].x > in[1].w && in[2].x > in[2].w) ||
+        (in[0].x < -in[0].w && in[1].x < -in[1].w && in[2].x < -in[2].w) ||
+        (in[0].y > in[0].w && in[1].y > in[1].w && in[2].y > in[2].w) ||
+        (in[0].y < -in[0].w && in[1].y < -in[1].w && in[2].y < -in[2].w) ||
+        (in[0].z > in[0].w && in[1].z > in[1].w && in[2].z > in[2].w))
+        return;
+
+    glm::vec4 out[4];
+    int count = 0;
+    for (int i = 0; i < 3; i++)
+    {
+        const glm::vec4& a = in[i];
+        const glm::vec4& b = in[(i + 1) % 3];
+        float da = a.z + a.w, db = b.z + b.w;
+        if (da >= 0.0f)
+            out[count++] = a;
+        if ((da >= 0.0f) != (db >= 0.0f))
+        {
+            float t = da / (da - db);
+            out[count++] = a + (b - a) * t;
+        }
+    }
+    for (int i = 1; i + 1 < count; i++)
+        rasterizeClipTriangle(out[0], out[i], out[i + 1], (int)triangle.mesh, face);
+}
+
+int main(int argc, char** argv)
+{
+    float cellSize = argc > 1 ? (float)std::atof(argv[1]) : 1.0f;
+    const char* outputPath = argc > 2 ? argv[2] : "model/casa_pvs.bin";
+    if (cellSize <= 0.0f)
+        cellSize = 1.0f;
+
+    // El Model de learnopengl sube las texturas a OpenGL, asi que hace falta un contexto (ventana oculta)
+    glfwInit();
+    glfwWindowHint(GLFW_CONTEXT_VERSION_MAJOR, 3);
+    glfwWindowHint(GLFW_CONTEXT_VERSION_MINOR, 3);
+    glfwWindowHint(GLFW_OPENGL_PROFILE, GLFW_OPENGL_CORE_PROFILE);
+    glfwWindowHint(GLFW_VISIBLE, GLFW_FALSE);
+#ifdef __APPLE__
+    glfwWindowHint(GLFW_OPENGL_FORWARD_COMPAT, GL_TRUE);
+#endif
+    GLFWwindow* window = glfwCreateWindow(64, 64, "PVS Baker", NULL, NULL);
+    if (window == NULL)
+    {
+        std::cout << "Failed to create GLFW window" << std::endl;
+        glfwTerminate();
+        return -1;
+    }
+    glfwMakeContextCurrent(window);
+    if (!gladLoadGLLoader((GLADloadproc)glfwGetProcAddress))
+    {
+        std::cout << "Failed to initialize GLAD" << std::endl;
+        return -1;
+    }
+
+    Model casaModel(CASA_PATH);
+
+    // Misma matriz que casaTransform en MainCode_TerrorHouse.cpp
+    glm::mat4 casaTransform = glm::mat4(1.0f);
+    casaTransform = glm::translate(casaTransform, glm::vec3(0.0, 0.0, 10.0));
+    casaTransform = glm::scale(casaTransform, glm::vec3(0.1f, 0.1f, 0.1f));
+
+    std::vector<AABB> meshBounds = computeModelBounds(casaModel, casaTransform);
+    std::vector<BakeTriangle> triangles;
+    std::vector<std::vector<unsigned int>> meshTriangles(casaModel.meshes.size());
+    uint32_t vertexCount = 0;
+    AABB world;
+    world.min = glm::vec3(FLT_MAX);
+    world.max = glm::vec3(-FLT_MAX);
+    for (unsigned int m = 0; m < casaModel.meshes.size(); m++)
+    {
+        const Mesh& mesh = casaModel.meshes[m];
+        vertexCount += (uint32_t)mesh.vertices.size();
+        for (size_t i = 0; i + 2 < mesh.indices.size(); i += 3)
+        {
+            BakeTriangle triangle;
+            triangle.v0 = glm::vec3(casaTransform * glm::vec4(mesh.vertices[mesh.indices[i]].Position, 1.0f));
+            triangle.v1 = glm::vec3(casaTransform * glm::vec4(mesh.vertices[mesh.indices[i + 1]].Position, 1.0f));
+            triangle.v2 = glm::vec3(casaTransform * glm::vec4(mesh.vertices[mesh.indices[i + 2]].Position, 1.0f));
+            triangle.mesh = m;
+            meshTriangles[m].push_back((unsigned int)triangles.size());
+            triangles.push_back(triangle);
+        }
+        world.min = glm::min(world.min, meshBounds[m].min);
+        world.max = glm::max(world.max, meshBounds[m].max);
+    }
+    glfwTerminate();
+
+    PVSData pvs;
+    pvs.originX = world.min.x;
+    pvs.originZ = world.min.z;
+    pvs.cellSize = cellSize;
+    pvs.cellsX = (uint32_t)std::ceil((world.max.x - world.min.x) / cellSize);
+    pvs.cellsZ = (uint32_t)std::ceil((world.max.z - world.min.z) / cellSize);
+    pvs.meshCount = (uint32_t)casaModel.meshes.size();
+    pvs.vertexCount = vertexCount;
+    uint32_t cellCount = pvs.cellsX * pvs.cellsZ;
+    std::cout << "PVS::" << triangles.size() << " triangulos, " << pvs.meshCount << " meshes, rejilla "
+              << pvs.cellsX << "x" << pvs.cellsZ << std::endl;
+
+    // Direcciones de las 6 caras del cubo
+    const glm::vec3 faceDirections[6] = { {1, 0, 0}, {-1, 0, 0}, {0, 1, 0}, {0, -1, 0}, {0, 0, 1}, {0, 0, -1} };
+    const glm::vec3 faceUps[6] = { {0, 1, 0}, {0, 1, 0}, {0, 0, -1}, {0, 0, 1}, {0, 1, 0}, {0, 1, 0} };
+    glm::mat4 faceProjection = glm::perspective(glm::radians(90.0f), 1.0f, NEAR_PLANE, FAR_PLANE);
+    const float sampleHeights[2] = { FIXED_HEIGHT - WALK_AMPLITUDE, FIXED_HEIGHT + WALK_AMPLITUDE };
+
+    std::vector<std::vector<uint8_t>> cellBits(cellCount);
+    std::vector<char> walkable(cellCount, 0);
+    std::atomic<uint32_t> nextCell(0);
+    std::atomic<uint32_t> doneCells(0);
+
+    auto worker = [&]()
+    {
+        FaceBuffer face;
+        Frustum frustum;
+        std::vector<uint8_t> bits(pvs.bytesPerSet());
+        for (uint32_t cell = nextCell++; cell < cellCount; cell = nextCell++)
+        {
+            uint32_t cx = cell % pvs.cellsX, cz = cell / pvs.cellsX;
+            glm::vec3 center(pvs.originX + (cx + 0.5f) * cellSize, FIXED_HEIGHT, pvs.originZ + (cz + 0.5f) * cellSize);
+
+            // Caminable: hay suelo debajo del centro de la celda
+            bool hasFloor = false;
+            for (const BakeTriangle& triangle : triangles)
+            {
+                float t;
+                if (rayIntersectsTriangle(center, glm::vec3(0.0f, -1.0f, 0.0f), triangle.v0, triangle.v1, triangle.v2, t) && t < FLOOR_SEARCH_DISTANCE)
+                {
+                    hasFloor = true;
+                    break;
+                }
+            }
+            if (!hasFloor)
+            {
+                doneCells++;
+                continue;
+            }
+
+            std::fill(bits.begin(), bits.end(), 0);
+            for (int sx = 0; sx < SAMPLES_PER_AXIS; sx++)
+            for (int sz = 0; sz < SAMPLES_PER_AXIS; sz++)
+            for (float height : sampleHeights)
+            {
+                glm::vec3 eye(pvs.originX + (cx + (sx + 0.5f) / SAMPLES_PER_AXIS) * cellSize, height,
+                              pvs.originZ + (cz + (sz + 0.5f) / SAMPLES_PER_AXIS) * cellSize);
+
+                for (int f = 0; f < 6; f++)
+                {
+                    glm::mat4 viewProjection = faceProjection * glm::lookAt(eye, eye + faceDirections[f], faceUps[f]);
+                    frustum.update(viewProjection);
+                    face.clear();
+                    for (unsigned int m = 0; m < pvs.meshCount; m++)
+                    {
+                        if (!frustum.intersects(meshBounds[m]))
+                            continue;
+                        for (unsigned int t : meshTriangles[m])
+                            rasterizeTriangle(triangles[t], viewProjection, face);
+                    }
+                    for (int id : face.id)
+                        if (id >= 0)
+                            bits[id >> 3] |= (uint8_t)(1 << (id & 7));
+                }
+
+                // Meshes que contienen el punto (la camara esta dentro de su caja): siempre visibles
+                for (unsigned int m = 0; m < pvs.meshCount; m++)
+                {
+                    const AABB& b = meshBounds[m];
+                    if (eye.x >= b.min.x - NEAR_PLANE && eye.x <= b.max.x + NEAR_PLANE &&
+                        eye.y >= b.min.y - NEAR_PLANE && eye.y <= b.max.y + NEAR_PLANE &&
+                        eye.z >= b.min.z - NEAR_PLANE && eye.z <= b.max.z + NEAR_PLANE)
+                        bits[m >> 3] |= (uint8_t)(1 << (m & 7));
+                }
+            }
+            cellBits[cell] = bits;
+            walkable[cell] = 1;
+
+            uint32_t done = ++doneCells;
+            if (done % 50 == 0)
+                std::cout << "PVS::" << done << "/" << cellCount << " celdas" << std::endl;
+        }
+    };
+
+    auto start = std::chrono::steady_clock::now();
+    unsigned int threadCount = std::max(1u, std::thread::hardware_concurrency());
+    std::vector<std::thread> threads;
+    for (unsigned int i = 0; i < threadCount; i++)
+        threads.emplace_back(worker);
+    for (std::thread& thread : threads)
+        thread.join();
+
+    // Dilatacion: cada celda ve tambien lo que ven sus vecinas caminables
+    std::vector<std::vector<uint8_t>> finalBits = cellBits;
+    if (DILATE)
+    {
+        for (uint32_t cell = 0; cell < cellCount; cell++)
+        {
+            if (!walkable[cell])
+                continue;
+            int cx = (int)(cell % pvs.cellsX), cz = (int)(cell / pvs.cellsX);
+            for (int dz = -1; dz <= 1; dz++)
+            for (int dx = -1; dx <= 1; dx++)
+            {
+                int nx = cx + dx, nz = cz + dz;
+                if (nx < 0 || nz < 0 || nx >= (int)pvs.cellsX || nz >= (int)pvs.cellsZ)
+                    continue;
+                uint32_t neighbour = (uint32_t)nz * pvs.cellsX + nx;
+                if (!walkable[neighbour])
+                    continue;
+                for (size_t b = 0; b < finalBits[cell].size(); b++)
+                    finalBits[cell][b] |= cellBits[neighbour][b];
+            }
+        }
+    }
+
+    pvs.cellSet.assign(cellCount, PVS_NO_SET);
+    uint64_t visibleTotal = 0, walkableCount = 0;
+    for (uint32_t cell = 0; cell < cellCount; cell++)
+    {
+        if (!walkable[cell])
+            continue;
+        pvs.cellSet[cell] = pvs.addSet(finalBits[cell]);
+        walkableCount++;
+        for (unsigned int m = 0; m < pvs.meshCount; m++)
+            visibleTotal += PVSData::isVisible(finalBits[cell].data(), m);
+    }
+
+    float seconds = std::chrono::duration<float>(std::chrono::steady_clock::now() - start).count();
+    if (!pvs.save(outputPath))
+    {
+        std::cout << "PVS::No se pudo escribir " << outputPath << std::endl;
+        return -1;
+    }
+    std::cout << "PVS::" << walkableCount << " celdas caminables, " << pvs.sets.size() << " sets distintos, media de "
+              << (walkableCount ? (float)visibleTotal / walkableCount : 0.0f) << " meshes visibles por celda" << std::endl;
+    std::cout << "PVS::Guardado en " << outputPath << " (" << seconds << " s, " << threadCount << " hilos)" << std::endl;
+    return 0;
+}
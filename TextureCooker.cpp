@@ -0,0 +1,569 @@
+#include <glad/glad.h>
+#include <GLFW/glfw3.h>
+
+#include <glm/glm.hpp>
+
+#include <learnopengl/ktx_texture.h>
+
+#include <iostream>
+#include <vector>
+#include <string>
+#include <thread>
+#include <atomic>
+#include <chrono>
+#include <algorithm>
+#include <cmath>
+#include <cstring>
+#include <cctype>
+
+#define STB_IMAGE_IMPLEMENTATION
+#include <learnopengl/stb_image.h>
+
+// Cocinado offline de texturas a formatos comprimidos por bloques.
+// Uso: TextureCooker [--bc7] [--color|--normal|--mask|--auto] archivos...
+//
+// Cada archivo se convierte en un .ktx a su lado (ver ktx_texture.h) con la cadena de mips
+// completa. El formato depende del uso de la textura, que se deduce del nombre (o se fuerza con
+// --color/--normal/--mask para los archivos que vienen despues):
+//   color (baseColor, difusa, emision)  BC1, o BC3 si tiene alfa          (4 / 8 bits por pixel)
+//   normal                              BC5 con X e Y; Z se reconstruye en el shader (8 bpp)
+//   mask (roughness, metallic, AO...)   BC4 si es gris, BC1 si no          (4 bpp)
+// Con --bc7 el color y las mascaras en color van a BC7 (8 bpp, mejor calidad; necesita GL 4.2 o
+// ARB_texture_compression_bptc, si no el juego carga el original). Los archivos se reparten entre
+// todos los hilos de la maquina.
+
+enum TextureUsage
+{
+    USAGE_AUTO = 0,
+    USAGE_COLOR,
+    USAGE_NORMAL,
+    USAGE_MASK
+};
+
+struct CookJob
+{
+    std::string path;
+    TextureUsage usage = USAGE_AUTO;
+    // Resultado
+    bool ok = false;
+    int width = 0, height = 0;
+    GLenum format = 0;
+    size_t sourceBytes = 0;   // lo que ocupaba en VRAM sin comprimir (RGB/RGBA8 con mips)
+    size_t cookedBytes = 0;
+};
+
+const char* usageName(TextureUsage usage)
+{
+    return usage == USAGE_NORMAL ? "normal" : usage == USAGE_MASK ? "mask" : "color";
+}
+
+TextureUsage usageFromName(const std::string& path)
+{
+    std::string name = path;
+    std::transform(name.begin(), name.end(), name.begin(), [](unsigned char c) { return (char)std::tolower(c); });
+    if (name.find("normal") != std::string::npos)
+        return USAGE_NORMAL;
+    const char* masks[] = { "roughness", "metallic", "occlusion", "specular", "_ao", "mask", "height" };
+    for (const char* mask : masks)
+        if (name.find(mask) != std::string::npos)
+            return USAGE_MASK;
+    return USAGE_COLOR;
+}
+
+// ---------------------------------------------------------------------------------------------
+// Mips
+
+typedef std::vector<glm::vec4> Pixels;   // RGBA en 0..255
+
+Pixels downsample(const Pixels& source, int width, int height, bool normalMap)
+{
+    int w = std::max(1, width / 2), h = std::max(1, height / 2);
+    Pixels result((size_t)w * h);
+    for (int y = 0; y < h; y++)
+    {
+        for (int x = 0; x < w; x++)
+        {
+            int x0 = std::min(2 * x, width - 1), x1 = std::min(2 * x + 1, width - 1);
+            int y0 = std::min(2 * y, height - 1), y1 = std::min(2 * y + 1, height - 1);
+            glm::vec4 sum = source[(size_t)y0 * width + x0] + source[(size_t)y0 * width + x1] +
+                            source[(size_t)y1 * width + x0] + source[(size_t)y1 * width + x1];
+            glm::vec4 average = sum * 0.25f;
+            if (normalMap)
+            {
+                // Media de las normales y vuelta a longitud 1, si no los mips pequenos se aplanan
+                glm::vec3 n = glm::vec3(average) / 127.5f - 1.0f;
+                float length = glm::length(n);
+                n = length > 1e-5f ? n / length : glm::vec3(0.0f, 0.0f, 1.0f);
+                average = glm::vec4((n + 1.0f) * 127.5f, average.w);
+            }
+            result[(size_t)y * w + x] = average;
+        }
+    }
+    return result;
+}
+
+// Bloque de 4x4 (fila a fila), repitiendo el borde si la imagen no es multiplo de 4
+void fetchBlock(const Pixels& pixels, int width, int height, int bx, int by, glm::vec4 block[16])
+{
+    for (int y = 0; y < 4; y++)
+        for (int x = 0; x < 4; x++)
+            block[y * 4 + x] = pixels[(size_t)std::min(by * 4 + y, height - 1) * width + std::min(bx * 4 + x, width - 1)];
+}
+
+// ---------------------------------------------------------------------------------------------
+// Codificadores de bloque
+
+// Eje principal de los colores del bloque (iteracion de potencia sobre la covarianza)
+glm::vec4 principalAxis(const glm::vec4 block[16], const glm::vec4& mean, int channels)
+{
+    float cov[4][4] = {};
+    for (int i = 0; i < 16; i++)
+    {
+        glm::vec4 d = block[i] - mean;
+        for (int a = 0; a < channels; a++)
+            for (int b = 0; b < channels; b++)
+                cov[a][b] += d[a] * d[b];
+    }
+    glm::vec4 axis(1.0f, 1.0f, 1.0f, channels > 3 ? 1.0f : 0.0f);
+    for (int iteration = 0; iteration < 8; iteration++)
+    {
+        glm::vec4 next(0.0f);
+        for (int a = 0; a < channels; a++)
+            for (int b = 0; b < channels; b++)
+                next[a] += cov[a][b] * axis[b];
+        float length = glm::length(next);
+        if (length < 1e-6f)
+            break;
+        axis = next / length;
+    }
+    return axis;
+}
+
+// Extremos iniciales: los colores del bloque proyectados sobre el eje principal
+void fitEndpoints(const glm::vec4 block[16], int channels, glm::vec4& e0, glm::vec4& e1)
+{
+    glm::vec4 mean(0.0f);
+    for (int i = 0; i < 16; i++)
+        mean += block[i];
+    mean /= 16.0f;
+    glm::vec4 axis = principalAxis(block, mean, channels);
+    float minT = 0.0f, maxT = 0.0f;
+    for (int i = 0; i < 16; i++)
+    {
+        float t = glm::dot(block[i] - mean, axis);
+        minT = std::min(minT, t);
+        maxT = std::max(maxT, t);
+    }
+    e0 = glm::clamp(mean + axis * maxT, 0.0f, 255.0f);
+    e1 = glm::clamp(mean + axis * minT, 0.0f, 255.0f);
+}
+
+// Minimos cuadrados: los extremos que mejor reproducen el bloque con los pesos ya elegidos
+// (weight = cuanto de e1 lleva cada pixel). Devuelve false si el sistema es singular.
+bool refineEndpoints(const glm::vec4 block[16], const float weight[16], glm::vec4& e0, glm::vec4& e1)
+{
+    float aa = 0.0f, ab = 0.0f, bb = 0.0f;
+    glm::vec4 ax(0.0f), bx(0.0f);
+    for (int i = 0; i < 16; i++)
+    {
+        float a = 1.0f - weight[i], b = weight[i];
+        aa += a * a;
+        ab += a * b;
+        bb += b * b;
+        ax += a * block[i];
+        bx += b * block[i];
+    }
+    float det = aa * bb - ab * ab;
+    if (std::fabs(det) < 1e-6f)
+        return false;
+    e0 = glm::clamp((ax * bb - bx * ab) / det, 0.0f, 255.0f);
+    e1 = glm::clamp((bx * aa - ax * ab) / det, 0.0f, 255.0f);
+    return true;
+}
+
+struct BitWriter
+{
+    unsigned char* bytes;
+    int position = 0;
+
+    explicit BitWriter(unsigned char* bytes) : bytes(bytes) {}
+
+    void put(uint32_t value, int bits)
+    {
+        for (int i = 0; i < bits; i++, position++)
+            if (value & (1u << i))
+                bytes[position / 8] |= (unsigned char)(1 << (position % 8));
+    }
+};
+
+uint16_t pack565(const glm::vec4& color)
+{
+    int r = (int)std::lround(color.x * 31.0f / 255.0f);
+    int g = (int)std::lround(color.y * 63.0f / 255.0f);
+    int b = (int)std::lround(color.z * 31.0f / 255.0f);
+    return (uint16_t)((r << 11) | (g << 5) | b);
+}
+
+glm::vec4 unpack565(uint16_t c)
+{
+    int r = (c >> 11) & 31, g = (c >> 5) & 63, b = c & 31;
+    return glm::vec4((float)((r << 3) | (r >> 2)), (float)((g << 2) | (g >> 4)), (float)((b << 3) | (b >> 2)), 255.0f);
+}
+
+float colorError(const glm::vec4& a, const glm::vec4& b)
+{
+    glm::vec3 d = glm::vec3(a) - glm::vec3(b);
+    return glm::dot(d, d);
+}
+
+// Un intento de BC1 con unos extremos dados; devuelve el error del bloque
+float encodeBC1Try(const glm::vec4 block[16], const glm::vec4& e0, const glm::vec4& e1, unsigned char out[8], float weight[16])
+{
+    uint16_t c0 = pack565(e0), c1 = pack565(e1);
+    if (c0 < c1)
+        std::swap(c0, c1);
+    glm::vec4 palette[4] = { unpack565(c0), unpack565(c1), glm::vec4(0.0f), glm::vec4(0.0f) };
+    palette[2] = (2.0f * palette[0] + palette[1]) / 3.0f;
+    palette[3] = (palette[0] + 2.0f * palette[1]) / 3.0f;
+    static const float paletteWeight[4] = { 0.0f, 1.0f, 1.0f / 3.0f, 2.0f / 3.0f };
+
+    uint32_t indices = 0;
+    float error = 0.0f;
+    for (int i = 0; i < 16; i++)
+    {
+        int best = 0;
+        float bestError = colorError(block[i], palette[0]);
+        for (int p = 1; p < 4 && c0 != c1; p++)
+        {
+            float e = colorError(block[i], palette[p]);
+            if (e < bestError)
+            {
+                bestError = e;
+                best = p;
+            }
+        }
+        indices |= (uint32_t)best << (2 * i);
+        weight[i] = paletteWeight[best];
+        error += bestError;
+    }
+    out[0] = c0 & 0xFF;
+    out[1] = c0 >> 8;
+    out[2] = c1 & 0xFF;
+    out[3] = c1 >> 8;
+    for (int i = 0; i < 4; i++)
+        out[4 + i] = (indices >> (8 * i)) & 0xFF;
+    return error;
+}
+
+// BC1 en modo de 4 colores (c0 > c1); tambien es el bloque de color de BC3
+void encodeBC1(const glm::vec4 block[16], unsigned char out[8])
+{
+    glm::vec4 e0, e1;
+    fitEndpoints(block, 3, e0, e1);
+    float weight[16];
+    float error = encodeBC1Try(block, e0, e1, out, weight);
+
+    // Los pesos salen del orden de c0/c1 ya empaquetados: los extremos refinados van en ese orden
+    glm::vec4 p0 = unpack565((uint16_t)(out[0] | (out[1] << 8))), p1 = unpack565((uint16_t)(out[2] | (out[3] << 8)));
+    if (refineEndpoints(block, weight, p0, p1))
+    {
+        unsigned char refined[8];
+        float refinedWeight[16];
+        if (encodeBC1Try(block, p0, p1, refined, refinedWeight) < error)
+            std::memcpy(out, refined, 8);
+    }
+}
+
+// BC4: un canal con 8 niveles entre max y min (tambien el alfa de BC3 y cada canal de BC5)
+void encodeBC4(const glm::vec4 block[16], int channel, unsigned char out[8])
+{
+    float values[16];
+    float minValue = 255.0f, maxValue = 0.0f;
+    for (int i = 0; i < 16; i++)
+    {
+        values[i] = block[i][channel];
+        minValue = std::min(minValue, values[i]);
+        maxValue = std::max(maxValue, values[i]);
+    }
+    int a0 = (int)std::lround(maxValue), a1 = (int)std::lround(minValue);
+    std::memset(out, 0, 8);
+    out[0] = (unsigned char)a0;
+    out[1] = (unsigned char)a1;
+    if (a0 == a1)
+        return;
+
+    float palette[8] = { (float)a0, (float)a1 };
+    for (int i = 2; i < 8; i++)
+        palette[i] = ((8 - i) * a0 + (i - 1) * a1) / 7.0f;
+    uint64_t indices = 0;
+    for (int i = 0; i < 16; i++)
+    {
+        int best = 0;
+        for (int p = 1; p < 8; p++)
+            if (std::fabs(values[i] - palette[p]) < std::fabs(values[i] - palette[best]))
+                best = p;
+        indices |= (uint64_t)best << (3 * i);
+    }
+    for (int i = 0; i < 6; i++)
+        out[2 + i] = (indices >> (8 * i)) & 0xFF;
+}
+
+// BC7 modo 6: un subconjunto, extremos RGBA de 7 bits con un p-bit cada uno e indices de 4 bits
+void quantizeBC7Endpoint(const glm::vec4& endpoint, int q[4], int& pbit)
+{
+    float bestError = 1e30f;
+    for (int p = 0; p < 2; p++)
+    {
+        int candidate[4];
+        float error = 0.0f;
+        for (int c = 0; c < 4; c++)
+        {
+            candidate[c] = std::min(127, std::max(0, (int)std::lround((endpoint[c] - p) / 2.0f)));
+            float value = (float)(candidate[c] * 2 + p);
+            error += (value - endpoint[c]) * (value - endpoint[c]);
+        }
+        if (error < bestError)
+        {
+            bestError = error;
+            pbit = p;
+            std::copy(candidate, candidate + 4, q);
+        }
+    }
+}
+
+float encodeBC7Try(const glm::vec4 block[16], const glm::vec4& e0, const glm::vec4& e1, unsigned char out[16], float weight[16])
+{
+    static const int weights[16] = { 0, 4, 9, 13, 17, 21, 26, 30, 34, 38, 43, 47, 51, 55, 60, 64 };
+    int q[2][4], p[2];
+    quantizeBC7Endpoint(e0, q[0], p[0]);
+    quantizeBC7Endpoint(e1, q[1], p[1]);
+    glm::vec4 endpoint[2];
+    for (int e = 0; e < 2; e++)
+        for (int c = 0; c < 4; c++)
+            endpoint[e][c] = (float)(q[e][c] * 2 + p[e]);
+    glm::vec4 palette[16];
+    for (int i = 0; i < 16; i++)
+        for (int c = 0; c < 4; c++)
+            palette[i][c] = (float)(((64 - weights[i]) * (int)endpoint[0][c] + weights[i] * (int)endpoint[1][c] + 32) >> 6);
+
+    int indices[16];
+    float error = 0.0f;
+    for (int i = 0; i < 16; i++)
+    {
+        int best = 0;
+        float bestError = 1e30f;
+        for (int k = 0; k < 16; k++)
+        {
+            glm::vec4 d = block[i] - palette[k];
+            float e = glm::dot(d, d);
+            if (e < bestError)
+            {
+                bestError = e;
+                best = k;
+            }
+        }
+        indices[i] = best;
+        weight[i] = weights[best] / 64.0f;
+        error += bestError;
+    }
+
+    // El indice del primer pixel guarda solo 3 bits: tiene que ser < 8, si no se cambian los extremos
+    if (indices[0] >= 8)
+    {
+        for (int c = 0; c < 4; c++)
+            std::swap(q[0][c], q[1][c]);
+        std::swap(p[0], p[1]);
+        for (int i = 0; i < 16; i++)
+            indices[i] = 15 - indices[i];
+    }
+
+    std::memset(out, 0, 16);
+    BitWriter bits(out);
+    bits.put(1 << 6, 7);   // modo 6
+    for (int c = 0; c < 4; c++)
+    {
+        bits.put(q[0][c], 7);
+        bits.put(q[1][c], 7);
+    }
+    bits.put(p[0], 1);
+    bits.put(p[1], 1);
+    bits.put(indices[0], 3);
+    for (int i = 1; i < 16; i++)
+        bits.put(indices[i], 4);
+    return error;
+}
+
+void encodeBC7(const glm::vec4 block[16], unsigned char out[16])
+{
+    glm::vec4 e0, e1;
+    fitEndpoints(block, 4, e0, e1);
+    float weight[16];
+    float error = encodeBC7Try(block, e0, e1, out, weight);
+    // Si se cambiaron los extremos los pesos ya estan en el orden de e0/e1 originales
+    if (refineEndpoints(block, weight, e0, e1))
+    {
+        unsigned char refined[16];
+        float refinedWeight[16];
+        if (encodeBC7Try(block, e0, e1, refined, refinedWeight) < error)
+            std::memcpy(out, refined, 16);
+    }
+}
+
+std::vector<unsigned char> encodeLevel(const Pixels& pixels, int width, int height, GLenum format)
+{
+    std::vector<unsigned char> data(compressedLevelBytes(format, width, height));
+    unsigned int blockBytes = compressedBlockBytes(format);
+    int blocksX = (width + 3) / 4, blocksY = (height + 3) / 4;
+    glm::vec4 block[16];
+    for (int by = 0; by < blocksY; by++)
+    {
+        for (int bx = 0; bx < blocksX; bx++)
+        {
+            unsigned char* out = &data[((size_t)by * blocksX + bx) * blockBytes];
+            fetchBlock(pixels, width, height, bx, by, block);
+            switch (format)
+            {
+            case GL_COMPRESSED_RGB_S3TC_DXT1_EXT: encodeBC1(block, out); break;
+            case GL_COMPRESSED_RGBA_S3TC_DXT5_EXT: encodeBC4(block, 3, out); encodeBC1(block, out + 8); break;
+            case GL_COMPRESSED_RED_RGTC1: encodeBC4(block, 0, out); break;
+            case GL_COMPRESSED_RG_RGTC2: encodeBC4(block, 0, out); encodeBC4(block, 1, out + 8); break;
+            case GL_COMPRESSED_RGBA_BPTC_UNORM: encodeBC7(block, out); break;
+            default: break;
+            }
+        }
+    }
+    return data;
+}
+
+// ---------------------------------------------------------------------------------------------
+
+void cook(CookJob& job, bool useBC7)
+{
+    int channels = 0;
+    unsigned char* data = stbi_load(job.path.c_str(), &job.width, &job.height, &channels, 4);
+    if (!data)
+    {
+        std::cout << "COOKER::No se pudo cargar " << job.path << std::endl;
+        return;
+    }
+    Pixels pixels((size_t)job.width * job.height);
+    bool hasAlpha = false, grayscale = true;
+    for (size_t i = 0; i < pixels.size(); i++)
+    {
+        const unsigned char* p = data + i * 4;
+        pixels[i] = glm::vec4(p[0], p[1], p[2], p[3]);
+        hasAlpha |= p[3] < 255;
+        grayscale &= p[0] == p[1] && p[1] == p[2];
+    }
+    stbi_image_free(data);
+
+    if (job.usage == USAGE_AUTO)
+        job.usage = usageFromName(job.path);
+    KtxImage image;
+    image.width = job.width;
+    image.height = job.height;
+    if (job.usage == USAGE_NORMAL)
+    {
+        image.internalFormat = GL_COMPRESSED_RG_RGTC2;
+        image.baseFormat = GL_RG;
+    }
+    else if (job.usage == USAGE_MASK && grayscale)
+    {
+        image.internalFormat = GL_COMPRESSED_RED_RGTC1;
+        image.baseFormat = GL_RED;
+    }
+    else
+    {
+        image.internalFormat = useBC7 ? GL_COMPRESSED_RGBA_BPTC_UNORM : hasAlpha ? GL_COMPRESSED_RGBA_S3TC_DXT5_EXT : GL_COMPRESSED_RGB_S3TC_DXT1_EXT;
+        image.baseFormat = hasAlpha ? GL_RGBA : GL_RGB;
+    }
+
+    // Lo que ocupaba antes: learnopengl sube 1 canal como GL_RED, 3 como GL_RGB y 4 como GL_RGBA, con mips
+    size_t sourceChannels = channels == 1 ? 1 : channels == 4 ? 4 : 3;
+    int width = job.width, height = job.height;
+    for (;;)
+    {
+        image.levels.push_back(encodeLevel(pixels, width, height, image.internalFormat));
+        job.sourceBytes += (size_t)width * height * sourceChannels;
+        job.cookedBytes += image.levels.back().size();
+        if (width == 1 && height == 1)
+            break;
+        pixels = downsample(pixels, width, height, job.usage == USAGE_NORMAL);
+        width = std::max(1, width / 2);
+        height = std::max(1, height / 2);
+    }
+
+    job.format = image.internalFormat;
+    job.ok = writeKtx(cookedTexturePath(job.path), image);
+    if (!job.ok)
+        std::cout << "COOKER::No se pudo escribir " << cookedTexturePath(job.path) << std::endl;
+}
+
+int main(int argc, char** argv)
+{
+    bool useBC7 = false;
+    TextureUsage usage = USAGE_AUTO;
+    std::vector<CookJob> jobs;
+    for (int i = 1; i < argc; i++)
+    {
+        std::string arg = argv[i];
+        if (arg == "--bc7")
+            useBC7 = true;
+        else if (arg == "--color")
+            usage = USAGE_COLOR;
+        else if (arg == "--normal")
+            usage = USAGE_NORMAL;
+        else if (arg == "--mask")
+            usage = USAGE_MASK;
+        else if (arg == "--auto")
+            usage = USAGE_AUTO;
+        else
+        {
+            CookJob job;
+            job.path = arg;
+            job.usage = usage;
+            jobs.push_back(job);
+        }
+    }
+    if (jobs.empty())
+    {
+        std::cout << "Uso: TextureCooker [--bc7] [--color|--normal|--mask|--auto] archivos..." << std::endl;
+        return -1;
+    }
+
+    auto start = std::chrono::steady_clock::now();
+    std::atomic<size_t> nextJob(0);
+    auto worker = [&]() {
+        for (size_t job = nextJob++; job < jobs.size(); job = nextJob++)
+            cook(jobs[job], useBC7);
+    };
+    unsigned int threadCount = std::max(1u, std::min(std::thread::hardware_concurrency(), (unsigned int)jobs.size()));
+    std::vector<std::thread> threads;
+    for (unsigned int i = 0; i < threadCount; i++)
+        threads.emplace_back(worker);
+    for (std::thread& thread : threads)
+        thread.join();
+    float seconds = std::chrono::duration<float>(std::chrono::steady_clock::now() - start).count();
+
+    size_t sourceTotal = 0, cookedTotal = 0;
+    unsigned int failed = 0;
+    for (const CookJob& job : jobs)
+    {
+        if (!job.ok)
+        {
+            failed++;
+            continue;
+        }
+        sourceTotal += job.sourceBytes;
+        cookedTotal += job.cookedBytes;
+        std::cout << "COOKER::" << job.path << " " << job.width << "x" << job.height << " " << usageName(job.usage) << " -> "
+                  << compressedFormatName(job.format) << ", " << job.cookedBytes / 1024 << " KB (x"
+                  << (float)job.sourceBytes / job.cookedBytes << ")" << std::endl;
+    }
+    std::cout << "COOKER::" << jobs.size() - failed << " texturas, VRAM " << sourceTotal / 1024 << " KB -> " << cookedTotal / 1024
+              << " KB (x" << (cookedTotal ? (float)sourceTotal / cookedTotal : 0.0f) << ") en " << seconds << " s con "
+              << threadCount << " hilos" << std::endl;
+    if (failed)
+        std::cout << "COOKER::" << failed << " texturas con errores" << std::endl;
+    return failed ? -1 : 0;
+}
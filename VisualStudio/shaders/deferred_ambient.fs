@@ -0,0 +1,11 @@
+#version 330 core
+out vec4 FragColor;
+
+uniform sampler2D gAlbedoRoughness;
+uniform float ambient;
+
+void main()
+{
+    vec3 albedo = texelFetch(gAlbedoRoughness, ivec2(gl_FragCoord.xy), 0).rgb;
+    FragColor = vec4(ambient * albedo, 1.0);
+}
\ No newline at end of file
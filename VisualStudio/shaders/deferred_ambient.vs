@@ -0,0 +1,7 @@
+#version 330 core
+// Triangulo de pantalla completa sin buffers (gl_VertexID 0..2)
+void main()
+{
+    vec2 position = vec2((gl_VertexID << 1) & 2, gl_VertexID & 2);
+    gl_Position = vec4(position * 2.0 - 1.0, 0.0, 1.0);
+}
\ No newline at end of file
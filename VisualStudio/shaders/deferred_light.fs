@@ -0,0 +1,59 @@
+#version 330 core
+out vec4 FragColor;
+
+uniform sampler2D gAlbedoRoughness;
+uniform sampler2D gNormal;
+uniform sampler2D gDepth;
+
+uniform mat4 inverseViewProjection;
+uniform vec2 screenSize;
+uniform vec3 viewPos;
+uniform vec3 lightColor;
+
+uniform vec3 lightPosition;
+uniform vec3 lightTint;
+uniform float lightRange;
+
+// Atenuacion de las luces puntuales
+uniform float constant;
+uniform float linear;
+uniform float quadratic;
+
+vec3 decodeNormal(vec2 f)
+{
+    vec3 n = vec3(f, 1.0 - abs(f.x) - abs(f.y));
+    float t = clamp(-n.z, 0.0, 1.0);
+    n.xy += vec2(n.x >= 0.0 ? -t : t, n.y >= 0.0 ? -t : t);
+    return normalize(n);
+}
+
+void main()
+{
+    ivec2 pixel = ivec2(gl_FragCoord.xy);
+    float depth = texelFetch(gDepth, pixel, 0).r;
+    vec4 albedoRoughness = texelFetch(gAlbedoRoughness, pixel, 0);
+    vec3 normal = decodeNormal(texelFetch(gNormal, pixel, 0).xy);
+
+    // Posicion en mundo a partir de la profundidad
+    vec4 ndc = vec4(gl_FragCoord.xy / screenSize * 2.0 - 1.0, depth * 2.0 - 1.0, 1.0);
+    vec4 world = inverseViewProjection * ndc;
+    vec3 fragPos = world.xyz / world.w;
+
+    vec3 toLight = lightPosition - fragPos;
+    float distance = length(toLight);
+    if (distance > lightRange)
+        discard;
+
+    vec3 lightDir = toLight / distance;
+    vec3 viewDir = normalize(viewPos - fragPos);
+    float diff = max(dot(normal, lightDir), 0.0);
+    vec3 halfwayDir = normalize(lightDir + viewDir);
+    float shininess = mix(128.0, 4.0, albedoRoughness.a);
+    float spec = pow(max(dot(normal, halfwayDir), 0.0), shininess);
+
+    float attenuation = 1.0 / (constant + linear * distance + quadratic * (distance * distance));
+    float window = clamp(1.0 - pow(distance / lightRange, 4.0), 0.0, 1.0);
+    attenuation *= window * window;
+
+    FragColor = vec4((diff * albedoRoughness.rgb + 0.2 * spec) * lightTint * lightColor * attenuation, 1.0);
+}
\ No newline at end of file
@@ -3,16 +3,24 @@ out vec4 FragColor;
 
 in vec2 TexCoords;
 
+// Solo se declaran y leen las texturas que usa el material; con shader_variants.h se activan
+// insertando los #define (sin ninguno queda la lectura de la difusa y nada mas)
 uniform sampler2D diffuseTexture;   // Textura difusa
-uniform sampler2D normalTexture;    // Textura normal (bump map)
-uniform sampler2D specularTexture;  // Textura especular (opcional)
+#ifdef EMISSIVE_MAP
+uniform sampler2D emissiveTexture;  // Textura emisiva (opcional)
+#endif
 
 void main()
 {
     vec4 diffuse = texture(diffuseTexture, TexCoords);
-    vec4 normal = texture(normalTexture, TexCoords); // Usado solo si es necesario
-    vec4 specular = texture(specularTexture, TexCoords); // Usado solo si es necesario
+#ifdef ALPHA_TEST
+    if (diffuse.a < 0.5)
+        discard;
+#endif
+#ifdef EMISSIVE_MAP
+    diffuse.rgb += texture(emissiveTexture, TexCoords).rgb;
+#endif
 
-    // Aqu solo se utiliza la textura difusa
+    // Este shader no ilumina: las texturas normal y especular no se leen
     FragColor = diffuse;
 }
\ No newline at end of file
@@ -0,0 +1,70 @@
+#version 330 core
+layout (location = 0) out vec4 gAlbedoRoughness;
+layout (location = 1) out vec2 gNormal;
+
+in vec3 FragPos;
+in vec3 Normal;
+in vec2 TexCoords;
+flat in float Layer;
+
+// Mismas variantes que house_static.fs (ver shader_variants.h). La emision no cabe en el G-buffer:
+// esos materiales se dibujan en forward (ver StaticGeometry::submit)
+#ifdef TEXTURE_ARRAY
+uniform sampler2DArray array_diffuse1;
+#else
+uniform sampler2D texture_diffuse1;
+#endif
+#ifdef NORMAL_MAP
+in mat3 TBN;
+uniform sampler2D texture_normal1;
+#endif
+#ifdef SPECULAR_MAP
+uniform sampler2D texture_specular1;
+#endif
+#ifdef METALLIC_ROUGHNESS
+uniform sampler2D texture_metallicRoughness1;
+#endif
+
+uniform float roughness;   // sin mapa especular ni de rugosidad
+
+// Normal unitaria -> octaedro [-1,1]^2
+vec2 octWrap(vec2 v)
+{
+    return (1.0 - abs(v.yx)) * vec2(v.x >= 0.0 ? 1.0 : -1.0, v.y >= 0.0 ? 1.0 : -1.0);
+}
+
+vec2 encodeNormal(vec3 n)
+{
+    n /= abs(n.x) + abs(n.y) + abs(n.z);
+    return n.z >= 0.0 ? n.xy : octWrap(n.xy);
+}
+
+void main()
+{
+#ifdef TEXTURE_ARRAY
+    vec4 diffuse = texture(array_diffuse1, vec3(TexCoords, Layer));
+#else
+    vec4 diffuse = texture(texture_diffuse1, TexCoords);
+#endif
+#ifdef ALPHA_TEST
+    if (diffuse.a < 0.5)
+        discard;
+#endif
+#ifdef NORMAL_MAP
+    // Solo X e Y: las texturas cocinadas en BC5 no tienen Z (ver TextureCooker)
+    vec2 tangentXY = texture(texture_normal1, TexCoords).rg * 2.0 - 1.0;
+    vec3 tangentNormal = vec3(tangentXY, sqrt(max(1.0 - dot(tangentXY, tangentXY), 0.0)));
+    vec3 normal = normalize(TBN * tangentNormal);
+#else
+    vec3 normal = normalize(Normal);
+#endif
+#ifdef SPECULAR_MAP
+    float materialRoughness = 1.0 - texture(texture_specular1, TexCoords).r;
+#elif defined(METALLIC_ROUGHNESS)
+    float materialRoughness = texture(texture_metallicRoughness1, TexCoords).g;
+#else
+    float materialRoughness = roughness;
+#endif
+    gAlbedoRoughness = vec4(diffuse.rgb, materialRoughness);
+    gNormal = encodeNormal(normal);
+}
\ No newline at end of file
@@ -0,0 +1,151 @@
+#version 330 core
+out vec4 FragColor;
+
+in vec3 FragPos;
+in vec3 Normal;
+in vec2 TexCoords;
+flat in float Layer;
+
+// Variantes (ver shader_variants.h): solo se declaran y leen las texturas que tiene el material
+#ifdef TEXTURE_ARRAY
+// Textura difusa de todos los meshes que comparten array; la capa viene del vertice
+uniform sampler2DArray array_diffuse1;
+#else
+uniform sampler2D texture_diffuse1;
+#endif
+#ifdef NORMAL_MAP
+in mat3 TBN;
+uniform sampler2D texture_normal1;
+#endif
+#ifdef SPECULAR_MAP
+uniform sampler2D texture_specular1;
+#endif
+#ifdef EMISSIVE_MAP
+uniform sampler2D texture_emissive1;
+#endif
+#ifdef METALLIC_ROUGHNESS
+uniform sampler2D texture_metallicRoughness1;
+#endif
+
+uniform vec3 viewPos;
+uniform vec3 lightColor;   // se multiplica por el color de cada luz
+uniform mat4 view;
+
+// Atenuacion de las luces puntuales
+uniform float constant;
+uniform float linear;
+uniform float quadratic;
+
+// Iluminacion por clusters (ver clustered_lighting.h)
+uniform samplerBuffer lightData;      // 2 texels por luz: (posicion, alcance), (color, slot de sombra)
+uniform usamplerBuffer clusterData;   // por cluster: (primer indice, numero de luces)
+uniform usamplerBuffer lightIndices;
+uniform uvec3 clusterGrid;            // tiles en x, tiles en y, cortes en profundidad
+uniform vec2 screenSize;
+uniform float zNear;
+uniform float sliceScale;             // cortes / log(zFar / zNear)
+
+// Atlas de sombras de las luces puntuales (ver shadow_atlas.h): 6 caras por luz
+uniform sampler2D shadowAtlas;
+uniform mat4 shadowFaces[6];          // +X, -X, +Y, -Y, +Z, -Z
+uniform float shadowTilesPerRow;
+uniform float shadowTileScale;        // 1 / shadowTilesPerRow
+uniform float shadowTexel;            // 1 / tamano de la cara
+uniform float shadowBias;             // en metros, no depende del alcance
+
+float shadowFactor(int slot, vec3 lightPos, float range)
+{
+    vec3 d = FragPos - lightPos;
+    vec3 a = abs(d);
+    int face;
+    if (a.x >= a.y && a.x >= a.z)
+        face = d.x >= 0.0 ? 0 : 1;
+    else if (a.y >= a.z)
+        face = d.y >= 0.0 ? 2 : 3;
+    else
+        face = d.z >= 0.0 ? 4 : 5;
+
+    vec4 clip = shadowFaces[face] * vec4(d, 1.0);
+    vec2 uv = clamp(clip.xy / clip.w * 0.5 + 0.5, vec2(0.5 * shadowTexel), vec2(1.0 - 0.5 * shadowTexel));
+    float tile = float(slot * 6 + face);
+    vec2 origin = vec2(mod(tile, shadowTilesPerRow), floor(tile / shadowTilesPerRow));
+    float stored = texture(shadowAtlas, (origin + uv) * shadowTileScale).r;
+    // Una cara de 90 grados mide 2 * distancia: a eso se suma lo que ocupa un texel a esa distancia
+    float distance = length(d);
+    float bias = shadowBias + 2.0 * distance * shadowTexel;
+    return (distance - bias) / range > stored ? 0.0 : 1.0;
+}
+
+vec3 pointLight(vec3 lightPos, float range, vec3 color, int shadow, vec3 normal, vec3 viewDir, vec3 albedo, float specularStrength)
+{
+    vec3 lightDir = normalize(lightPos - FragPos);
+    float diff = max(dot(normal, lightDir), 0.0);
+    vec3 halfwayDir = normalize(lightDir + viewDir);
+    float spec = pow(max(dot(normal, halfwayDir), 0.0), 32.0);
+
+    float distance = length(lightPos - FragPos);
+    float attenuation = 1.0 / (constant + linear * distance + quadratic * (distance * distance));
+    // Llega a cero en el alcance usado para asignar la luz a los clusters
+    float window = clamp(1.0 - pow(distance / range, 4.0), 0.0, 1.0);
+    attenuation *= window * window;
+    if (shadow >= 0)
+        attenuation *= shadowFactor(shadow, lightPos, range);
+
+    return (diff * albedo + specularStrength * spec) * color * lightColor * attenuation;
+}
+
+uint clusterIndex()
+{
+    float viewDepth = -(view * vec4(FragPos, 1.0)).z;
+    uvec3 cell;
+    cell.xy = uvec2(gl_FragCoord.xy / screenSize * vec2(clusterGrid.xy));
+    cell.z = uint(max(log(viewDepth / zNear) * sliceScale, 0.0));
+    cell = min(cell, clusterGrid - uvec3(1u));
+    return cell.x + clusterGrid.x * (cell.y + clusterGrid.y * cell.z);
+}
+
+void main()
+{
+#ifdef TEXTURE_ARRAY
+    vec4 diffuse = texture(array_diffuse1, vec3(TexCoords, Layer));
+#else
+    vec4 diffuse = texture(texture_diffuse1, TexCoords);
+#endif
+#ifdef ALPHA_TEST
+    if (diffuse.a < 0.5)
+        discard;
+#endif
+#ifdef NORMAL_MAP
+    // Solo X e Y: las texturas cocinadas en BC5 no tienen Z (ver TextureCooker)
+    vec2 tangentXY = texture(texture_normal1, TexCoords).rg * 2.0 - 1.0;
+    vec3 tangentNormal = vec3(tangentXY, sqrt(max(1.0 - dot(tangentXY, tangentXY), 0.0)));
+    vec3 normal = normalize(TBN * tangentNormal);
+#else
+    vec3 normal = normalize(Normal);
+#endif
+#ifdef SPECULAR_MAP
+    float specularStrength = texture(texture_specular1, TexCoords).r;
+#elif defined(METALLIC_ROUGHNESS)
+    // Aproximacion para Blinn-Phong: menos brillo cuanto mas rugoso, mas si es metalico
+    vec2 roughnessMetallic = texture(texture_metallicRoughness1, TexCoords).gb;
+    float specularStrength = (1.0 - roughnessMetallic.x) * mix(0.2, 1.0, roughnessMetallic.y);
+#else
+    float specularStrength = 0.2;
+#endif
+    vec3 viewDir = normalize(viewPos - FragPos);
+
+    vec3 result = 0.1 * diffuse.rgb;   // luz ambiente
+#ifdef EMISSIVE_MAP
+    result += texture(texture_emissive1, TexCoords).rgb;
+#endif
+    uvec2 cluster = texelFetch(clusterData, int(clusterIndex())).xy;
+    for (uint i = 0u; i < cluster.y; i++)
+    {
+        int light = int(texelFetch(lightIndices, int(cluster.x + i)).r);
+        vec4 positionRange = texelFetch(lightData, light * 2);
+        vec4 colorShadow = texelFetch(lightData, light * 2 + 1);
+        result += pointLight(positionRange.xyz, positionRange.w, colorShadow.rgb, int(colorShadow.a), normal, viewDir, diffuse.rgb, specularStrength);
+    }
+
+    FragColor = vec4(result, diffuse.a);
+}
\ No newline at end of file
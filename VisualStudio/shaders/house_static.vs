@@ -0,0 +1,35 @@
+#version 330 core
+layout (location = 0) in vec3 aPos;
+layout (location = 1) in vec3 aNormal;
+layout (location = 2) in vec2 aTexCoords;
+layout (location = 3) in vec4 aTangent;     // w = 1 si viene de un Mesh (vec3); en glTF es el signo de la bitangente
+layout (location = 4) in vec3 aBitangent;   // los glTF no la tienen: queda a cero y se calcula
+layout (location = 5) in float aLayer;   // capa del array de texturas
+
+// Los #define de las variantes (TEXTURE_ARRAY, NORMAL_MAP, ...) los inserta shader_variants.h
+
+out vec3 FragPos;
+out vec3 Normal;
+out vec2 TexCoords;
+flat out float Layer;
+#ifdef NORMAL_MAP
+out mat3 TBN;
+#endif
+
+uniform mat4 model;
+uniform mat4 view;
+uniform mat4 projection;
+
+void main()
+{
+    FragPos = vec3(model * vec4(aPos, 1.0));
+    mat3 normalMatrix = mat3(transpose(inverse(model)));
+    Normal = normalMatrix * aNormal;
+#ifdef NORMAL_MAP
+    vec3 bitangent = dot(aBitangent, aBitangent) > 0.0 ? aBitangent : cross(aNormal, aTangent.xyz) * aTangent.w;
+    TBN = mat3(normalize(normalMatrix * aTangent.xyz), normalize(normalMatrix * bitangent), normalize(Normal));
+#endif
+    TexCoords = aTexCoords;
+    Layer = aLayer;
+    gl_Position = projection * view * vec4(FragPos, 1.0);
+}
\ No newline at end of file
@@ -0,0 +1,8 @@
+#version 330 core
+out vec4 FragColor;
+
+void main()
+{
+    // No escribe color (glColorMask desactivado), solo cuenta muestras
+    FragColor = vec4(1.0);
+}
\ No newline at end of file
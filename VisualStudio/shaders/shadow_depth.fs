@@ -0,0 +1,11 @@
+#version 330 core
+in vec3 WorldPos;
+
+uniform vec3 lightPos;
+uniform float range;
+
+void main()
+{
+    // Distancia lineal a la luz en [0,1]
+    gl_FragDepth = clamp(length(WorldPos - lightPos) / range, 0.0, 1.0);
+}
\ No newline at end of file
@@ -0,0 +1,13 @@
+#version 330 core
+layout (location = 0) in vec3 aPos;
+
+out vec3 WorldPos;
+
+uniform mat4 model;
+uniform mat4 lightSpace;   // proyeccion de la cara * vista desde la luz
+
+void main()
+{
+    WorldPos = vec3(model * vec4(aPos, 1.0));
+    gl_Position = lightSpace * vec4(WorldPos, 1.0);
+}
\ No newline at end of file
@@ -0,0 +1,307 @@
+#ifndef ASYNC_LOGGER_H
+#define ASYNC_LOGGER_H
+
+#include <vector>
+#include <string>
+#include <sstream>
+#include <atomic>
+#include <thread>
+#include <chrono>
+#include <iostream>
+#include <cstdint>
+
+// Log asincrono para el bucle de render.
+//
+// El hilo que escribe no formatea ni toca la consola: copia un registro binario (categoria,
+// nivel, puntero al formato, hasta MAX_ARGS argumentos numericos o literales) en un anillo
+// acotado sin locks (cola MPMC de Vyukov con numero de secuencia por celda, usada con un solo
+// consumidor). Un hilo de fondo lee los registros, sustituye cada "{}" del formato por su
+// argumento y los escribe en std::cout, con un solo flush por lote.
+//  - Filtro de nivel por categoria, comprobado antes de encolar (un load atomico).
+//  - Limite de mensajes por segundo por categoria en el consumidor; lo que sobra se resume.
+//  - Si el anillo esta lleno el mensaje se descarta y se cuenta: el productor nunca espera.
+// Los argumentos de texto se guardan como puntero, asi que deben ser literales o tener vida
+// hasta que se escriban.
+enum LogCategory
+{
+    LOG_GENERAL = 0,
+    LOG_CAMERA,
+    LOG_CULLING,
+    LOG_RENDER,
+    LOG_PERF,
+    LOG_CATEGORY_COUNT
+};
+
+enum LogLevel
+{
+    LOG_DEBUG = 0,
+    LOG_INFO,
+    LOG_WARNING,
+    LOG_ERROR
+};
+
+struct LogArg
+{
+    enum Type : uint8_t { NONE, INT, UINT, DOUBLE, BOOL, STRING };
+
+    Type type = NONE;
+    union
+    {
+        int64_t i;
+        uint64_t u;
+        double d;
+        const char* s;
+    };
+
+    LogArg() : i(0) {}
+    LogArg(int v) : type(INT), i(v) {}
+    LogArg(long v) : type(INT), i(v) {}
+    LogArg(long long v) : type(INT), i(v) {}
+    LogArg(unsigned int v) : type(UINT), u(v) {}
+    LogArg(unsigned long v) : type(UINT), u(v) {}
+    LogArg(unsigned long long v) : type(UINT), u(v) {}
+    LogArg(float v) : type(DOUBLE), d(v) {}
+    LogArg(double v) : type(DOUBLE), d(v) {}
+    LogArg(bool v) : type(BOOL), u(v) {}
+    LogArg(const char* v) : type(STRING), s(v) {}
+};
+
+class AsyncLogger
+{
+public:
+    static const int MAX_ARGS = 8;
+    static const unsigned int CAPACITY = 4096;   // potencia de dos
+
+    static AsyncLogger& instance()
+    {
+        static AsyncLogger logger;
+        return logger;
+    }
+
+    void setLevel(LogCategory category, LogLevel level)
+    {
+        levels[category].store(level, std::memory_order_relaxed);
+    }
+
+    // 0 = sin limite
+    void setRateLimit(LogCategory category, unsigned int messagesPerSecond)
+    {
+        rateLimits[category].store(messagesPerSecond, std::memory_order_relaxed);
+    }
+
+    bool enabled(LogCategory category, LogLevel level) const
+    {
+        return level >= levels[category].load(std::memory_order_relaxed);
+    }
+
+    template <typename... Args>
+    void log(LogCategory category, LogLevel level, const char* format, const Args&... args)
+    {
+        static_assert(sizeof...(Args) <= MAX_ARGS, "Demasiados argumentos para un registro de log");
+        if (!enabled(category, level))
+            return;
+        const LogArg packed[] = { LogArg(args)..., LogArg() };
+        push(category, level, format, packed, (int)sizeof...(Args));
+    }
+
+    // Mensajes descartados por anillo lleno
+    uint64_t droppedCount() const { return dropped.load(std::memory_order_relaxed); }
+
+    // Espera a que se escriba todo lo encolado hasta ahora (antes de destruir lo que apuntan los
+    // argumentos de texto, o al terminar)
+    void flush()
+    {
+        uint64_t target = enqueuePos.load(std::memory_order_acquire);
+        while (writtenPos.load(std::memory_order_acquire) < target)
+            std::this_thread::sleep_for(std::chrono::milliseconds(1));
+    }
+
+private:
+    struct Cell
+    {
+        std::atomic<uint64_t> sequence;
+        uint8_t category;
+        uint8_t level;
+        uint8_t argCount;
+        const char* format;
+        int64_t time;
+        LogArg args[MAX_ARGS];
+    };
+
+    std::vector<Cell> cells;
+    std::atomic<uint64_t> enqueuePos{ 0 };
+    uint64_t dequeuePos = 0;
+    std::atomic<uint64_t> writtenPos{ 0 };   // dequeuePos para flush()
+    std::atomic<uint64_t> dropped{ 0 };
+    std::atomic<int> levels[LOG_CATEGORY_COUNT];
+    std::atomic<unsigned int> rateLimits[LOG_CATEGORY_COUNT];
+    std::atomic<bool> running{ true };
+    std::thread worker;
+
+    // Estado del consumidor
+    int64_t windowStart[LOG_CATEGORY_COUNT] = {};
+    unsigned int windowCount[LOG_CATEGORY_COUNT] = {};
+    unsigned int suppressed[LOG_CATEGORY_COUNT] = {};
+    uint64_t reportedDropped = 0;
+    std::ostringstream line;
+
+    AsyncLogger() : cells(CAPACITY)
+    {
+        for (unsigned int i = 0; i < CAPACITY; i++)
+            cells[i].sequence.store(i, std::memory_order_relaxed);
+        for (int c = 0; c < LOG_CATEGORY_COUNT; c++)
+        {
+            levels[c].store(LOG_INFO, std::memory_order_relaxed);
+            rateLimits[c].store(0, std::memory_order_relaxed);
+        }
+        worker = std::thread([this]() { run(); });
+    }
+
+    ~AsyncLogger()
+    {
+        running.store(false, std::memory_order_release);
+        worker.join();
+    }
+
+    AsyncLogger(const AsyncLogger&) = delete;
+    AsyncLogger& operator=(const AsyncLogger&) = delete;
+
+    static int64_t now()
+    {
+        return std::chrono::duration_cast<std::chrono::microseconds>(std::chrono::steady_clock::now().time_since_epoch()).count();
+    }
+
+    void push(LogCategory category, LogLevel level, const char* format, const LogArg* args, int argCount)
+    {
+        uint64_t pos = enqueuePos.load(std::memory_order_relaxed);
+        Cell* cell;
+        for (;;)
+        {
+            cell = &cells[pos & (CAPACITY - 1)];
+            uint64_t sequence = cell->sequence.load(std::memory_order_acquire);
+            int64_t diff = (int64_t)sequence - (int64_t)pos;
+            if (diff == 0)
+            {
+                if (enqueuePos.compare_exchange_weak(pos, pos + 1, std::memory_order_relaxed))
+                    break;
+            }
+            else if (diff < 0)
+            {
+                dropped.fetch_add(1, std::memory_order_relaxed);
+                return;
+            }
+            else
+            {
+                pos = enqueuePos.load(std::memory_order_relaxed);
+            }
+        }
+        cell->category = (uint8_t)category;
+        cell->level = (uint8_t)level;
+        cell->argCount = (uint8_t)argCount;
+        cell->format = format;
+        cell->time = now();
+        for (int i = 0; i < argCount; i++)
+            cell->args[i] = args[i];
+        cell->sequence.store(pos + 1, std::memory_order_release);
+    }
+
+    void run()
+    {
+        for (;;)
+        {
+            bool stop = !running.load(std::memory_order_acquire);
+            if (drain())
+                std::cout.flush();
+            if (stop)
+                break;
+            std::this_thread::sleep_for(std::chrono::milliseconds(2));
+        }
+    }
+
+    // Escribe todo lo encolado; devuelve si escribio algo
+    bool drain()
+    {
+        bool wrote = false;
+        for (;;)
+        {
+            Cell& cell = cells[dequeuePos & (CAPACITY - 1)];
+            if (cell.sequence.load(std::memory_order_acquire) != dequeuePos + 1)
+                break;
+            wrote |= write(cell);
+            cell.sequence.store(dequeuePos + CAPACITY, std::memory_order_release);
+            dequeuePos++;
+        }
+        writtenPos.store(dequeuePos, std::memory_order_release);
+
+        uint64_t droppedNow = dropped.load(std::memory_order_relaxed);
+        if (droppedNow != reportedDropped)
+        {
+            std::cout << "LOG::" << droppedNow - reportedDropped << " mensajes descartados (anillo lleno)\n";
+            reportedDropped = droppedNow;
+            wrote = true;
+        }
+        return wrote;
+    }
+
+    bool write(const Cell& cell)
+    {
+        int category = cell.category;
+        unsigned int limit = rateLimits[category].load(std::memory_order_relaxed);
+        if (limit)
+        {
+            if (cell.time - windowStart[category] >= 1000000)
+            {
+                if (suppressed[category])
+                    std::cout << "LOG::" << suppressed[category] << " mensajes suprimidos en la categoria " << category << "\n";
+                windowStart[category] = cell.time;
+                windowCount[category] = 0;
+                suppressed[category] = 0;
+            }
+            if (++windowCount[category] > limit)
+            {
+                suppressed[category]++;
+                return false;
+            }
+        }
+
+        line.str("");
+        int arg = 0;
+        for (const char* c = cell.format; *c; c++)
+        {
+            if (c[0] == '{' && c[1] == '}' && arg < cell.argCount)
+            {
+                writeArg(cell.args[arg++]);
+                c++;
+            }
+            else
+            {
+                line << *c;
+            }
+        }
+        line << '\n';
+        std::cout << line.str();
+        return true;
+    }
+
+    void writeArg(const LogArg& arg)
+    {
+        switch (arg.type)
+        {
+        case LogArg::INT: line << arg.i; break;
+        case LogArg::UINT: line << arg.u; break;
+        case LogArg::DOUBLE: line << arg.d; break;
+        case LogArg::BOOL: line << (arg.u ? "true" : "false"); break;
+        case LogArg::STRING: line << (arg.s ? arg.s : "(null)"); break;
+        default: break;
+        }
+    }
+};
+
+// logMessage(LOG_CAMERA, LOG_DEBUG, "Camara en {} {} {}", x, y, z);
+template <typename... Args>
+inline void logMessage(LogCategory category, LogLevel level, const char* format, const Args&... args)
+{
+    AsyncLogger::instance().log(category, level, format, args...);
+}
+
+#endif
@@ -0,0 +1,290 @@
+#ifndef BENCHMARK_H
+#define BENCHMARK_H
+
+#include <glad/glad.h>
+#include <glm/glm.hpp>
+
+#include <learnopengl/camera.h>
+#include <learnopengl/gpu_profiler.h>
+
+#include <vector>
+#include <string>
+#include <fstream>
+#include <sstream>
+#include <chrono>
+#include <algorithm>
+#include <iostream>
+#include <cstdint>
+#include <cstdio>
+
+// Recorrido de camara fijo para el benchmark, leido de un archivo de texto:
+//
+//   key <tiempo s> <x y z> <yaw> <pitch>
+//
+// La posicion se interpola con Catmull-Rom entre claves y el yaw/pitch linealmente. Pasado el
+// ultimo tiempo la camara se queda en la ultima clave.
+class CameraPath
+{
+public:
+    struct Key
+    {
+        float time;
+        glm::vec3 position;
+        float yaw;
+        float pitch;
+    };
+
+    bool load(const char* path)
+    {
+        keys.clear();
+        std::ifstream file(path);
+        if (!file.is_open())
+        {
+            std::cout << "BENCHMARK::No se encontro el recorrido: " << path << std::endl;
+            return false;
+        }
+
+        std::string line;
+        int lineNumber = 0;
+        while (std::getline(file, line))
+        {
+            lineNumber++;
+            std::istringstream in(line);
+            std::string keyword;
+            if (!(in >> keyword) || keyword[0] == '#')
+                continue;
+            if (keyword != "key")
+            {
+                std::cout << "BENCHMARK::Palabra desconocida en la linea " << lineNumber << ": " << keyword << std::endl;
+                continue;
+            }
+            Key key;
+            in >> key.time >> key.position.x >> key.position.y >> key.position.z >> key.yaw >> key.pitch;
+            if (in.fail() || (!keys.empty() && key.time <= keys.back().time))
+            {
+                std::cout << "BENCHMARK::Clave mal definida en la linea " << lineNumber << std::endl;
+                continue;
+            }
+            keys.push_back(key);
+        }
+        return !keys.empty();
+    }
+
+    float duration() const { return keys.empty() ? 0.0f : keys.back().time; }
+
+    Key evaluate(float time) const
+    {
+        if (keys.empty())
+            return { time, glm::vec3(0.0f), -90.0f, 0.0f };
+        if (time <= keys.front().time)
+            return keys.front();
+        if (time >= keys.back().time)
+            return keys.back();
+
+        size_t i = 0;
+        while (keys[i + 1].time < time)
+            i++;
+        const Key& a = keys[i];
+        const Key& b = keys[i + 1];
+        const glm::vec3& p0 = keys[i > 0 ? i - 1 : i].position;
+        const glm::vec3& p3 = keys[std::min(i + 2, keys.size() - 1)].position;
+        float t = (time - a.time) / (b.time - a.time);
+        float t2 = t * t, t3 = t2 * t;
+
+        Key result;
+        result.time = time;
+        result.position = 0.5f * ((2.0f * a.position) + (-p0 + b.position) * t +
+                                  (2.0f * p0 - 5.0f * a.position + 4.0f * b.position - p3) * t2 +
+                                  (-p0 + 3.0f * a.position - 3.0f * b.position + p3) * t3);
+        result.yaw = a.yaw + (b.yaw - a.yaw) * t;
+        result.pitch = a.pitch + (b.pitch - a.pitch) * t;
+        return result;
+    }
+
+private:
+    std::vector<Key> keys;
+};
+
+// Modo benchmark: N frames con paso fijo siguiendo un CameraPath, con estadisticas de tiempo de
+// CPU (desde que empieza el trabajo del frame hasta antes del swap) y de GPU (el frame completo
+// segun el GpuProfiler, que llega con unos frames de retraso). Los primeros warmupFrames no cuentan.
+// Opcionalmente guarda cada frame de la escena en PNG (leer los pixels para la GPU, asi que los
+// tiempos de esa ejecucion no son comparables con los de una sin PNG).
+class BenchmarkRun
+{
+public:
+    bool active = false;
+    unsigned int frameCount = 1800;
+    unsigned int warmupFrames = 30;
+    float fixedStep = 1.0f / 60.0f;
+    std::string pngDirectory;   // vacio = sin PNG
+
+    bool loadPath(const char* path)
+    {
+        return cameraPath.load(path);
+    }
+
+    unsigned int frame() const { return currentFrame; }
+
+    // Tiempo de escena del frame actual (paso fijo, no depende de lo que tarde en dibujarse)
+    float time() const { return currentFrame * fixedStep; }
+
+    void beginFrame(Camera& camera)
+    {
+        cpuStart = std::chrono::steady_clock::now();
+        CameraPath::Key key = cameraPath.evaluate(time());
+        camera.Position = key.position;
+        camera.Yaw = key.yaw;
+        camera.Pitch = key.pitch;
+        camera.ProcessMouseMovement(0.0f, 0.0f);   // recalcula Front/Right/Up con el yaw y pitch nuevos
+    }
+
+    // Antes del swap. Devuelve true cuando se han dibujado todos los frames.
+    bool endFrame(const GpuProfiler& profiler, GLuint fbo, int width, int height)
+    {
+        float cpu = std::chrono::duration<float, std::milli>(std::chrono::steady_clock::now() - cpuStart).count();
+        if (currentFrame >= warmupFrames)
+            cpuTimes.push_back(cpu);
+        if (profiler.resolvedFrames != lastResolved)
+        {
+            lastResolved = profiler.resolvedFrames;
+            if (currentFrame >= warmupFrames + GpuProfiler::FRAME_LATENCY)
+                gpuTimes.push_back(profiler.frameMs());
+        }
+
+        if (!pngDirectory.empty())
+            saveFrame(fbo, width, height);
+
+        currentFrame++;
+        return currentFrame >= frameCount;
+    }
+
+    void report() const
+    {
+        std::cout << "BENCHMARK::" << currentFrame << " frames (" << warmupFrames << " de calentamiento), recorrido de "
+                  << cameraPath.duration() << " s a paso fijo de " << fixedStep * 1000.0f << " ms" << std::endl;
+        printStats("CPU", cpuTimes);
+        printStats("GPU", gpuTimes);
+        if (!pngDirectory.empty())
+            std::cout << "BENCHMARK::Frames guardados en " << pngDirectory << " (tiempos afectados por la lectura de pixels)" << std::endl;
+    }
+
+private:
+    CameraPath cameraPath;
+    unsigned int currentFrame = 0;
+    unsigned int lastResolved = 0;
+    std::vector<float> cpuTimes;
+    std::vector<float> gpuTimes;
+    std::vector<unsigned char> pixels;
+    std::chrono::steady_clock::time_point cpuStart;
+
+    static void printStats(const char* name, std::vector<float> times)
+    {
+        if (times.empty())
+        {
+            std::cout << "BENCHMARK::" << name << " sin muestras" << std::endl;
+            return;
+        }
+        std::sort(times.begin(), times.end());
+        float sum = 0.0f;
+        for (float t : times)
+            sum += t;
+        auto percentile = [&](float p) { return times[std::min((size_t)(p * (times.size() - 1) + 0.5f), times.size() - 1)]; };
+        std::cout << "BENCHMARK::" << name << " ms - media " << sum / times.size() << " p50 " << percentile(0.5f)
+                  << " p95 " << percentile(0.95f) << " p99 " << percentile(0.99f) << " max " << times.back()
+                  << " (" << times.size() << " muestras)" << std::endl;
+    }
+
+    void saveFrame(GLuint fbo, int width, int height)
+    {
+        pixels.resize((size_t)width * height * 4);
+        glBindFramebuffer(GL_READ_FRAMEBUFFER, fbo);
+        glPixelStorei(GL_PACK_ALIGNMENT, 1);
+        glReadPixels(0, 0, width, height, GL_RGBA, GL_UNSIGNED_BYTE, pixels.data());
+        glBindFramebuffer(GL_READ_FRAMEBUFFER, 0);
+
+        char name[32];
+        std::snprintf(name, sizeof(name), "/frame_%05u.png", currentFrame);
+        if (!writePNG(pngDirectory + name, width, height, pixels))
+            std::cout << "BENCHMARK::No se pudo escribir " << pngDirectory + name << std::endl;
+    }
+
+    // PNG RGBA8 sin comprimir (bloques deflate "stored"): grande pero sin dependencias.
+    // Las filas se escriben de arriba abajo, al reves que glReadPixels.
+    static bool writePNG(const std::string& path, int width, int height, const std::vector<unsigned char>& rgba)
+    {
+        std::ofstream file(path, std::ios::binary);
+        if (!file)
+            return false;
+
+        size_t rowSize = (size_t)width * 4 + 1;
+        std::vector<unsigned char> raw(rowSize * height);
+        for (int y = 0; y < height; y++)
+        {
+            raw[y * rowSize] = 0;   // filtro None
+            std::copy(rgba.begin() + (size_t)(height - 1 - y) * width * 4, rgba.begin() + (size_t)(height - y) * width * 4,
+                      raw.begin() + y * rowSize + 1);
+        }
+
+        std::vector<unsigned char> zlib = { 0x78, 0x01 };
+        uint32_t a = 1, b = 0;
+        for (unsigned char c : raw)
+        {
+            a = (a + c) % 65521;
+            b = (b + a) % 65521;
+        }
+        for (size_t offset = 0; offset < raw.size() || offset == 0; offset += 65535)
+        {
+            size_t length = std::min<size_t>(65535, raw.size() - offset);
+            bool last = offset + length >= raw.size();
+            zlib.push_back(last ? 1 : 0);
+            zlib.push_back(length & 0xFF);
+            zlib.push_back((length >> 8) & 0xFF);
+            zlib.push_back(~length & 0xFF);
+            zlib.push_back((~length >> 8) & 0xFF);
+            zlib.insert(zlib.end(), raw.begin() + offset, raw.begin() + offset + length);
+            if (last)
+                break;
+        }
+        uint32_t adler = (b << 16) | a;
+        appendBE(zlib, adler);
+
+        std::vector<unsigned char> header;
+        appendBE(header, (uint32_t)width);
+        appendBE(header, (uint32_t)height);
+        header.insert(header.end(), { 8, 6, 0, 0, 0 });   // 8 bits, RGBA
+
+        static const unsigned char signature[8] = { 0x89, 'P', 'N', 'G', '\r', '\n', 0x1A, '\n' };
+        file.write((const char*)signature, 8);
+        writeChunk(file, "IHDR", header);
+        writeChunk(file, "IDAT", zlib);
+        writeChunk(file, "IEND", std::vector<unsigned char>());
+        return (bool)file;
+    }
+
+    static void appendBE(std::vector<unsigned char>& out, uint32_t value)
+    {
+        for (int shift = 24; shift >= 0; shift -= 8)
+            out.push_back((value >> shift) & 0xFF);
+    }
+
+    static void writeChunk(std::ofstream& file, const char* type, const std::vector<unsigned char>& data)
+    {
+        std::vector<unsigned char> chunk;
+        appendBE(chunk, (uint32_t)data.size());
+        chunk.insert(chunk.end(), type, type + 4);
+        chunk.insert(chunk.end(), data.begin(), data.end());
+
+        uint32_t crc = 0xFFFFFFFF;
+        for (size_t i = 4; i < chunk.size(); i++)
+        {
+            crc ^= chunk[i];
+            for (int k = 0; k < 8; k++)
+                crc = (crc >> 1) ^ (0xEDB88320 & (0u - (crc & 1)));
+        }
+        appendBE(chunk, ~crc);
+        file.write((const char*)chunk.data(), chunk.size());
+    }
+};
+
+#endif
@@ -0,0 +1,250 @@
+#ifndef CLUSTERED_LIGHTING_H
+#define CLUSTERED_LIGHTING_H
+
+#include <glad/glad.h>
+#include <glm/glm.hpp>
+
+#include <learnopengl/shader.h>
+#include <learnopengl/frustum_culling.h>
+
+#include <vector>
+#include <algorithm>
+#include <utility>
+#include <cmath>
+#include <cfloat>
+
+// Clustered forward shading (GL 3.3).
+//
+// El frustum de la camara se divide en una rejilla de clusters (tiles de pantalla x cortes de
+// profundidad exponenciales). Cada frame, en la CPU, cada luz puntual se asigna a los clusters que
+// toca su esfera de alcance y el resultado se sube a tres texture buffers:
+//   lightData     RGBA32F  2 texels por luz: (posicion, alcance) y (color, slot de sombra o -1)
+//   clusterData   RG32UI   por cluster: (primer indice en lightIndices, numero de luces)
+//   lightIndices  R32UI    indices de luz de todos los clusters seguidos
+// El fragment shader calcula su cluster con gl_FragCoord y la profundidad en vista y solo recorre
+// esas luces. El alcance sale de constant/linear/quadratic: la distancia a la que la atenuacion
+// cae por debajo de intensityCutoff (el shader la lleva a cero suavemente en ese borde).
+struct PointLight
+{
+    glm::vec3 position;
+    glm::vec3 color;
+    int shadow = -1;   // luz en el atlas de sombras, -1 sin sombra
+};
+
+class ClusteredLights
+{
+public:
+    // Unidades de textura fijas para los texture buffers (la cola de render usa las primeras)
+    static const int LIGHT_DATA_UNIT = 13;
+    static const int CLUSTER_DATA_UNIT = 14;
+    static const int LIGHT_INDEX_UNIT = 15;
+
+    unsigned int tilesX = 16, tilesY = 9, slices = 24;
+    float intensityCutoff = 0.05f;
+
+    // Estadisticas del ultimo frame
+    unsigned int lightCount = 0;
+    unsigned int maxLightsPerCluster = 0;
+    unsigned int totalAssignments = 0;
+
+    ClusteredLights()
+    {
+        glGenBuffers(3, buffers);
+        glGenTextures(3, textures);
+        GLenum formats[3] = { GL_RGBA32F, GL_RG32UI, GL_R32UI };
+        for (int i = 0; i < 3; i++)
+        {
+            glBindBuffer(GL_TEXTURE_BUFFER, buffers[i]);
+            glBufferData(GL_TEXTURE_BUFFER, 16, nullptr, GL_STREAM_DRAW);
+            glBindTexture(GL_TEXTURE_BUFFER, textures[i]);
+            glTexBuffer(GL_TEXTURE_BUFFER, formats[i], buffers[i]);
+        }
+        glBindTexture(GL_TEXTURE_BUFFER, 0);
+        glBindBuffer(GL_TEXTURE_BUFFER, 0);
+    }
+
+    ~ClusteredLights()
+    {
+        glDeleteTextures(3, textures);
+        glDeleteBuffers(3, buffers);
+    }
+
+    ClusteredLights(const ClusteredLights&) = delete;
+    ClusteredLights& operator=(const ClusteredLights&) = delete;
+
+    void setAttenuation(float constant, float linear, float quadratic)
+    {
+        this->constant = constant;
+        this->linear = linear;
+        this->quadratic = quadratic;
+    }
+
+    // Distancia a la que constant + linear*d + quadratic*d^2 = 1 / intensityCutoff
+    float lightRange() const
+    {
+        float c = constant - 1.0f / intensityCutoff;
+        if (quadratic > 0.0f)
+            return (-linear + std::sqrt(linear * linear - 4.0f * quadratic * c)) / (2.0f * quadratic);
+        if (linear > 0.0f)
+            return -c / linear;
+        return 1000.0f;
+    }
+
+    // Asigna las luces a los clusters y sube los buffers. zNear/zFar deben ser los de la proyeccion.
+    void update(const std::vector<PointLight>& lights, const glm::mat4& view, const glm::mat4& projection, float zNear, float zFar)
+    {
+        if (projection != lastProjection || zNear != lastNear || zFar != lastFar || clusterBounds.size() != clusterCount())
+            buildClusterBounds(projection, zNear, zFar);
+
+        float range = lightRange();
+        float sliceScale = slices / std::log(zFar / zNear);
+        assignments.clear();
+        lightTexels.clear();
+        for (unsigned int l = 0; l < lights.size(); l++)
+        {
+            lightTexels.push_back(glm::vec4(lights[l].position, range));
+            lightTexels.push_back(glm::vec4(lights[l].color, (float)lights[l].shadow));
+
+            glm::vec3 center = glm::vec3(view * glm::vec4(lights[l].position, 1.0f));
+            float depth = -center.z;
+            if (depth + range < zNear || depth - range > zFar)
+                continue;
+            unsigned int firstSlice = sliceOf(depth - range, zNear, sliceScale);
+            unsigned int lastSlice = sliceOf(depth + range, zNear, sliceScale);
+            for (unsigned int z = firstSlice; z <= lastSlice; z++)
+            {
+                for (unsigned int i = z * tilesX * tilesY; i < (z + 1) * tilesX * tilesY; i++)
+                    if (sphereIntersects(clusterBounds[i], center, range))
+                        assignments.push_back(std::make_pair(i, l));
+            }
+        }
+
+        // Ordenacion por conteo: offset y numero de luces por cluster
+        clusterTexels.assign(clusterCount() * 2, 0);
+        for (const auto& assignment : assignments)
+            clusterTexels[assignment.first * 2 + 1]++;
+        unsigned int offset = 0;
+        maxLightsPerCluster = 0;
+        for (unsigned int i = 0; i < clusterCount(); i++)
+        {
+            clusterTexels[i * 2] = offset;
+            offset += clusterTexels[i * 2 + 1];
+            maxLightsPerCluster = std::max(maxLightsPerCluster, clusterTexels[i * 2 + 1]);
+            clusterTexels[i * 2 + 1] = 0;
+        }
+        indexTexels.assign(std::max<size_t>(assignments.size(), 1), 0);
+        for (const auto& assignment : assignments)
+        {
+            GLuint* cluster = &clusterTexels[assignment.first * 2];
+            indexTexels[cluster[0] + cluster[1]++] = assignment.second;
+        }
+        if (lightTexels.empty())
+            lightTexels.push_back(glm::vec4(0.0f));
+
+        upload(buffers[0], lightTexels.data(), lightTexels.size() * sizeof(glm::vec4));
+        upload(buffers[1], clusterTexels.data(), clusterTexels.size() * sizeof(GLuint));
+        upload(buffers[2], indexTexels.data(), indexTexels.size() * sizeof(GLuint));
+
+        lightCount = (unsigned int)lights.size();
+        totalAssignments = (unsigned int)assignments.size();
+    }
+
+    // Uniforms y texture buffers para un shader que usa la iluminacion por clusters
+    // (Shader de learnopengl o ShaderVariant)
+    template <typename ShaderType>
+    void bind(ShaderType& shader, float screenWidth, float screenHeight)
+    {
+        shader.use();
+        shader.setInt("lightData", LIGHT_DATA_UNIT);
+        shader.setInt("clusterData", CLUSTER_DATA_UNIT);
+        shader.setInt("lightIndices", LIGHT_INDEX_UNIT);
+        glUniform3ui(glGetUniformLocation(shader.ID, "clusterGrid"), tilesX, tilesY, slices);
+        shader.setVec2("screenSize", glm::vec2(screenWidth, screenHeight));
+        shader.setFloat("zNear", lastNear);
+        shader.setFloat("sliceScale", slices / std::log(lastFar / lastNear));
+
+        int units[3] = { LIGHT_DATA_UNIT, CLUSTER_DATA_UNIT, LIGHT_INDEX_UNIT };
+        for (int i = 0; i < 3; i++)
+        {
+            glActiveTexture(GL_TEXTURE0 + units[i]);
+            glBindTexture(GL_TEXTURE_BUFFER, textures[i]);
+        }
+        glActiveTexture(GL_TEXTURE0);
+    }
+
+private:
+    GLuint buffers[3] = {};
+    GLuint textures[3] = {};
+    float constant = 1.0f, linear = 0.1f, quadratic = 0.012f;
+
+    glm::mat4 lastProjection = glm::mat4(0.0f);
+    float lastNear = 0.1f, lastFar = 100.0f;
+    std::vector<AABB> clusterBounds;  // en espacio de vista
+
+    std::vector<std::pair<unsigned int, unsigned int>> assignments;  // (cluster, luz)
+    std::vector<glm::vec4> lightTexels;
+    std::vector<GLuint> clusterTexels;
+    std::vector<GLuint> indexTexels;
+
+    unsigned int clusterCount() const { return tilesX * tilesY * slices; }
+
+    unsigned int sliceOf(float depth, float zNear, float sliceScale) const
+    {
+        if (depth <= zNear)
+            return 0;
+        unsigned int slice = (unsigned int)(std::log(depth / zNear) * sliceScale);
+        return std::min(slice, slices - 1);
+    }
+
+    static bool sphereIntersects(const AABB& box, const glm::vec3& center, float radius)
+    {
+        glm::vec3 closest = glm::clamp(center, box.min, box.max);
+        glm::vec3 d = closest - center;
+        return glm::dot(d, d) <= radius * radius;
+    }
+
+    // Caja en espacio de vista de cada cluster (solo cambia con la proyeccion)
+    void buildClusterBounds(const glm::mat4& projection, float zNear, float zFar)
+    {
+        lastProjection = projection;
+        lastNear = zNear;
+        lastFar = zFar;
+        glm::mat4 inverseProjection = glm::inverse(projection);
+        clusterBounds.resize(clusterCount());
+        for (unsigned int z = 0; z < slices; z++)
+        {
+            float nearDepth = zNear * std::pow(zFar / zNear, (float)z / slices);
+            float farDepth = zNear * std::pow(zFar / zNear, (float)(z + 1) / slices);
+            for (unsigned int y = 0; y < tilesY; y++)
+            {
+                for (unsigned int x = 0; x < tilesX; x++)
+                {
+                    AABB box = { glm::vec3(FLT_MAX), glm::vec3(-FLT_MAX) };
+                    for (int corner = 0; corner < 4; corner++)
+                    {
+                        float ndcX = -1.0f + 2.0f * (x + (corner & 1)) / tilesX;
+                        float ndcY = -1.0f + 2.0f * (y + (corner >> 1)) / tilesY;
+                        glm::vec4 p = inverseProjection * glm::vec4(ndcX, ndcY, -1.0f, 1.0f);
+                        glm::vec3 ray = glm::vec3(p) / p.w;
+                        for (float depth : { nearDepth, farDepth })
+                        {
+                            glm::vec3 point = ray * (depth / -ray.z);
+                            box.min = glm::min(box.min, point);
+                            box.max = glm::max(box.max, point);
+                        }
+                    }
+                    clusterBounds[x + tilesX * (y + tilesY * z)] = box;
+                }
+            }
+        }
+    }
+
+    static void upload(GLuint buffer, const void* data, size_t size)
+    {
+        glBindBuffer(GL_TEXTURE_BUFFER, buffer);
+        glBufferData(GL_TEXTURE_BUFFER, size, data, GL_STREAM_DRAW);
+        glBindBuffer(GL_TEXTURE_BUFFER, 0);
+    }
+};
+
+#endif
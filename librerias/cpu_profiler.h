@@ -0,0 +1,155 @@
+#ifndef CPU_PROFILER_H
+#define CPU_PROFILER_H
+
+#include <vector>
+#include <string>
+#include <memory>
+#include <mutex>
+#include <atomic>
+#include <chrono>
+#include <fstream>
+#include <iostream>
+#include <cstdint>
+
+// Zonas de tiempo de CPU con exportacion a trace de Chrome/Perfetto.
+//
+// Cada hilo escribe en su propio anillo (thread_local, sin locks) un registro por zona al cerrarla:
+// nombre (literal, no se copia), inicio y fin en ns de steady_clock. El anillo guarda las ultimas
+// CAPACITY zonas; lo antiguo se sobrescribe. exportChromeTrace vuelca todos los anillos a un JSON
+// que se abre en chrome://tracing o ui.perfetto.dev para ver frames concretos. La exportacion lee
+// los anillos mientras los demas hilos pueden seguir escribiendo: en ese caso algun registro del
+// borde puede salir mezclado, lo cual se acepta para no poner locks en la ruta caliente.
+class CpuProfiler
+{
+public:
+    static const unsigned int CAPACITY = 1 << 16;
+
+    bool enabled = true;
+
+    static CpuProfiler& instance()
+    {
+        static CpuProfiler profiler;
+        return profiler;
+    }
+
+    static int64_t now()
+    {
+        return std::chrono::duration_cast<std::chrono::nanoseconds>(std::chrono::steady_clock::now().time_since_epoch()).count();
+    }
+
+    void record(const char* name, int64_t start, int64_t end)
+    {
+        ThreadBuffer& buffer = threadBuffer();
+        uint64_t index = buffer.next.load(std::memory_order_relaxed);
+        buffer.records[index % CAPACITY] = { name, start, end };
+        buffer.next.store(index + 1, std::memory_order_release);
+    }
+
+    // Nombre del hilo actual en el trace
+    void setThreadName(const std::string& name)
+    {
+        ThreadBuffer& buffer = threadBuffer();
+        std::lock_guard<std::mutex> lock(mutex);
+        buffer.name = name;
+    }
+
+    bool exportChromeTrace(const std::string& path)
+    {
+        std::ofstream file(path);
+        if (!file)
+        {
+            std::cout << "PROFILER::No se pudo escribir " << path << std::endl;
+            return false;
+        }
+
+        std::lock_guard<std::mutex> lock(mutex);
+        int64_t origin = INT64_MAX;
+        for (const auto& buffer : buffers)
+        {
+            uint64_t end = buffer->next.load(std::memory_order_acquire);
+            for (uint64_t i = end > CAPACITY ? end - CAPACITY : 0; i < end; i++)
+                origin = std::min(origin, buffer->records[i % CAPACITY].start);
+        }
+
+        size_t events = 0;
+        file << "{\"traceEvents\":[\n";
+        bool first = true;
+        for (const auto& buffer : buffers)
+        {
+            file << (first ? "" : ",\n") << "{\"name\":\"thread_name\",\"ph\":\"M\",\"pid\":1,\"tid\":" << buffer->id
+                 << ",\"args\":{\"name\":\"" << buffer->name << "\"}}";
+            first = false;
+            uint64_t end = buffer->next.load(std::memory_order_acquire);
+            for (uint64_t i = end > CAPACITY ? end - CAPACITY : 0; i < end; i++)
+            {
+                const Record& r = buffer->records[i % CAPACITY];
+                file << ",\n{\"name\":\"" << r.name << "\",\"ph\":\"X\",\"pid\":1,\"tid\":" << buffer->id
+                     << ",\"ts\":" << (double)(r.start - origin) / 1000.0 << ",\"dur\":" << (double)(r.end - r.start) / 1000.0 << "}";
+                events++;
+            }
+        }
+        file << "\n]}\n";
+        std::cout << "PROFILER::" << events << " zonas exportadas a " << path << std::endl;
+        return true;
+    }
+
+private:
+    struct Record
+    {
+        const char* name;
+        int64_t start;
+        int64_t end;
+    };
+
+    struct ThreadBuffer
+    {
+        unsigned int id = 0;
+        std::string name;
+        std::vector<Record> records;
+        std::atomic<uint64_t> next{ 0 };
+    };
+
+    std::mutex mutex;   // solo para registrar hilos y exportar
+    std::vector<std::unique_ptr<ThreadBuffer>> buffers;
+
+    CpuProfiler() = default;
+    CpuProfiler(const CpuProfiler&) = delete;
+    CpuProfiler& operator=(const CpuProfiler&) = delete;
+
+    ThreadBuffer& threadBuffer()
+    {
+        static thread_local ThreadBuffer* buffer = nullptr;
+        if (!buffer)
+        {
+            std::lock_guard<std::mutex> lock(mutex);
+            buffers.push_back(std::unique_ptr<ThreadBuffer>(new ThreadBuffer()));
+            buffer = buffers.back().get();
+            buffer->id = (unsigned int)buffers.size();
+            buffer->name = "hilo " + std::to_string(buffer->id);
+            buffer->records.resize(CAPACITY);
+        }
+        return *buffer;
+    }
+};
+
+// Zona RAII: CpuZone zone("colision"); el nombre debe ser un literal (se guarda el puntero)
+class CpuZone
+{
+public:
+    explicit CpuZone(const char* name) : name(name), start(CpuProfiler::instance().enabled ? CpuProfiler::now() : -1) {}
+
+    ~CpuZone()
+    {
+        if (start >= 0)
+            CpuProfiler::instance().record(name, start, CpuProfiler::now());
+    }
+
+    CpuZone(const CpuZone&) = delete;
+    CpuZone& operator=(const CpuZone&) = delete;
+
+private:
+    const char* name;
+    int64_t start;
+};
+
+#endif
@@ -0,0 +1,275 @@
+#ifndef DEFERRED_SHADING_H
+#define DEFERRED_SHADING_H
+
+#include <glad/glad.h>
+#include <GLFW/glfw3.h>
+#include <glm/glm.hpp>
+#include <glm/gtc/matrix_transform.hpp>
+
+#include <learnopengl/program_cache.h>
+#include <learnopengl/frustum_culling.h>
+#include <learnopengl/clustered_lighting.h>
+
+#include <vector>
+#include <algorithm>
+#include <cmath>
+#include <iostream>
+
+#ifndef GL_DEPTH_BOUNDS_TEST_EXT
+#define GL_DEPTH_BOUNDS_TEST_EXT 0x8890
+#endif
+
+// Deferred shading opcional para la casa.
+//
+// G-buffer compacto (8 bytes de color por pixel + profundidad):
+//   albedoRoughness  RGBA8     albedo y rugosidad
+//   normal           RG16_SNORM normal en mundo codificada en octaedro
+//   depth            DEPTH24_STENCIL8, de donde se reconstruye la posicion
+// Las luces se dibujan como esferas (caras traseras, GL_GEQUAL) con mezcla aditiva, asi solo se
+// sombrean los pixeles cuya geometria esta dentro del volumen. Si el driver tiene
+// GL_EXT_depth_bounds_test ademas se descartan los pixeles fuera del rango de profundidad de la
+// esfera antes de ejecutar el fragment shader.
+// Al terminar se copia la profundidad al framebuffer de la escena para dibujar en forward lo que
+// no pasa por el G-buffer (lamparas, fantasma, materiales con emision).
+class DeferredRenderer
+{
+public:
+    bool enabled = false;
+
+    // Estadisticas del ultimo frame
+    unsigned int lightsDrawn = 0;
+    unsigned int lightsCulled = 0;
+
+    DeferredRenderer(const char* lightVertexPath, const char* lightFragmentPath,
+                     const char* ambientVertexPath, const char* ambientFragmentPath)
+        : lightShader(lightVertexPath, lightFragmentPath), ambientShader(ambientVertexPath, ambientFragmentPath)
+    {
+        glGenFramebuffers(1, &fbo);
+        glGenTextures(1, &albedoTexture);
+        glGenTextures(1, &normalTexture);
+        glGenTextures(1, &depthTexture);
+        glGenVertexArrays(1, &emptyVAO);
+        buildSphere();
+
+        if (glfwExtensionSupported("GL_EXT_depth_bounds_test"))
+            depthBounds = (DepthBoundsProc)glfwGetProcAddress("glDepthBoundsEXT");
+        std::cout << "DEFERRED::depth bounds test " << (depthBounds ? "disponible" : "no disponible") << std::endl;
+    }
+
+    ~DeferredRenderer()
+    {
+        glDeleteFramebuffers(1, &fbo);
+        glDeleteTextures(1, &albedoTexture);
+        glDeleteTextures(1, &normalTexture);
+        glDeleteTextures(1, &depthTexture);
+        glDeleteVertexArrays(1, &emptyVAO);
+        glDeleteVertexArrays(1, &sphereVAO);
+        glDeleteBuffers(1, &sphereVBO);
+        glDeleteBuffers(1, &sphereEBO);
+    }
+
+    DeferredRenderer(const DeferredRenderer&) = delete;
+    DeferredRenderer& operator=(const DeferredRenderer&) = delete;
+
+    // Crea o recrea el G-buffer si cambia el tamano
+    void resize(int width, int height)
+    {
+        if (width == this->width && height == this->height)
+            return;
+        this->width = width;
+        this->height = height;
+
+        allocate(albedoTexture, GL_RGBA8, GL_RGBA, GL_UNSIGNED_BYTE);
+        allocate(normalTexture, GL_RG16_SNORM, GL_RG, GL_SHORT);
+        allocate(depthTexture, GL_DEPTH24_STENCIL8, GL_DEPTH_STENCIL, GL_UNSIGNED_INT_24_8);
+
+        glBindFramebuffer(GL_FRAMEBUFFER, fbo);
+        glFramebufferTexture2D(GL_FRAMEBUFFER, GL_COLOR_ATTACHMENT0, GL_TEXTURE_2D, albedoTexture, 0);
+        glFramebufferTexture2D(GL_FRAMEBUFFER, GL_COLOR_ATTACHMENT1, GL_TEXTURE_2D, normalTexture, 0);
+        glFramebufferTexture2D(GL_FRAMEBUFFER, GL_DEPTH_STENCIL_ATTACHMENT, GL_TEXTURE_2D, depthTexture, 0);
+        GLenum attachments[2] = { GL_COLOR_ATTACHMENT0, GL_COLOR_ATTACHMENT1 };
+        glDrawBuffers(2, attachments);
+        if (glCheckFramebufferStatus(GL_FRAMEBUFFER) != GL_FRAMEBUFFER_COMPLETE)
+        {
+            std::cout << "DEFERRED::El G-buffer no esta completo, se desactiva" << std::endl;
+            enabled = false;
+        }
+        glBindFramebuffer(GL_FRAMEBUFFER, 0);
+    }
+
+    // A partir de aqui los draws opacos escriben en el G-buffer
+    void beginGeometryPass()
+    {
+        glBindFramebuffer(GL_FRAMEBUFFER, fbo);
+        glClearColor(0.0f, 0.0f, 0.0f, 0.0f);
+        glClear(GL_COLOR_BUFFER_BIT | GL_DEPTH_BUFFER_BIT | GL_STENCIL_BUFFER_BIT);
+    }
+
+    // Ilumina el G-buffer en target (que ya debe estar limpio y tener el mismo tamano) y le copia la profundidad
+    void lightingPass(const std::vector<PointLight>& lights, float range, const Frustum& frustum,
+                      const glm::mat4& view, const glm::mat4& projection, const glm::vec3& viewPos,
+                      const glm::vec3& lightColor, float constant, float linear, float quadratic, float ambient,
+                      GLuint target = 0)
+    {
+        glBindFramebuffer(GL_READ_FRAMEBUFFER, fbo);
+        glBindFramebuffer(GL_DRAW_FRAMEBUFFER, target);
+        glBlitFramebuffer(0, 0, width, height, 0, 0, width, height, GL_DEPTH_BUFFER_BIT, GL_NEAREST);
+        glBindFramebuffer(GL_FRAMEBUFFER, target);
+
+        glActiveTexture(GL_TEXTURE0);
+        glBindTexture(GL_TEXTURE_2D, albedoTexture);
+        glActiveTexture(GL_TEXTURE1);
+        glBindTexture(GL_TEXTURE_2D, normalTexture);
+        glActiveTexture(GL_TEXTURE2);
+        glBindTexture(GL_TEXTURE_2D, depthTexture);
+        glActiveTexture(GL_TEXTURE0);
+
+        glDepthMask(GL_FALSE);
+        glEnable(GL_BLEND);
+        glBlendFunc(GL_ONE, GL_ONE);
+
+        // Luz ambiente: triangulo de pantalla completa
+        glDisable(GL_DEPTH_TEST);
+        ambientShader.use();
+        ambientShader.setInt("gAlbedoRoughness", 0);
+        ambientShader.setFloat("ambient", ambient);
+        glBindVertexArray(emptyVAO);
+        glDrawArrays(GL_TRIANGLES, 0, 3);
+
+        // Volumenes de luz
+        glm::mat4 viewProjection = projection * view;
+        lightShader.use();
+        lightShader.setInt("gAlbedoRoughness", 0);
+        lightShader.setInt("gNormal", 1);
+        lightShader.setInt("gDepth", 2);
+        lightShader.setMat4("viewProjection", viewProjection);
+        lightShader.setMat4("inverseViewProjection", glm::inverse(viewProjection));
+        lightShader.setVec2("screenSize", glm::vec2((float)width, (float)height));
+        lightShader.setVec3("viewPos", viewPos);
+        lightShader.setVec3("lightColor", lightColor);
+        lightShader.setFloat("constant", constant);
+        lightShader.setFloat("linear", linear);
+        lightShader.setFloat("quadratic", quadratic);
+
+        glEnable(GL_DEPTH_TEST);
+        glDepthFunc(GL_GEQUAL);
+        glEnable(GL_CULL_FACE);
+        glCullFace(GL_FRONT);
+        if (depthBounds)
+            glEnable(GL_DEPTH_BOUNDS_TEST_EXT);
+        glBindVertexArray(sphereVAO);
+
+        lightsDrawn = lightsCulled = 0;
+        for (const PointLight& light : lights)
+        {
+            AABB box = { light.position - glm::vec3(range), light.position + glm::vec3(range) };
+            if (!frustum.intersects(box))
+            {
+                lightsCulled++;
+                continue;
+            }
+            if (depthBounds)
+            {
+                float depth = -(view * glm::vec4(light.position, 1.0f)).z;
+                depthBounds(windowDepth(projection, depth - range), windowDepth(projection, depth + range));
+            }
+            glm::mat4 model = glm::translate(glm::mat4(1.0f), light.position);
+            model = glm::scale(model, glm::vec3(range * sphereScale));
+            lightShader.setMat4("model", model);
+            lightShader.setVec3("lightPosition", light.position);
+            lightShader.setVec3("lightTint", light.color);
+            lightShader.setFloat("lightRange", range);
+            glDrawElements(GL_TRIANGLES, sphereIndexCount, GL_UNSIGNED_INT, 0);
+            lightsDrawn++;
+        }
+
+        if (depthBounds)
+            glDisable(GL_DEPTH_BOUNDS_TEST_EXT);
+        glBindVertexArray(0);
+        glCullFace(GL_BACK);
+        glDisable(GL_CULL_FACE);
+        glDepthFunc(GL_LESS);
+        glDisable(GL_BLEND);
+        glDepthMask(GL_TRUE);
+    }
+
+private:
+    typedef void (APIENTRYP DepthBoundsProc)(GLclampd zmin, GLclampd zmax);
+
+    CachedShader lightShader;
+    CachedShader ambientShader;
+    GLuint fbo = 0;
+    GLuint albedoTexture = 0, normalTexture = 0, depthTexture = 0;
+    GLuint emptyVAO = 0;
+    GLuint sphereVAO = 0, sphereVBO = 0, sphereEBO = 0;
+    GLsizei sphereIndexCount = 0;
+    float sphereScale = 1.0f;   // para que la esfera poligonal contenga a la esfera real
+    int width = 0, height = 0;
+    DepthBoundsProc depthBounds = nullptr;
+
+    void allocate(GLuint texture, GLint internalFormat, GLenum format, GLenum type)
+    {
+        glBindTexture(GL_TEXTURE_2D, texture);
+        glTexImage2D(GL_TEXTURE_2D, 0, internalFormat, width, height, 0, format, type, nullptr);
+        glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_MIN_FILTER, GL_NEAREST);
+        glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_MAG_FILTER, GL_NEAREST);
+        glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_WRAP_S, GL_CLAMP_TO_EDGE);
+        glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_WRAP_T, GL_CLAMP_TO_EDGE);
+        glBindTexture(GL_TEXTURE_2D, 0);
+    }
+
+    // Profundidad de ventana [0,1] de un punto a distancia depth delante de la camara
+    static double windowDepth(const glm::mat4& projection, float depth)
+    {
+        const float nearLimit = 1e-4f;
+        if (depth < nearLimit)
+            depth = nearLimit;
+        float ndc = (-projection[2][2] * depth + projection[3][2]) / depth;
+        ndc = std::min(std::max(ndc, -1.0f), 1.0f);
+        return 0.5 * ndc + 0.5;
+    }
+
+    // Esfera UV de radio 1
+    void buildSphere()
+    {
+        const int stacks = 8, slices = 12;
+        std::vector<float> vertices;
+        for (int i = 0; i <= stacks; i++)
+        {
+            float phi = 3.14159265f * i / stacks;
+            for (int j = 0; j <= slices; j++)
+            {
+                float theta = 2.0f * 3.14159265f * j / slices;
+                vertices.push_back(std::sin(phi) * std::cos(theta));
+                vertices.push_back(std::cos(phi));
+                vertices.push_back(std::sin(phi) * std::sin(theta));
+            }
+        }
+        std::vector<unsigned int> indices;
+        for (int i = 0; i < stacks; i++)
+        {
+            for (int j = 0; j < slices; j++)
+            {
+                unsigned int a = i * (slices + 1) + j, b = a + slices + 1;
+                indices.insert(indices.end(), { a, a + 1, b, a + 1, b + 1, b });  // CCW visto desde fuera
+            }
+        }
+        sphereIndexCount = (GLsizei)indices.size();
+        // Los vertices estan sobre la esfera y las caras por dentro: se agranda lo que se hunde cada cara
+        sphereScale = 1.0f / (std::cos(3.14159265f / stacks) * std::cos(3.14159265f / slices));
+
+        glGenVertexArrays(1, &sphereVAO);
+        glGenBuffers(1, &sphereVBO);
+        glGenBuffers(1, &sphereEBO);
+        glBindVertexArray(sphereVAO);
+        glBindBuffer(GL_ARRAY_BUFFER, sphereVBO);
+        glBufferData(GL_ARRAY_BUFFER, vertices.size() * sizeof(float), vertices.data(), GL_STATIC_DRAW);
+        glBindBuffer(GL_ELEMENT_ARRAY_BUFFER, sphereEBO);
+        glBufferData(GL_ELEMENT_ARRAY_BUFFER, indices.size() * sizeof(unsigned int), indices.data(), GL_STATIC_DRAW);
+        glEnableVertexAttribArray(0);
+        glVertexAttribPointer(0, 3, GL_FLOAT, GL_FALSE, 3 * sizeof(float), (void*)0);
+        glBindVertexArray(0);
+    }
+};
+
+#endif
@@ -0,0 +1,190 @@
+#ifndef FRAME_GOVERNOR_H
+#define FRAME_GOVERNOR_H
+
+#include <glad/glad.h>
+
+#include <learnopengl/async_logger.h>
+
+#include <vector>
+#include <chrono>
+#include <algorithm>
+#include <iostream>
+
+// Destino de render con resolucion interna escalada. La escena se dibuja aqui y al final se
+// reescala (filtro lineal) al framebuffer por defecto.
+class ScaledRenderTarget
+{
+public:
+    GLuint fbo = 0;
+    int width = 0, height = 0;
+
+    ScaledRenderTarget()
+    {
+        glGenFramebuffers(1, &fbo);
+        glGenTextures(1, &colorTexture);
+        glGenRenderbuffers(1, &depthBuffer);
+    }
+
+    ~ScaledRenderTarget()
+    {
+        glDeleteRenderbuffers(1, &depthBuffer);
+        glDeleteTextures(1, &colorTexture);
+        glDeleteFramebuffers(1, &fbo);
+    }
+
+    ScaledRenderTarget(const ScaledRenderTarget&) = delete;
+    ScaledRenderTarget& operator=(const ScaledRenderTarget&) = delete;
+
+    void resize(int width, int height)
+    {
+        width = std::max(width, 1);
+        height = std::max(height, 1);
+        if (width == this->width && height == this->height)
+            return;
+        this->width = width;
+        this->height = height;
+
+        glBindTexture(GL_TEXTURE_2D, colorTexture);
+        glTexImage2D(GL_TEXTURE_2D, 0, GL_RGBA8, width, height, 0, GL_RGBA, GL_UNSIGNED_BYTE, nullptr);
+        glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_MIN_FILTER, GL_LINEAR);
+        glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_MAG_FILTER, GL_LINEAR);
+        glBindTexture(GL_TEXTURE_2D, 0);
+        // Mismo formato que el G-buffer para poder copiar la profundidad con glBlitFramebuffer
+        glBindRenderbuffer(GL_RENDERBUFFER, depthBuffer);
+        glRenderbufferStorage(GL_RENDERBUFFER, GL_DEPTH24_STENCIL8, width, height);
+        glBindRenderbuffer(GL_RENDERBUFFER, 0);
+
+        glBindFramebuffer(GL_FRAMEBUFFER, fbo);
+        glFramebufferTexture2D(GL_FRAMEBUFFER, GL_COLOR_ATTACHMENT0, GL_TEXTURE_2D, colorTexture, 0);
+        glFramebufferRenderbuffer(GL_FRAMEBUFFER, GL_DEPTH_STENCIL_ATTACHMENT, GL_RENDERBUFFER, depthBuffer);
+        if (glCheckFramebufferStatus(GL_FRAMEBUFFER) != GL_FRAMEBUFFER_COMPLETE)
+            std::cout << "GOVERNOR::El framebuffer escalado no esta completo" << std::endl;
+        glBindFramebuffer(GL_FRAMEBUFFER, 0);
+    }
+
+    // Activa el destino con su viewport
+    void bind()
+    {
+        glBindFramebuffer(GL_FRAMEBUFFER, fbo);
+        glViewport(0, 0, width, height);
+    }
+
+    // Reescala el color al framebuffer por defecto
+    void blitToScreen(int screenWidth, int screenHeight)
+    {
+        glBindFramebuffer(GL_READ_FRAMEBUFFER, fbo);
+        glBindFramebuffer(GL_DRAW_FRAMEBUFFER, 0);
+        glBlitFramebuffer(0, 0, width, height, 0, 0, screenWidth, screenHeight, GL_COLOR_BUFFER_BIT,
+                          width == screenWidth && height == screenHeight ? GL_NEAREST : GL_LINEAR);
+        glBindFramebuffer(GL_FRAMEBUFFER, 0);
+        glViewport(0, 0, screenWidth, screenHeight);
+    }
+
+private:
+    GLuint colorTexture = 0;
+    GLuint depthBuffer = 0;
+};
+
+// Ajusta la calidad para mantener un tiempo de frame objetivo.
+//
+// Mide el tiempo de CPU del frame (steady_clock) y recibe el de GPU del GpuProfiler (que llega
+// unos frames tarde, sin esperar a la GPU). Con el maximo de los dos, suavizado, sube o baja un
+// escalon en una tabla de niveles de calidad. Cada escalon toca un solo parametro: sesgo de LOD,
+// presupuesto de caras de sombra, resolucion interna o numero de luces. Para no oscilar hay una banda muerta entre degradar y mejorar, y despues de cada cambio
+// se espera un numero de frames (mas para mejorar que para degradar).
+class FrameGovernor
+{
+public:
+    struct QualityLevel
+    {
+        float renderScale;
+        float lodBias;
+        unsigned int shadowBudget;
+        unsigned int maxLights;
+    };
+
+    bool enabled = true;
+    float targetMs = 16.6f;
+    float degradeThreshold = 1.05f;   // degradar si el frame supera el objetivo en un 5%
+    float improveThreshold = 0.80f;   // mejorar si sobra un 20%
+    unsigned int degradeCooldown = 30;
+    unsigned int improveCooldown = 90;
+
+    // Tiempos suavizados (ms)
+    float cpuMs = 0.0f;
+    float gpuMs = 0.0f;
+
+    FrameGovernor()
+    {
+        levels = {
+            { 1.00f, 0.0f, 6, 10 },
+            { 1.00f, 0.5f, 6, 10 },
+            { 1.00f, 0.5f, 4, 10 },
+            { 0.85f, 0.5f, 4, 10 },
+            { 0.85f, 1.0f, 4, 10 },
+            { 0.85f, 1.0f, 2, 10 },
+            { 0.70f, 1.0f, 2, 10 },
+            { 0.70f, 1.0f, 2, 8 },
+            { 0.70f, 1.5f, 2, 8 },
+            { 0.60f, 1.5f, 2, 8 },
+            { 0.60f, 1.5f, 1, 8 },
+            { 0.60f, 1.5f, 1, 6 },
+            { 0.60f, 2.0f, 1, 6 },
+            { 0.50f, 2.0f, 1, 6 },
+        };
+    }
+
+    const QualityLevel& quality() const { return levels[level]; }
+    unsigned int qualityLevel() const { return level; }
+
+    void beginFrame()
+    {
+        cpuStart = std::chrono::steady_clock::now();
+    }
+
+    // Justo antes de glfwSwapBuffers. gpuFrameMs es el ultimo tiempo de GPU conocido (< 0 si no hay).
+    void endFrame(float gpuFrameMs)
+    {
+        float cpu = std::chrono::duration<float, std::milli>(std::chrono::steady_clock::now() - cpuStart).count();
+        cpuMs = cpuMs == 0.0f ? cpu : cpuMs + SMOOTHING * (cpu - cpuMs);
+        if (gpuFrameMs >= 0.0f)
+            gpuMs = gpuMs == 0.0f ? gpuFrameMs : gpuMs + SMOOTHING * (gpuFrameMs - gpuMs);
+
+        adjust();
+    }
+
+private:
+    static constexpr float SMOOTHING = 0.1f;
+
+    std::vector<QualityLevel> levels;
+    unsigned int level = 0;
+    unsigned int framesSinceChange = 0;
+    std::chrono::steady_clock::time_point cpuStart;
+
+    void adjust()
+    {
+        framesSinceChange++;
+        if (!enabled)
+            return;
+
+        float frameMs = std::max(cpuMs, gpuMs);
+        float ratio = frameMs / targetMs;
+        if (ratio > degradeThreshold && level + 1 < levels.size() && framesSinceChange >= degradeCooldown)
+            change(level + 1);
+        else if (ratio < improveThreshold && level > 0 && framesSinceChange >= improveCooldown)
+            change(level - 1);
+    }
+
+    void change(unsigned int newLevel)
+    {
+        const QualityLevel& q = levels[newLevel];
+        logMessage(LOG_PERF, LOG_INFO, "GOVERNOR::cpu {} ms gpu {} ms (objetivo {}) -> {} a nivel {}",
+                   cpuMs, gpuMs, targetMs, newLevel > level ? "bajar" : "subir", newLevel);
+        logMessage(LOG_PERF, LOG_INFO, "GOVERNOR::nivel {}: escala {}, lod bias {}, caras de sombra {}, luces {}",
+                   newLevel, q.renderScale, q.lodBias, q.shadowBudget, q.maxLights);
+        level = newLevel;
+        framesSinceChange = 0;
+    }
+};
+
+#endif
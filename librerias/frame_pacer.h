@@ -0,0 +1,105 @@
+#ifndef FRAME_PACER_H
+#define FRAME_PACER_H
+
+#include <glad/glad.h>
+
+#include <deque>
+#include <chrono>
+#include <thread>
+#include <algorithm>
+#include <iostream>
+
+// Control de la latencia entre la entrada y la imagen.
+//
+// Sin limite el driver puede encolar varios frames por delante de la GPU y el raton se ve con ese
+// retraso. Despues de cada swap se pone un fence; al empezar el siguiente frame se espera a que la
+// GPU haya terminado los frames necesarios para que no haya mas de maxFramesInFlight en cola
+// (1 = minima latencia, 2 = mas margen para solapar CPU y GPU).
+// Con targetFps > 0 ademas se limita la frecuencia: se duerme hasta poco antes del instante del
+// frame y el resto se espera activamente (sleep no es preciso). La entrada se lee despues de
+// beginFrame, asi se muestrea lo mas tarde posible antes de dibujar.
+class FramePacer
+{
+public:
+    unsigned int maxFramesInFlight = 1;   // 1 o 2
+    float targetFps = 0.0f;               // 0 = sin limitador
+    float spinMs = 1.5f;                  // margen final de espera activa
+
+    // Tiempo esperado en el ultimo frame (ms)
+    float fenceWaitMs = 0.0f;
+    float limiterWaitMs = 0.0f;
+
+    FramePacer() = default;
+
+    ~FramePacer()
+    {
+        for (GLsync fence : fences)
+            glDeleteSync(fence);
+    }
+
+    FramePacer(const FramePacer&) = delete;
+    FramePacer& operator=(const FramePacer&) = delete;
+
+    // Al principio del frame, antes de leer la entrada
+    void beginFrame()
+    {
+        auto start = std::chrono::steady_clock::now();
+        unsigned int inFlight = std::max(1u, std::min(maxFramesInFlight, 2u));
+        while (fences.size() >= inFlight)
+        {
+            waitFence(fences.front());
+            glDeleteSync(fences.front());
+            fences.pop_front();
+        }
+        auto afterFences = std::chrono::steady_clock::now();
+        fenceWaitMs = std::chrono::duration<float, std::milli>(afterFences - start).count();
+
+        limiterWaitMs = 0.0f;
+        if (targetFps > 0.0f)
+        {
+            auto period = std::chrono::duration_cast<std::chrono::steady_clock::duration>(std::chrono::duration<float>(1.0f / targetFps));
+            // Si vamos muy atrasados no se intenta recuperar el tiempo perdido
+            if (nextFrame < afterFences - period)
+                nextFrame = afterFences;
+            auto spinStart = nextFrame - std::chrono::duration_cast<std::chrono::steady_clock::duration>(std::chrono::duration<float, std::milli>(spinMs));
+            if (afterFences < spinStart)
+                std::this_thread::sleep_for(spinStart - afterFences);
+            while (std::chrono::steady_clock::now() < nextFrame)
+                ;
+            limiterWaitMs = std::chrono::duration<float, std::milli>(std::chrono::steady_clock::now() - afterFences).count();
+            nextFrame += period;
+        }
+    }
+
+    // Justo despues de glfwSwapBuffers
+    void endFrame()
+    {
+        GLsync fence = glFenceSync(GL_SYNC_GPU_COMMANDS_COMPLETE, 0);
+        if (fence)
+            fences.push_back(fence);
+    }
+
+private:
+    std::deque<GLsync> fences;
+    std::chrono::steady_clock::time_point nextFrame;
+
+    static void waitFence(GLsync fence)
+    {
+        // El primer intento vacia los comandos pendientes para que el fence llegue a la GPU
+        GLbitfield flags = GL_SYNC_FLUSH_COMMANDS_BIT;
+        for (;;)
+        {
+            GLenum result = glClientWaitSync(fence, flags, 100000000);  // 100 ms
+            if (result == GL_ALREADY_SIGNALED || result == GL_CONDITION_SATISFIED)
+                return;
+            if (result == GL_WAIT_FAILED)
+            {
+                std::cout << "PACER::glClientWaitSync fallo" << std::endl;
+                return;
+            }
+            flags = 0;
+        }
+    }
+};
+
+#endif
@@ -0,0 +1,187 @@
+#ifndef FRUSTUM_CULLING_H
+#define FRUSTUM_CULLING_H
+
+#include <glm/glm.hpp>
+
+#include <learnopengl/shader.h>
+#include <learnopengl/model.h>
+
+#include <vector>
+#include <cfloat>
+#include <cmath>
+
+// SSE esta disponible en todos los compiladores x86/x64 que usamos (MSVC, gcc, clang)
+#if defined(_M_X64) || defined(_M_IX86) || defined(__SSE__)
+#include <xmmintrin.h>
+#define FRUSTUM_CULLING_SSE 1
+#endif
+
+// Caja envolvente alineada a los ejes
+struct AABB
+{
+    glm::vec3 min;
+    glm::vec3 max;
+};
+
+// Contadores del culling de un frame
+struct CullingStats
+{
+    unsigned int tested = 0;
+    unsigned int culled = 0;
+    unsigned int pvsCulled = 0;
+    unsigned int portalCulled = 0;
+    unsigned int occluded = 0;
+    unsigned int drawn = 0;
+
+    void reset()
+    {
+        tested = culled = pvsCulled = portalCulled = occluded = drawn = 0;
+    }
+};
+
+// Caja envolvente de un mesh en coordenadas locales del modelo
+inline AABB computeMeshAABB(const Mesh& mesh)
+{
+    AABB box;
+    box.min = glm::vec3(FLT_MAX);
+    box.max = glm::vec3(-FLT_MAX);
+    for (const Vertex& vertex : mesh.vertices)
+    {
+        box.min = glm::min(box.min, vertex.Position);
+        box.max = glm::max(box.max, vertex.Position);
+    }
+    if (mesh.vertices.empty())
+        box.min = box.max = glm::vec3(0.0f);
+    return box;
+}
+
+// Transforma una caja a otro espacio (metodo de Arvo): sigue siendo una AABB que contiene la original
+inline AABB transformAABB(const AABB& box, const glm::mat4& m)
+{
+    glm::vec3 center = (box.min + box.max) * 0.5f;
+    glm::vec3 extent = (box.max - box.min) * 0.5f;
+
+    glm::vec3 newCenter = glm::vec3(m * glm::vec4(center, 1.0f));
+    glm::vec3 newExtent;
+    for (int row = 0; row < 3; row++)
+    {
+        newExtent[row] = std::fabs(m[0][row]) * extent.x
+                       + std::fabs(m[1][row]) * extent.y
+                       + std::fabs(m[2][row]) * extent.z;
+    }
+
+    AABB result;
+    result.min = newCenter - newExtent;
+    result.max = newCenter + newExtent;
+    return result;
+}
+
+// Caja local que contiene todos los meshes del modelo (para props que se mueven cada frame)
+inline AABB computeModelAABB(const Model& model)
+{
+    AABB box;
+    box.min = glm::vec3(FLT_MAX);
+    box.max = glm::vec3(-FLT_MAX);
+    for (const Mesh& mesh : model.meshes)
+    {
+        AABB meshBox = computeMeshAABB(mesh);
+        box.min = glm::min(box.min, meshBox.min);
+        box.max = glm::max(box.max, meshBox.max);
+    }
+    if (model.meshes.empty())
+        box.min = box.max = glm::vec3(0.0f);
+    return box;
+}
+
+// Calcula (una sola vez, al cargar) las cajas de todos los meshes ya transformadas por la matriz del modelo
+inline std::vector<AABB> computeModelBounds(const Model& model, const glm::mat4& modelMatrix)
+{
+    std::vector<AABB> bounds;
+    bounds.reserve(model.meshes.size());
+    for (const Mesh& mesh : model.meshes)
+        bounds.push_back(transformAABB(computeMeshAABB(mesh), modelMatrix));
+    return bounds;
+}
+
+// Frustum de la camara. Los planos se guardan en formato SoA (x, y, z, d por separado)
+// para probar 4 planos a la vez con SSE. Hay 8 ranuras: 6 planos reales y 2 de relleno
+// que nunca rechazan nada.
+struct Frustum
+{
+    alignas(16) float nx[8];
+    alignas(16) float ny[8];
+    alignas(16) float nz[8];
+    alignas(16) float d[8];
+
+    // Extrae los planos de projection * view (Gribb/Hartmann). Las normales apuntan hacia dentro.
+    void update(const glm::mat4& viewProjection)
+    {
+        const glm::mat4& m = viewProjection;
+        glm::vec4 row0(m[0][0], m[1][0], m[2][0], m[3][0]);
+        glm::vec4 row1(m[0][1], m[1][1], m[2][1], m[3][1]);
+        glm::vec4 row2(m[0][2], m[1][2], m[2][2], m[3][2]);
+        glm::vec4 row3(m[0][3], m[1][3], m[2][3], m[3][3]);
+
+        glm::vec4 planes[6] = {
+            row3 + row0,  // izquierdo
+            row3 - row0,  // derecho
+            row3 + row1,  // inferior
+            row3 - row1,  // superior
+            row3 + row2,  // cercano
+            row3 - row2   // lejano
+        };
+
+        for (int i = 0; i < 8; i++)
+        {
+            glm::vec4 p = i < 6 ? planes[i] : glm::vec4(0.0f, 0.0f, 0.0f, 1.0f);
+            float length = glm::length(glm::vec3(p));
+            if (length > 0.0f && i < 6)
+                p /= length;
+            nx[i] = p.x;
+            ny[i] = p.y;
+            nz[i] = p.z;
+            d[i] = p.w;
+        }
+    }
+
+    // true si la caja esta (al menos en parte) dentro del frustum
+    bool intersects(const AABB& box) const
+    {
+        glm::vec3 c = (box.min + box.max) * 0.5f;
+        glm::vec3 e = (box.max - box.min) * 0.5f;
+
+#ifdef FRUSTUM_CULLING_SSE
+        const __m128 signMask = _mm_set1_ps(-0.0f);
+        __m128 cx = _mm_set1_ps(c.x), cy = _mm_set1_ps(c.y), cz = _mm_set1_ps(c.z);
+        __m128 ex = _mm_set1_ps(e.x), ey = _mm_set1_ps(e.y), ez = _mm_set1_ps(e.z);
+        for (int i = 0; i < 8; i += 4)
+        {
+            __m128 px = _mm_load_ps(nx + i);
+            __m128 py = _mm_load_ps(ny + i);
+            __m128 pz = _mm_load_ps(nz + i);
+            __m128 pd = _mm_load_ps(d + i);
+
+            // distancia del centro al plano + radio proyectado de la caja sobre la normal
+            __m128 dist = _mm_add_ps(_mm_add_ps(_mm_mul_ps(px, cx), _mm_mul_ps(py, cy)), _mm_add_ps(_mm_mul_ps(pz, cz), pd));
+            __m128 radius = _mm_add_ps(_mm_add_ps(_mm_mul_ps(_mm_andnot_ps(signMask, px), ex),
+                                                  _mm_mul_ps(_mm_andnot_ps(signMask, py), ey)),
+                                       _mm_mul_ps(_mm_andnot_ps(signMask, pz), ez));
+            __m128 outside = _mm_cmplt_ps(_mm_add_ps(dist, radius), _mm_setzero_ps());
+            if (_mm_movemask_ps(outside) != 0)
+                return false;
+        }
+        return true;
+#else
+        for (int i = 0; i < 6; i++)
+        {
+            float dist = nx[i] * c.x + ny[i] * c.y + nz[i] * c.z + d[i];
+            float radius = std::fabs(nx[i]) * e.x + std::fabs(ny[i]) * e.y + std::fabs(nz[i]) * e.z;
+            if (dist + radius < 0.0f)
+                return false;
+        }
+        return true;
+#endif
+    }
+};
+
+#endif
@@ -0,0 +1,962 @@
+#ifndef GLTF_MODEL_H
+#define GLTF_MODEL_H
+
+#include <glad/glad.h>
+#include <glm/glm.hpp>
+#include <glm/gtc/matrix_transform.hpp>
+#include <glm/gtc/type_ptr.hpp>
+
+#include <learnopengl/mesh.h>
+#include <learnopengl/frustum_culling.h>
+#include <learnopengl/render_queue.h>
+#include <learnopengl/shader_variants.h>
+#include <learnopengl/texture_cache.h>
+#include <learnopengl/lod.h>
+
+#include <vector>
+#include <map>
+#include <string>
+#include <fstream>
+#include <sstream>
+#include <algorithm>
+#include <iostream>
+#include <memory>
+#include <cstdlib>
+#include <cstdint>
+#include <cstring>
+#include <cfloat>
+
+#ifdef _WIN32
+#ifndef WIN32_LEAN_AND_MEAN
+#define WIN32_LEAN_AND_MEAN
+#endif
+#ifndef NOMINMAX
+#define NOMINMAX
+#endif
+#include <windows.h>
+#else
+#include <fcntl.h>
+#include <unistd.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#endif
+
+// Valor de un documento JSON. Solo lo necesario para leer un .gltf: los objetos se guardan en un
+// map y los numeros como double. Pedir una clave o un indice que no existe devuelve un valor nulo,
+// asi que se pueden encadenar sin comprobar cada paso (gltf["accessors"][3]["count"]).
+class JsonValue
+{
+public:
+    enum Type { JSON_NULL, JSON_BOOL, JSON_NUMBER, JSON_STRING, JSON_ARRAY, JSON_OBJECT };
+
+    Type type = JSON_NULL;
+    bool boolean = false;
+    double number = 0.0;
+    std::string string;
+    std::vector<JsonValue> array;
+    std::map<std::string, JsonValue> object;
+
+    bool isNull() const { return type == JSON_NULL; }
+    bool has(const std::string& key) const { return object.count(key) > 0; }
+    size_t size() const { return type == JSON_ARRAY ? array.size() : object.size(); }
+
+    const JsonValue& operator[](const std::string& key) const
+    {
+        auto it = object.find(key);
+        return it != object.end() ? it->second : null();
+    }
+
+    const JsonValue& operator[](size_t index) const
+    {
+        return index < array.size() ? array[index] : null();
+    }
+
+    double asNumber(double fallback = 0.0) const { return type == JSON_NUMBER ? number : fallback; }
+    int asInt(int fallback = -1) const { return type == JSON_NUMBER ? (int)number : fallback; }
+    const std::string& asString() const { return string; }
+
+    // false (y un mensaje con la posicion) si el texto no es JSON valido
+    static bool parse(const std::string& text, JsonValue& result)
+    {
+        size_t pos = 0;
+        if (!parseValue(text, pos, result, 0))
+        {
+            std::cout << "JSON::Error de sintaxis cerca de la posicion " << pos << std::endl;
+            return false;
+        }
+        skipSpace(text, pos);
+        return pos == text.size();
+    }
+
+private:
+    static const JsonValue& null()
+    {
+        static JsonValue value;
+        return value;
+    }
+
+    static void skipSpace(const std::string& text, size_t& pos)
+    {
+        while (pos < text.size() && (text[pos] == ' ' || text[pos] == '\t' || text[pos] == '\n' || text[pos] == '\r'))
+            pos++;
+    }
+
+    static bool parseValue(const std::string& text, size_t& pos, JsonValue& value, int depth)
+    {
+        skipSpace(text, pos);
+        if (pos >= text.size() || depth > 64)
+            return false;
+        char c = text[pos];
+        if (c == '{')
+        {
+            value.type = JSON_OBJECT;
+            pos++;
+            skipSpace(text, pos);
+            if (pos < text.size() && text[pos] == '}')
+            {
+                pos++;
+                return true;
+            }
+            for (;;)
+            {
+                std::string key;
+                skipSpace(text, pos);
+                if (!parseString(text, pos, key))
+                    return false;
+                skipSpace(text, pos);
+                if (pos >= text.size() || text[pos] != ':')
+                    return false;
+                pos++;
+                if (!parseValue(text, pos, value.object[key], depth + 1))
+                    return false;
+                skipSpace(text, pos);
+                if (pos < text.size() && text[pos] == ',')
+                    pos++;
+                else if (pos < text.size() && text[pos] == '}')
+                {
+                    pos++;
+                    return true;
+                }
+                else
+                    return false;
+            }
+        }
+        if (c == '[')
+        {
+            value.type = JSON_ARRAY;
+            pos++;
+            skipSpace(text, pos);
+            if (pos < text.size() && text[pos] == ']')
+            {
+                pos++;
+                return true;
+            }
+            for (;;)
+            {
+                value.array.emplace_back();
+                if (!parseValue(text, pos, value.array.back(), depth + 1))
+                    return false;
+                skipSpace(text, pos);
+                if (pos < text.size() && text[pos] == ',')
+                    pos++;
+                else if (pos < text.size() && text[pos] == ']')
+                {
+                    pos++;
+                    return true;
+                }
+                else
+                    return false;
+            }
+        }
+        if (c == '"')
+        {
+            value.type = JSON_STRING;
+            return parseString(text, pos, value.string);
+        }
+        if (text.compare(pos, 4, "true") == 0 || text.compare(pos, 5, "false") == 0)
+        {
+            value.type = JSON_BOOL;
+            value.boolean = c == 't';
+            pos += value.boolean ? 4 : 5;
+            return true;
+        }
+        if (text.compare(pos, 4, "null") == 0)
+        {
+            pos += 4;
+            return true;
+        }
+        char* end = nullptr;
+        value.number = std::strtod(text.c_str() + pos, &end);
+        if (end == text.c_str() + pos)
+            return false;
+        value.type = JSON_NUMBER;
+        pos = end - text.c_str();
+        return true;
+    }
+
+    // Cadena entre comillas; los \uXXXX se pasan a UTF-8 (sin pares sustitutos, no salen en un glTF)
+    static bool parseString(const std::string& text, size_t& pos, std::string& result)
+    {
+        if (pos >= text.size() || text[pos] != '"')
+            return false;
+        pos++;
+        while (pos < text.size() && text[pos] != '"')
+        {
+            char c = text[pos++];
+            if (c != '\\')
+            {
+                result += c;
+                continue;
+            }
+            if (pos >= text.size())
+                return false;
+            char escape = text[pos++];
+            switch (escape)
+            {
+            case 'b': result += '\b'; break;
+            case 'f': result += '\f'; break;
+            case 'n': result += '\n'; break;
+            case 'r': result += '\r'; break;
+            case 't': result += '\t'; break;
+            case 'u':
+            {
+                if (pos + 4 > text.size())
+                    return false;
+                unsigned int code = (unsigned int)std::strtoul(text.substr(pos, 4).c_str(), nullptr, 16);
+                pos += 4;
+                if (code < 0x80)
+                    result += (char)code;
+                else if (code < 0x800)
+                {
+                    result += (char)(0xC0 | (code >> 6));
+                    result += (char)(0x80 | (code & 0x3F));
+                }
+                else
+                {
+                    result += (char)(0xE0 | (code >> 12));
+                    result += (char)(0x80 | ((code >> 6) & 0x3F));
+                    result += (char)(0x80 | (code & 0x3F));
+                }
+                break;
+            }
+            default: result += escape; break;   // \" \\ \/
+            }
+        }
+        if (pos >= text.size())
+            return false;
+        pos++;
+        return true;
+    }
+};
+
+// Archivo de solo lectura proyectado en memoria (mmap, o MapViewOfFile en Windows). Si no se puede
+// proyectar (archivo vacio, sistema de archivos raro) se lee entero a memoria.
+class MappedFile
+{
+public:
+    explicit MappedFile(const std::string& path)
+    {
+#ifdef _WIN32
+        file = CreateFileA(path.c_str(), GENERIC_READ, FILE_SHARE_READ, nullptr, OPEN_EXISTING, FILE_ATTRIBUTE_NORMAL, nullptr);
+        if (file != INVALID_HANDLE_VALUE)
+        {
+            LARGE_INTEGER fileSize;
+            if (GetFileSizeEx(file, &fileSize) && fileSize.QuadPart > 0)
+            {
+                mapping = CreateFileMappingA(file, nullptr, PAGE_READONLY, 0, 0, nullptr);
+                if (mapping)
+                    view = MapViewOfFile(mapping, FILE_MAP_READ, 0, 0, 0);
+                if (view)
+                {
+                    bytes = (const unsigned char*)view;
+                    length = (size_t)fileSize.QuadPart;
+                    return;
+                }
+            }
+        }
+#else
+        int fd = open(path.c_str(), O_RDONLY);
+        if (fd >= 0)
+        {
+            struct stat info;
+            if (fstat(fd, &info) == 0 && info.st_size > 0)
+            {
+                void* address = mmap(nullptr, (size_t)info.st_size, PROT_READ, MAP_PRIVATE, fd, 0);
+                if (address != MAP_FAILED)
+                {
+                    view = address;
+                    bytes = (const unsigned char*)address;
+                    length = (size_t)info.st_size;
+                }
+            }
+            close(fd);   // la proyeccion sigue valida
+            if (view)
+                return;
+        }
+#endif
+        std::ifstream in(path, std::ios::binary);
+        if (!in)
+            return;
+        fallback.assign(std::istreambuf_iterator<char>(in), std::istreambuf_iterator<char>());
+        bytes = fallback.data();
+        length = fallback.size();
+        opened = true;
+    }
+
+    ~MappedFile()
+    {
+#ifdef _WIN32
+        if (view)
+            UnmapViewOfFile(view);
+        if (mapping)
+            CloseHandle(mapping);
+        if (file != INVALID_HANDLE_VALUE)
+            CloseHandle(file);
+#else
+        if (view)
+            munmap(view, length);
+#endif
+    }
+
+    MappedFile(const MappedFile&) = delete;
+    MappedFile& operator=(const MappedFile&) = delete;
+
+    bool valid() const { return view != nullptr || opened; }
+    bool mapped() const { return view != nullptr; }
+    const unsigned char* data() const { return bytes; }
+    size_t size() const { return length; }
+
+private:
+#ifdef _WIN32
+    HANDLE file = INVALID_HANDLE_VALUE;
+    HANDLE mapping = nullptr;
+#endif
+    void* view = nullptr;
+    const unsigned char* bytes = nullptr;
+    size_t length = 0;
+    std::vector<unsigned char> fallback;
+    bool opened = false;
+};
+
+// Modelo glTF 2.0 (.gltf con sus .bin) cargado sin assimp.
+//
+// Los .bin se proyectan en memoria y cada bufferView que usan las primitivas se sube tal cual con
+// glBufferData desde la proyeccion: no se construyen Vertex ni se copian los datos. Los atributos se
+// leen directamente de esos buffers con el byteStride de su bufferView y el byteOffset de su
+// accessor, asi que da igual que vengan intercalados en un solo bufferView o en uno por atributo,
+// y tambien el tipo de componente (float, o enteros normalizados de KHR_mesh_quantization). Los
+// indices pueden ser de 8, 16 o 32 bits (ver DrawCommand::indexType).
+//
+// Los atributos van a las mismas posiciones que Mesh de learnopengl para usar house_static:
+// POSITION 0, NORMAL 1, TEXCOORD_0 2, TANGENT 3 (vec4: w es el signo de la bitangente, que el
+// shader calcula porque la posicion 4 queda sin datos).
+//
+// Materiales (pbrMetallicRoughness) con los tipos de textura de learnopengl y las variantes de
+// house_static:
+//   baseColorTexture          -> texture_diffuse (sin textura, una de 1x1 con baseColorFactor)
+//   metallicRoughnessTexture  -> texture_metallicRoughness
+//   normalTexture             -> texture_normal (solo en primitivas con TANGENT)
+//   emissiveTexture           -> texture_emissive
+// Las imagenes se piden a la TextureCache (compartidas con los demas modelos, cocinadas si hay .ktx).
+// Los factores de color que acompanan a una textura, occlusionTexture y los samplers se ignoran, y
+// alphaMode MASK y BLEND se dibujan con alpha test (la cola no tiene pasada con mezcla).
+//
+// Niveles de detalle como LodModel: al cargar se leen POSITION y los indices de la proyeccion y se
+// simplifican con simplifyIndices. Los niveles simplificados van en un EBO de 32 bits por
+// primitiva con un segundo VAO sobre los mismos buffers de vertices; el nivel 0 es el original.
+// Las primitivas con POSITION cuantizada se quedan sin niveles (siempre el 0).
+//
+// No se cargan .glb, buffers o imagenes embebidos (data:), accessors sparse, morph targets, skins
+// ni animaciones; las primitivas que no son triangulos indexados se saltan con un mensaje.
+class GltfModel
+{
+public:
+    std::string directory;
+    AABB bounds;   // de toda la escena en coordenadas del modelo
+    float hysteresis = 0.15f;   // como LodModel::hysteresis
+
+    // ratios y thresholds de los niveles de detalle, como en LodModel
+    explicit GltfModel(const std::string& path, const std::vector<float>& ratios = { 1.0f, 0.5f, 0.25f, 0.1f },
+                       const std::vector<float>& thresholds = { 300.0f, 120.0f, 50.0f, 0.0f })
+        : lodRatios(ratios), thresholds(thresholds)
+    {
+        bounds.min = bounds.max = glm::vec3(0.0f);
+        directory = path.substr(0, path.find_last_of("/\\"));
+        if (directory == path)
+            directory = ".";
+        if (!load(path))
+            std::cout << "GLTF::No se pudo cargar " << path << std::endl;
+    }
+
+    ~GltfModel()
+    {
+        for (const Primitive& primitive : primitives)
+        {
+            glDeleteVertexArrays(1, &primitive.original.vao);
+            if (primitive.lodVao)
+            {
+                glDeleteVertexArrays(1, &primitive.lodVao);
+                glDeleteBuffers(1, &primitive.lodEBO);
+            }
+        }
+        for (GLuint buffer : viewBuffers)
+            if (buffer)
+                glDeleteBuffers(1, &buffer);
+        for (GLuint id : acquired)
+            TextureCache::instance().release(id);
+        if (!ownTextures.empty())
+            glDeleteTextures((GLsizei)ownTextures.size(), ownTextures.data());
+    }
+
+    GltfModel(const GltfModel&) = delete;
+    GltfModel& operator=(const GltfModel&) = delete;
+
+    bool loaded() const { return !draws.empty(); }
+
+    // Mascaras de MaterialFeature de todas las primitivas (para compilar las variantes al cargar)
+    std::vector<unsigned int> featureMasks() const
+    {
+        std::vector<unsigned int> masks;
+        for (const Primitive& primitive : primitives)
+            if (std::find(masks.begin(), masks.end(), primitive.features) == masks.end())
+                masks.push_back(primitive.features);
+        return masks;
+    }
+
+    size_t materialCount() const { return materials.size(); }
+    const std::vector<Texture>& materialTextures(size_t material) const { return materials[material]; }
+
+    unsigned int levelCount() const { return (unsigned int)std::max<size_t>(lodRatios.size(), 1); }
+
+    size_t triangleCount(unsigned int level) const
+    {
+        size_t count = 0;
+        for (const DrawItem& item : draws)
+            count += range(primitives[item.primitive], level).indexCount / 3;
+        return count;
+    }
+
+    // Elige el nivel de una instancia igual que LodModel::selectLevel (con la caja de toda la escena)
+    unsigned int selectLevel(unsigned int instance, const glm::mat4& modelMatrix, const glm::vec3& cameraPos,
+                             float fovYDegrees, float viewportHeight, float bias = 0.0f)
+    {
+        if (instance >= currentLevel.size())
+            currentLevel.resize(instance + 1, 0);
+        unsigned int& level = currentLevel[instance];
+
+        float scale = std::max(glm::length(glm::vec3(modelMatrix[0])),
+                      std::max(glm::length(glm::vec3(modelMatrix[1])), glm::length(glm::vec3(modelMatrix[2]))));
+        glm::vec3 center = glm::vec3(modelMatrix * glm::vec4((bounds.min + bounds.max) * 0.5f, 1.0f));
+        float size = projectedSize(center, glm::length(bounds.max - bounds.min) * 0.5f * scale, cameraPos, fovYDegrees, viewportHeight);
+        if (size < FLT_MAX)
+            size *= std::pow(2.0f, -bias);
+
+        level = stepLodLevel(level, size, thresholds, levelCount(), hysteresis);
+        return level;
+    }
+
+    // Encola todas las primitivas de la escena al nivel indicado, cada una con la variante de su
+    // material. Con conditionalQuery se dibujan con render condicional (ver OcclusionCuller::test).
+    void submit(RenderQueue& queue, ShaderVariants& variants, const glm::mat4& modelMatrix, const glm::vec3& cameraPos,
+                unsigned int level = 0, GLuint conditionalQuery = 0)
+    {
+        for (const DrawItem& item : draws)
+        {
+            const Primitive& primitive = primitives[item.primitive];
+            const Range& drawRange = range(primitive, level);
+            glm::mat4 world = modelMatrix * item.transform;
+            AABB box = transformAABB(primitive.bounds, world);
+            float depth = glm::length((box.min + box.max) * 0.5f - cameraPos);
+            queue.submitDraw(RENDER_PASS_OPAQUE, variants.get(primitive.features).ID, drawRange.vao, drawRange.indexCount,
+                             drawRange.indexOffset, materials[primitive.material], world, depth, conditionalQuery)
+                 .setIndexType(drawRange.indexType);
+        }
+    }
+
+    // Dibuja toda la escena directamente con el programa de shader, que ya tiene que estar activo
+    // (sombras, sin texturas); shader recibe la matriz "model" de cada primitiva
+    template <typename ShaderType>
+    void drawAll(ShaderType& shader, const glm::mat4& modelMatrix, unsigned int level = 0) const
+    {
+        for (const DrawItem& item : draws)
+        {
+            const Range& drawRange = range(primitives[item.primitive], level);
+            shader.setMat4("model", modelMatrix * item.transform);
+            glBindVertexArray(drawRange.vao);
+            glDrawElements(GL_TRIANGLES, drawRange.indexCount, drawRange.indexType, (void*)drawRange.indexOffset);
+        }
+        glBindVertexArray(0);
+    }
+
+private:
+    struct Range
+    {
+        GLuint vao = 0;
+        GLsizei indexCount = 0;
+        size_t indexOffset = 0;   // en bytes
+        GLenum indexType = GL_UNSIGNED_INT;
+    };
+
+    struct Primitive
+    {
+        Range original;              // nivel 0: el EBO y el tipo de indice del glTF
+        std::vector<Range> lods;     // niveles 1.. (vacio si no se pudo simplificar)
+        GLuint lodVao = 0;           // el de los niveles simplificados, con lodEBO
+        GLuint lodEBO = 0;
+        size_t material = 0;
+        unsigned int features = 0;
+        AABB bounds;
+    };
+
+    // Una primitiva colocada por un nodo de la escena
+    struct DrawItem
+    {
+        size_t primitive;
+        glm::mat4 transform;
+    };
+
+    std::vector<GLuint> viewBuffers;              // un buffer de GL por bufferView usado (0 si no)
+    std::vector<Primitive> primitives;
+    std::vector<std::vector<size_t>> meshPrimitives;
+    std::vector<DrawItem> draws;
+    std::vector<std::vector<Texture>> materials;
+    std::vector<unsigned int> materialFlags;      // MATERIAL_ALPHA_TEST si alphaMode no es OPAQUE
+    std::vector<GLuint> acquired;                 // referencias en la TextureCache
+    std::vector<GLuint> ownTextures;              // texturas de 1x1 de baseColorFactor
+    std::vector<float> lodRatios;
+    std::vector<float> thresholds;
+    std::vector<unsigned int> currentLevel;       // por instancia
+
+    const Range& range(const Primitive& primitive, unsigned int level) const
+    {
+        if (level == 0 || primitive.lods.empty())
+            return primitive.original;
+        return primitive.lods[std::min<size_t>(level, primitive.lods.size()) - 1];
+    }
+
+    bool load(const std::string& path)
+    {
+        std::ifstream in(path, std::ios::binary);
+        if (!in)
+            return false;
+        std::stringstream text;
+        text << in.rdbuf();
+        JsonValue gltf;
+        if (!JsonValue::parse(text.str(), gltf))
+            return false;
+        if (gltf["asset"]["version"].asString().compare(0, 2, "2.") != 0)
+        {
+            std::cout << "GLTF::" << path << " no es glTF 2.0" << std::endl;
+            return false;
+        }
+
+        // Proyeccion de cada buffer (solo se leen mientras se suben los bufferViews y se simplifican los niveles)
+        std::vector<std::unique_ptr<MappedFile>> buffers;
+        for (const JsonValue& buffer : gltf["buffers"].array)
+        {
+            const std::string& uri = buffer["uri"].asString();
+            if (uri.empty() || uri.compare(0, 5, "data:") == 0)
+            {
+                std::cout << "GLTF::Buffers embebidos o .glb no soportados en " << path << std::endl;
+                buffers.emplace_back();
+                continue;
+            }
+            buffers.emplace_back(new MappedFile(directory + '/' + decodeUri(uri)));
+            if (!buffers.back()->valid() || buffers.back()->size() < (size_t)buffer["byteLength"].asNumber())
+            {
+                std::cout << "GLTF::No se pudo leer " << directory << '/' << uri << std::endl;
+                buffers.back().reset();
+            }
+        }
+
+        loadMaterials(gltf);
+
+        // Primitivas: primero se sube cada bufferView que usan, luego se hace su VAO
+        viewBuffers.assign(gltf["bufferViews"].size(), 0);
+        const JsonValue& meshes = gltf["meshes"];
+        meshPrimitives.resize(meshes.size());
+        for (size_t m = 0; m < meshes.size(); m++)
+            for (const JsonValue& primitive : meshes[m]["primitives"].array)
+            {
+                Primitive result;
+                if (buildPrimitive(gltf, buffers, primitive, result))
+                {
+                    meshPrimitives[m].push_back(primitives.size());
+                    primitives.push_back(result);
+                }
+                else
+                    std::cout << "GLTF::Primitiva del mesh " << m << " de " << path << " saltada" << std::endl;
+            }
+        glBindVertexArray(0);
+        glBindBuffer(GL_ARRAY_BUFFER, 0);
+
+        // Nodos de la escena por defecto (o de la primera) con su matriz acumulada
+        const JsonValue& scenes = gltf["scenes"];
+        const JsonValue& scene = scenes[(size_t)std::max(0, gltf["scene"].asInt(0))];
+        for (const JsonValue& node : scene["nodes"].array)
+            addNode(gltf, node.asInt(), glm::mat4(1.0f), 0);
+
+        bounds.min = glm::vec3(FLT_MAX);
+        bounds.max = glm::vec3(-FLT_MAX);
+        for (const DrawItem& item : draws)
+        {
+            AABB box = transformAABB(primitives[item.primitive].bounds, item.transform);
+            bounds.min = glm::min(bounds.min, box.min);
+            bounds.max = glm::max(bounds.max, box.max);
+        }
+        if (draws.empty())
+            bounds.min = bounds.max = glm::vec3(0.0f);
+
+        size_t uploaded = 0;
+        for (size_t i = 0; i < viewBuffers.size(); i++)
+            if (viewBuffers[i])
+                uploaded += (size_t)gltf["bufferViews"][i]["byteLength"].asNumber();
+        std::cout << "GLTF::" << path << ": " << primitives.size() << " primitivas, " << draws.size() << " instancias, "
+                  << materials.size() << " materiales, " << uploaded / 1024 << " KB de buffers subidos sin copia, triangulos por nivel:";
+        for (unsigned int l = 0; l < levelCount(); l++)
+            std::cout << " " << triangleCount(l);
+        std::cout << std::endl;
+        return !draws.empty();
+    }
+
+    // uri relativa con los %XX (espacios, acentos) ya decodificados
+    static std::string decodeUri(const std::string& uri)
+    {
+        std::string result;
+        for (size_t i = 0; i < uri.size(); i++)
+        {
+            if (uri[i] == '%' && i + 2 < uri.size())
+            {
+                result += (char)std::strtoul(uri.substr(i + 1, 2).c_str(), nullptr, 16);
+                i += 2;
+            }
+            else
+                result += uri[i];
+        }
+        return result;
+    }
+
+    void loadMaterials(const JsonValue& gltf)
+    {
+        for (const JsonValue& material : gltf["materials"].array)
+        {
+            std::vector<Texture> textures;
+            const JsonValue& pbr = material["pbrMetallicRoughness"];
+            if (!addTexture(gltf, pbr["baseColorTexture"], "texture_diffuse", textures))
+                textures.push_back(colorTexture(pbr["baseColorFactor"]));
+            addTexture(gltf, pbr["metallicRoughnessTexture"], "texture_metallicRoughness", textures);
+            addTexture(gltf, material["normalTexture"], "texture_normal", textures);
+            addTexture(gltf, material["emissiveTexture"], "texture_emissive", textures);
+            materials.push_back(textures);
+
+            const std::string& alphaMode = material["alphaMode"].asString();
+            materialFlags.push_back(alphaMode == "MASK" || alphaMode == "BLEND" ? MATERIAL_ALPHA_TEST : 0);
+        }
+
+        // Material por defecto de las primitivas sin "material": blanco
+        materials.push_back(std::vector<Texture>(1, colorTexture(JsonValue())));
+        materialFlags.push_back(0);
+    }
+
+    bool addTexture(const JsonValue& gltf, const JsonValue& info, const char* type, std::vector<Texture>& textures)
+    {
+        if (info.isNull())
+            return false;
+        if (info["texCoord"].asInt(0) != 0)
+            std::cout << "GLTF::" << type << " usa TEXCOORD_" << info["texCoord"].asInt() << ", se lee TEXCOORD_0" << std::endl;
+        const JsonValue& image = gltf["images"][(size_t)gltf["textures"][(size_t)info["index"].asInt()]["source"].asInt()];
+        const std::string& uri = image["uri"].asString();
+        if (uri.empty() || uri.compare(0, 5, "data:") == 0)
+        {
+            std::cout << "GLTF::Imagenes embebidas no soportadas (" << type << ")" << std::endl;
+            return false;
+        }
+        Texture texture;
+        texture.path = decodeUri(uri);
+        texture.type = type;
+        texture.id = TextureCache::instance().acquire(directory + '/' + texture.path);
+        if (!texture.id)
+            return false;
+        acquired.push_back(texture.id);
+        textures.push_back(texture);
+        return true;
+    }
+
+    // Textura de 1x1 con un color (RGBA de 0 a 1, blanco si no hay)
+    Texture colorTexture(const JsonValue& factor)
+    {
+        unsigned char color[4];
+        for (size_t i = 0; i < 4; i++)
+            color[i] = (unsigned char)(glm::clamp((float)factor[i].asNumber(1.0), 0.0f, 1.0f) * 255.0f + 0.5f);
+        GLenum format = color[3] == 255 ? GL_RGB : GL_RGBA;   // sin alfa, para que no active ALPHA_TEST
+
+        Texture texture;
+        glGenTextures(1, &texture.id);
+        glBindTexture(GL_TEXTURE_2D, texture.id);
+        glPixelStorei(GL_UNPACK_ALIGNMENT, 1);
+        glTexImage2D(GL_TEXTURE_2D, 0, format, 1, 1, 0, GL_RGBA, GL_UNSIGNED_BYTE, color);
+        glPixelStorei(GL_UNPACK_ALIGNMENT, 4);
+        glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_MIN_FILTER, GL_NEAREST);
+        glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_MAG_FILTER, GL_NEAREST);
+        glBindTexture(GL_TEXTURE_2D, 0);
+        texture.type = "texture_diffuse";
+        ownTextures.push_back(texture.id);
+        return texture;
+    }
+
+    // Buffer de GL de un bufferView, subido directamente desde la proyeccion del .bin la primera vez
+    GLuint viewBuffer(const JsonValue& gltf, const std::vector<std::unique_ptr<MappedFile>>& buffers, int viewIndex)
+    {
+        if (viewIndex < 0 || (size_t)viewIndex >= viewBuffers.size())
+            return 0;
+        if (viewBuffers[viewIndex])
+            return viewBuffers[viewIndex];
+
+        const JsonValue& view = gltf["bufferViews"][(size_t)viewIndex];
+        int bufferIndex = view["buffer"].asInt();
+        if (bufferIndex < 0 || (size_t)bufferIndex >= buffers.size() || !buffers[bufferIndex])
+            return 0;
+        const MappedFile& file = *buffers[bufferIndex];
+        size_t offset = (size_t)view["byteOffset"].asNumber(0.0);
+        size_t length = (size_t)view["byteLength"].asNumber();
+        if (offset + length > file.size())
+            return 0;
+
+        // Siempre por GL_ARRAY_BUFFER, que no es estado del VAO: se puede subir con el de la primitiva
+        // ya activo, y el buffer sirve igual luego como EBO
+        GLuint buffer;
+        glGenBuffers(1, &buffer);
+        glBindBuffer(GL_ARRAY_BUFFER, buffer);
+        glBufferData(GL_ARRAY_BUFFER, (GLsizeiptr)length, file.data() + offset, GL_STATIC_DRAW);
+        viewBuffers[viewIndex] = buffer;
+        return buffer;
+    }
+
+    static GLint componentCount(const std::string& type)
+    {
+        if (type == "SCALAR") return 1;
+        if (type == "VEC2") return 2;
+        if (type == "VEC3") return 3;
+        if (type == "VEC4") return 4;
+        return 0;
+    }
+
+    static GLsizei componentBytes(GLenum componentType)
+    {
+        switch (componentType)
+        {
+        case GL_BYTE: case GL_UNSIGNED_BYTE: return 1;
+        case GL_SHORT: case GL_UNSIGNED_SHORT: return 2;
+        case GL_UNSIGNED_INT: case GL_FLOAT: return 4;
+        default: return 0;
+        }
+    }
+
+    // Atributo en su posicion del VAO activo, leido del buffer de su bufferView
+    bool bindAttribute(const JsonValue& gltf, const std::vector<std::unique_ptr<MappedFile>>& buffers, int accessorIndex, GLuint location, GLint minComponents)
+    {
+        const JsonValue& accessor = gltf["accessors"][(size_t)accessorIndex];
+        GLint components = componentCount(accessor["type"].asString());
+        GLenum componentType = (GLenum)accessor["componentType"].asInt(0);
+        if (accessor.isNull() || accessor.has("sparse") || components < minComponents || componentBytes(componentType) == 0)
+            return false;
+        int viewIndex = accessor["bufferView"].asInt();
+        GLuint buffer = viewBuffer(gltf, buffers, viewIndex);
+        if (!buffer)
+            return false;
+
+        GLsizei stride = (GLsizei)gltf["bufferViews"][(size_t)viewIndex]["byteStride"].asNumber(0.0);   // 0 = seguidos
+        size_t offset = (size_t)accessor["byteOffset"].asNumber(0.0);
+        bool normalized = accessor["normalized"].boolean;
+        glBindBuffer(GL_ARRAY_BUFFER, buffer);
+        glEnableVertexAttribArray(location);
+        glVertexAttribPointer(location, components, componentType, normalized ? GL_TRUE : GL_FALSE, stride, (void*)offset);
+        return true;
+    }
+
+    bool buildPrimitive(const JsonValue& gltf, const std::vector<std::unique_ptr<MappedFile>>& buffers, const JsonValue& primitive, Primitive& result)
+    {
+        const JsonValue& attributes = primitive["attributes"];
+        if (primitive["mode"].asInt(4) != 4 || primitive["indices"].isNull() || !attributes.has("POSITION") || !attributes.has("NORMAL"))
+            return false;
+
+        // Indices: el EBO es el buffer de su bufferView y el offset del accessor va en el draw
+        const JsonValue& indices = gltf["accessors"][(size_t)primitive["indices"].asInt()];
+        GLenum indexType = (GLenum)indices["componentType"].asInt(0);
+        if (indices.has("sparse") || (indexType != GL_UNSIGNED_BYTE && indexType != GL_UNSIGNED_SHORT && indexType != GL_UNSIGNED_INT))
+            return false;
+        GLuint indexBuffer = viewBuffer(gltf, buffers, indices["bufferView"].asInt());
+        if (!indexBuffer)
+            return false;
+
+        bool tangents = false;
+        if (!buildVao(gltf, buffers, attributes, indexBuffer, result.original.vao, tangents))
+            return false;
+        result.original.indexCount = (GLsizei)indices["count"].asNumber();
+        result.original.indexOffset = (size_t)indices["byteOffset"].asNumber(0.0);
+        result.original.indexType = indexType;
+        buildLods(gltf, buffers, primitive, result);
+
+        int material = primitive["material"].asInt();
+        result.material = material >= 0 && (size_t)material < materials.size() - 1 ? (size_t)material : materials.size() - 1;
+        result.features = materialFeatures(materials[result.material]);
+        if (!tangents)
+            result.features &= ~MATERIAL_NORMAL_MAP;
+        if (!(materialFlags[result.material] & MATERIAL_ALPHA_TEST))
+            result.features &= ~MATERIAL_ALPHA_TEST;   // OPAQUE: el alfa de la textura no cuenta
+
+        // Caja de la primitiva con el min/max de POSITION (obligatorio en glTF)
+        const JsonValue& position = gltf["accessors"][(size_t)attributes["POSITION"].asInt()];
+        for (int i = 0; i < 3; i++)
+        {
+            result.bounds.min[i] = (float)position["min"][(size_t)i].asNumber(-FLT_MAX);
+            result.bounds.max[i] = (float)position["max"][(size_t)i].asNumber(FLT_MAX);
+        }
+        return true;
+    }
+
+    // VAO con los atributos de una primitiva (mismas posiciones que Mesh) y su EBO
+    bool buildVao(const JsonValue& gltf, const std::vector<std::unique_ptr<MappedFile>>& buffers, const JsonValue& attributes,
+                  GLuint indexBuffer, GLuint& vao, bool& tangents)
+    {
+        glGenVertexArrays(1, &vao);
+        glBindVertexArray(vao);
+        glBindBuffer(GL_ELEMENT_ARRAY_BUFFER, indexBuffer);
+        bool ok = bindAttribute(gltf, buffers, attributes["POSITION"].asInt(), 0, 3) &&
+                  bindAttribute(gltf, buffers, attributes["NORMAL"].asInt(), 1, 3);
+        if (ok && attributes.has("TEXCOORD_0"))
+            bindAttribute(gltf, buffers, attributes["TEXCOORD_0"].asInt(), 2, 2);
+        tangents = ok && attributes.has("TANGENT") && bindAttribute(gltf, buffers, attributes["TANGENT"].asInt(), 3, 4);
+        glBindVertexArray(0);
+        if (!ok)
+        {
+            glDeleteVertexArrays(1, &vao);
+            vao = 0;
+        }
+        return ok;
+    }
+
+    // Datos de un accessor en la proyeccion de su .bin: primer elemento y distancia entre elementos.
+    // nullptr si no estan enteros dentro de su bufferView y del archivo.
+    static const unsigned char* accessorData(const JsonValue& gltf, const std::vector<std::unique_ptr<MappedFile>>& buffers,
+                                             const JsonValue& accessor, size_t& stride, size_t& count)
+    {
+        const JsonValue& view = gltf["bufferViews"][(size_t)accessor["bufferView"].asInt()];
+        int bufferIndex = view["buffer"].asInt();
+        size_t element = (size_t)componentCount(accessor["type"].asString()) * componentBytes((GLenum)accessor["componentType"].asInt(0));
+        if (view.isNull() || element == 0 || bufferIndex < 0 || (size_t)bufferIndex >= buffers.size() || !buffers[bufferIndex])
+            return nullptr;
+        stride = (size_t)view["byteStride"].asNumber(0.0);
+        if (stride == 0)
+            stride = element;
+        count = (size_t)accessor["count"].asNumber(0.0);
+        size_t offset = (size_t)accessor["byteOffset"].asNumber(0.0);
+        size_t length = (size_t)view["byteLength"].asNumber(0.0);
+        size_t viewOffset = (size_t)view["byteOffset"].asNumber(0.0);
+        if (count == 0 || offset + stride * (count - 1) + element > length || viewOffset + length > buffers[bufferIndex]->size())
+            return nullptr;
+        return buffers[bufferIndex]->data() + viewOffset + offset;
+    }
+
+    // Niveles simplificados de una primitiva con POSITION en float (ver simplifyIndices)
+    void buildLods(const JsonValue& gltf, const std::vector<std::unique_ptr<MappedFile>>& buffers, const JsonValue& primitive, Primitive& result)
+    {
+        const JsonValue& attributes = primitive["attributes"];
+        const JsonValue& position = gltf["accessors"][(size_t)attributes["POSITION"].asInt()];
+        const JsonValue& indexAccessor = gltf["accessors"][(size_t)primitive["indices"].asInt()];
+        if (lodRatios.size() < 2 || position["componentType"].asInt(0) != GL_FLOAT || position["normalized"].boolean)
+            return;
+        size_t positionStride = 0, vertexCount = 0, indexStride = 0, indexCount = 0;
+        const unsigned char* positionData = accessorData(gltf, buffers, position, positionStride, vertexCount);
+        const unsigned char* indexData = accessorData(gltf, buffers, indexAccessor, indexStride, indexCount);
+        if (!positionData || !indexData)
+            return;
+
+        std::vector<glm::vec3> positions(vertexCount);
+        for (size_t v = 0; v < vertexCount; v++)
+            std::memcpy(&positions[v], positionData + v * positionStride, sizeof(glm::vec3));
+        std::vector<unsigned int> indices(indexCount);
+        for (size_t i = 0; i < indexCount; i++)
+        {
+            const unsigned char* index = indexData + i * indexStride;
+            if (result.original.indexType == GL_UNSIGNED_BYTE)
+                indices[i] = *index;
+            else if (result.original.indexType == GL_UNSIGNED_SHORT)
+            {
+                uint16_t value;
+                std::memcpy(&value, index, sizeof(value));
+                indices[i] = value;
+            }
+            else
+                std::memcpy(&indices[i], index, sizeof(unsigned int));
+            if (indices[i] >= vertexCount)
+                return;   // glTF invalido: mejor sin niveles
+        }
+
+        // Todos los niveles simplificados seguidos en un EBO
+        std::vector<unsigned int> allIndices;
+        for (size_t l = 1; l < lodRatios.size(); l++)
+        {
+            std::vector<unsigned int> levelIndices = simplifyIndices(positions, indices, (size_t)(indices.size() * lodRatios[l]));
+            Range lod;
+            lod.indexCount = (GLsizei)levelIndices.size();
+            lod.indexOffset = allIndices.size() * sizeof(unsigned int);
+            result.lods.push_back(lod);
+            allIndices.insert(allIndices.end(), levelIndices.begin(), levelIndices.end());
+        }
+
+        // El EBO se sube por GL_ARRAY_BUFFER, como los bufferViews (no toca ningun VAO)
+        glGenBuffers(1, &result.lodEBO);
+        glBindBuffer(GL_ARRAY_BUFFER, result.lodEBO);
+        glBufferData(GL_ARRAY_BUFFER, allIndices.size() * sizeof(unsigned int), allIndices.data(), GL_STATIC_DRAW);
+        bool tangents = false;
+        if (!buildVao(gltf, buffers, attributes, result.lodEBO, result.lodVao, tangents))
+        {
+            glDeleteBuffers(1, &result.lodEBO);
+            result.lodEBO = 0;
+            result.lods.clear();
+            return;
+        }
+        for (Range& lod : result.lods)
+            lod.vao = result.lodVao;
+    }
+
+    // Matriz local de un nodo: "matrix" o traslacion * rotacion (cuaternion x, y, z, w) * escala
+    static glm::mat4 nodeTransform(const JsonValue& node)
+    {
+        if (node.has("matrix"))
+        {
+            float values[16];
+            for (size_t i = 0; i < 16; i++)
+                values[i] = (float)node["matrix"][i].asNumber(i % 5 == 0 ? 1.0 : 0.0);
+            return glm::make_mat4(values);
+        }
+        const JsonValue& t = node["translation"];
+        const JsonValue& r = node["rotation"];
+        const JsonValue& s = node["scale"];
+        float x = (float)r[0].asNumber(0.0), y = (float)r[1].asNumber(0.0), z = (float)r[2].asNumber(0.0), w = (float)r[3].asNumber(1.0);
+        glm::mat4 rotation(glm::vec4(1.0f - 2.0f * (y * y + z * z), 2.0f * (x * y + z * w), 2.0f * (x * z - y * w), 0.0f),
+                           glm::vec4(2.0f * (x * y - z * w), 1.0f - 2.0f * (x * x + z * z), 2.0f * (y * z + x * w), 0.0f),
+                           glm::vec4(2.0f * (x * z + y * w), 2.0f * (y * z - x * w), 1.0f - 2.0f * (x * x + y * y), 0.0f),
+                           glm::vec4(0.0f, 0.0f, 0.0f, 1.0f));
+        glm::mat4 transform = glm::translate(glm::mat4(1.0f), glm::vec3(t[0].asNumber(0.0), t[1].asNumber(0.0), t[2].asNumber(0.0)));
+        transform = transform * rotation;
+        return glm::scale(transform, glm::vec3(s[0].asNumber(1.0), s[1].asNumber(1.0), s[2].asNumber(1.0)));
+    }
+
+    void addNode(const JsonValue& gltf, int index, const glm::mat4& parent, int depth)
+    {
+        const JsonValue& node = gltf["nodes"][(size_t)index];
+        if (index < 0 || node.isNull() || depth > 64)   // un glTF valido no tiene ciclos
+            return;
+        glm::mat4 transform = parent * nodeTransform(node);
+        int mesh = node["mesh"].asInt();
+        if (mesh >= 0 && (size_t)mesh < meshPrimitives.size())
+            for (size_t primitive : meshPrimitives[mesh])
+                draws.push_back({ primitive, transform });
+        for (const JsonValue& child : node["children"].array)
+            addNode(gltf, child.asInt(), transform, depth + 1);
+    }
+};
+
+#endif
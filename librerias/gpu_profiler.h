@@ -0,0 +1,235 @@
+#ifndef GPU_PROFILER_H
+#define GPU_PROFILER_H
+
+#include <glad/glad.h>
+
+#include <learnopengl/async_logger.h>
+
+#include <vector>
+#include <deque>
+#include <map>
+#include <string>
+#include <algorithm>
+
+// Tiempos de GPU por pasada con timer queries.
+//
+// Cada scope pone un GL_TIMESTAMP al empezar y otro al terminar (con GL_TIME_ELAPSED no se
+// pueden anidar, con timestamps si). Las queries de cada frame van a un slot de un anillo de
+// FRAME_LATENCY frames y se leen cuando el slot se vuelve a usar, asi que el resultado llega
+// unos frames tarde pero nunca se espera a la GPU: si todavia no esta listo el frame se descarta.
+// De cada pasada se guardan los ultimos HISTORY tiempos para sacar media y percentiles.
+class GpuProfiler
+{
+public:
+    static const int FRAME_LATENCY = 4;
+    static const int HISTORY = 120;
+
+    struct PassStats
+    {
+        std::string name;
+        int depth = 0;
+        float history[HISTORY] = {};
+        unsigned int count = 0;
+        unsigned int next = 0;
+
+        float last() const { return count ? history[(next + HISTORY - 1) % HISTORY] : 0.0f; }
+
+        float average() const
+        {
+            float sum = 0.0f;
+            for (unsigned int i = 0; i < count; i++)
+                sum += history[i];
+            return count ? sum / count : 0.0f;
+        }
+
+        // p entre 0 y 1
+        float percentile(float p) const
+        {
+            if (!count)
+                return 0.0f;
+            std::vector<float> sorted(history, history + count);
+            size_t k = std::min((size_t)(p * (count - 1) + 0.5f), sorted.size() - 1);
+            std::nth_element(sorted.begin(), sorted.begin() + k, sorted.end());
+            return sorted[k];
+        }
+    };
+
+    bool enabled = true;
+    unsigned int droppedFrames = 0;   // frames cuyo resultado no estaba listo al reutilizar el slot
+    unsigned int resolvedFrames = 0;  // frames leidos hasta ahora
+
+    GpuProfiler() = default;
+
+    ~GpuProfiler()
+    {
+        for (FrameSlot& slot : slots)
+            if (!slot.queries.empty())
+                glDeleteQueries((GLsizei)slot.queries.size(), slot.queries.data());
+    }
+
+    GpuProfiler(const GpuProfiler&) = delete;
+    GpuProfiler& operator=(const GpuProfiler&) = delete;
+
+    // Abre el scope "frame" que engloba el resto
+    void beginFrame()
+    {
+        current = (current + 1) % FRAME_LATENCY;
+        resolve(slots[current]);
+        frameScope = begin("frame");
+    }
+
+    void endFrame()
+    {
+        end(frameScope);
+    }
+
+    // Devuelve el indice del scope para cerrarlo con end (-1 si esta desactivado)
+    int begin(const char* name)
+    {
+        if (!enabled)
+            return -1;
+        FrameSlot& slot = slots[current];
+        Scope scope;
+        scope.pass = passIndex(name, openScopes);
+        scope.startQuery = nextQuery(slot);
+        glQueryCounter(slot.queries[scope.startQuery], GL_TIMESTAMP);
+        slot.scopes.push_back(scope);
+        openScopes++;
+        return (int)slot.scopes.size() - 1;
+    }
+
+    void end(int scope)
+    {
+        if (scope < 0)
+            return;
+        FrameSlot& slot = slots[current];
+        slot.scopes[scope].endQuery = nextQuery(slot);
+        glQueryCounter(slot.queries[slot.scopes[scope].endQuery], GL_TIMESTAMP);
+        openScopes--;
+    }
+
+    // Tiempo de GPU del ultimo frame resuelto (ms), -1 si aun no hay ninguno
+    float frameMs() const
+    {
+        return passes.empty() || !passes[0].count ? -1.0f : passes[0].last();
+    }
+
+    const std::deque<PassStats>& stats() const { return passes; }
+
+    // Por el log asincrono: los nombres van como puntero, por eso passes es un deque (sus elementos
+    // no se mueven al crecer) y el profiler tiene que seguir vivo hasta que se escriban
+    void report() const
+    {
+        static const char* spaces = "                ";
+        for (const PassStats& pass : passes)
+        {
+            logMessage(LOG_PERF, LOG_INFO, "GPU - {}{}: media {} ms p50 {} p95 {} p99 {}",
+                       spaces + 16 - std::min(pass.depth * 2, 16), pass.name.c_str(), pass.average(),
+                       pass.percentile(0.5f), pass.percentile(0.95f), pass.percentile(0.99f));
+        }
+        if (droppedFrames)
+            logMessage(LOG_PERF, LOG_INFO, "GPU - frames descartados (resultado no disponible): {}", droppedFrames);
+    }
+
+private:
+    struct Scope
+    {
+        int pass = 0;
+        unsigned int startQuery = 0;
+        unsigned int endQuery = 0;
+    };
+
+    struct FrameSlot
+    {
+        std::vector<GLuint> queries;
+        unsigned int usedQueries = 0;
+        std::vector<Scope> scopes;
+    };
+
+    FrameSlot slots[FRAME_LATENCY];
+    int current = 0;
+    int frameScope = -1;
+    int openScopes = 0;
+    std::deque<PassStats> passes;
+    std::map<std::string, int> passIds;
+    std::vector<float> frameTimes;   // suma por pasada del frame que se resuelve
+
+    int passIndex(const char* name, int depth)
+    {
+        auto it = passIds.find(name);
+        if (it != passIds.end())
+            return it->second;
+        int id = (int)passes.size();
+        passIds[name] = id;
+        passes.push_back(PassStats());
+        passes.back().name = name;
+        passes.back().depth = depth;
+        return id;
+    }
+
+    static unsigned int nextQuery(FrameSlot& slot)
+    {
+        if (slot.usedQueries == slot.queries.size())
+        {
+            GLuint query = 0;
+            glGenQueries(1, &query);
+            slot.queries.push_back(query);
+        }
+        return slot.usedQueries++;
+    }
+
+    // Lee los tiempos de un slot antiguo (sin esperar) y lo deja vacio para el frame nuevo
+    void resolve(FrameSlot& slot)
+    {
+        if (!slot.scopes.empty())
+        {
+            GLint available = 0;
+            glGetQueryObjectiv(slot.queries[slot.usedQueries - 1], GL_QUERY_RESULT_AVAILABLE, &available);
+            if (!available)
+            {
+                droppedFrames++;
+            }
+            else
+            {
+                frameTimes.assign(passes.size(), -1.0f);
+                for (const Scope& scope : slot.scopes)
+                {
+                    GLuint64 start = 0, end = 0;
+                    glGetQueryObjectui64v(slot.queries[scope.startQuery], GL_QUERY_RESULT, &start);
+                    glGetQueryObjectui64v(slot.queries[scope.endQuery], GL_QUERY_RESULT, &end);
+                    float ms = (float)(end - start) / 1.0e6f;
+                    frameTimes[scope.pass] = std::max(frameTimes[scope.pass], 0.0f) + ms;
+                }
+                for (unsigned int i = 0; i < passes.size(); i++)
+                {
+                    if (frameTimes[i] < 0.0f)
+                        continue;
+                    PassStats& pass = passes[i];
+                    pass.history[pass.next] = frameTimes[i];
+                    pass.next = (pass.next + 1) % HISTORY;
+                    pass.count = std::min(pass.count + 1, (unsigned int)HISTORY);
+                }
+                resolvedFrames++;
+            }
+        }
+        slot.scopes.clear();
+        slot.usedQueries = 0;
+    }
+};
+
+// Scope RAII: GpuScope scope(profiler, "sombras");
+class GpuScope
+{
+public:
+    GpuScope(GpuProfiler& profiler, const char* name) : profiler(profiler), scope(profiler.begin(name)) {}
+    ~GpuScope() { profiler.end(scope); }
+
+    GpuScope(const GpuScope&) = delete;
+    GpuScope& operator=(const GpuScope&) = delete;
+
+private:
+    GpuProfiler& profiler;
+    int scope;
+};
+
+#endif
@@ -0,0 +1,193 @@
+#ifndef INPUT_RECORDER_H
+#define INPUT_RECORDER_H
+
+#include <GLFW/glfw3.h>
+#include <glm/glm.hpp>
+
+#include <vector>
+#include <string>
+#include <fstream>
+#include <iostream>
+#include <cstdint>
+
+// Grabacion y reproduccion de la entrada para comparar rendimiento con el mismo recorrido.
+//
+// Al grabar, cada frame se guarda un registro binario:
+//   float    tiempo del frame (el mismo valor de glfwGetTime que usa el bucle)
+//   uint16   teclas pulsadas (un bit por tecla de trackedKey)
+//   uint16   numero de movimientos de raton, uint16 numero de eventos de scroll
+//   float[2] por movimiento (xoffset, yoffset ya calculados en mouse_callback)
+//   float    por scroll (yoffset)
+// Al reproducir se ignoran el teclado y el raton reales y el tiempo de cada frame sale del
+// archivo en vez del reloj, asi que deltaTime, los movimientos de la camara y las colisiones son
+// exactamente los de la grabacion aunque el frame tarde distinto en dibujarse. Los movimientos de
+// raton se aplican uno a uno y en el mismo punto del frame que al grabar (despues de sondear los
+// eventos), para que el limite de pitch de la camara actue igual.
+enum InputMode
+{
+    INPUT_LIVE = 0,
+    INPUT_RECORD,
+    INPUT_REPLAY
+};
+
+class InputRecorder
+{
+public:
+    InputMode mode = INPUT_LIVE;
+
+    bool startRecording(const std::string& path)
+    {
+        file.open(path, std::ios::binary | std::ios::out | std::ios::trunc);
+        if (!file.is_open())
+        {
+            std::cout << "INPUT::No se pudo crear el archivo de grabacion: " << path << std::endl;
+            return false;
+        }
+        file.write(magic(), 4);
+        mode = INPUT_RECORD;
+        return true;
+    }
+
+    bool startReplay(const std::string& path)
+    {
+        file.open(path, std::ios::binary | std::ios::in);
+        char header[4] = {};
+        if (!file.is_open() || !file.read(header, 4) || std::string(header, 4) != magic())
+        {
+            std::cout << "INPUT::No se pudo leer la grabacion: " << path << std::endl;
+            return false;
+        }
+        mode = INPUT_REPLAY;
+        return true;
+    }
+
+    // Llamar justo despues de glfwPollEvents. Al grabar guarda el frame; al reproducir lee el
+    // siguiente y devuelve su tiempo (liveTime se devuelve tal cual en los demas modos).
+    float beginFrame(GLFWwindow* window, float liveTime)
+    {
+        if (mode == INPUT_RECORD)
+        {
+            uint16_t keys = 0;
+            for (int i = 0; i < KEY_COUNT; i++)
+                if (glfwGetKey(window, trackedKey(i)) == GLFW_PRESS)
+                    keys |= (uint16_t)(1 << i);
+            write(liveTime);
+            write(keys);
+            write((uint16_t)mouseMoves.size());
+            write((uint16_t)scrolls.size());
+            for (const glm::vec2& move : mouseMoves)
+                write(move);
+            for (float scroll : scrolls)
+                write(scroll);
+            mouseMoves.clear();
+            scrolls.clear();
+            frames++;
+            return liveTime;
+        }
+
+        if (mode == INPUT_REPLAY)
+        {
+            uint16_t moveCount = 0, scrollCount = 0;
+            if (!read(frameTime) || !read(keyState) || !read(moveCount) || !read(scrollCount))
+            {
+                finished = true;
+                keyState = 0;
+                mouseMoves.clear();
+                scrolls.clear();
+                return frameTime;
+            }
+            mouseMoves.resize(moveCount);
+            scrolls.resize(scrollCount);
+            for (glm::vec2& move : mouseMoves)
+                read(move);
+            for (float& scroll : scrolls)
+                read(scroll);
+            frames++;
+            return frameTime;
+        }
+
+        return liveTime;
+    }
+
+    // Sustituye a glfwGetKey: al reproducir devuelve el estado grabado
+    int getKey(GLFWwindow* window, int key) const
+    {
+        if (mode != INPUT_REPLAY)
+            return glfwGetKey(window, key);
+        for (int i = 0; i < KEY_COUNT; i++)
+            if (trackedKey(i) == key)
+                return (keyState >> i) & 1 ? GLFW_PRESS : GLFW_RELEASE;
+        return GLFW_RELEASE;
+    }
+
+    // Desde los callbacks de GLFW. Devuelven false si el evento real se debe ignorar (reproduciendo).
+    bool mouseMoved(float xoffset, float yoffset)
+    {
+        if (mode == INPUT_RECORD && mouseMoves.size() < MAX_EVENTS)
+            mouseMoves.push_back(glm::vec2(xoffset, yoffset));
+        else if (mode == INPUT_RECORD)
+            mouseMoves.back() += glm::vec2(xoffset, yoffset);   // no deberia pasar; mejor que perderlo
+        return mode != INPUT_REPLAY;
+    }
+
+    bool scrolled(float yoffset)
+    {
+        if (mode == INPUT_RECORD && scrolls.size() < MAX_EVENTS)
+            scrolls.push_back(yoffset);
+        else if (mode == INPUT_RECORD)
+            scrolls.back() += yoffset;
+        return mode != INPUT_REPLAY;
+    }
+
+    // Eventos grabados del frame actual (solo al reproducir)
+    const std::vector<glm::vec2>& replayMouseMoves() const { return mouseMoves; }
+    const std::vector<float>& replayScrolls() const { return scrolls; }
+
+    bool replayFinished() const { return finished; }
+    unsigned int frameCount() const { return frames; }
+
+    void stop()
+    {
+        if (mode == INPUT_RECORD)
+            std::cout << "INPUT::Grabados " << frames << " frames" << std::endl;
+        else if (mode == INPUT_REPLAY)
+            std::cout << "INPUT::Reproducidos " << frames << " frames" << std::endl;
+        file.close();
+        mode = INPUT_LIVE;
+    }
+
+private:
+    static const int KEY_COUNT = 8;
+    static const size_t MAX_EVENTS = 65535;   // por frame y tipo; lo que pase se suma al ultimo
+
+    static const char* magic() { return "TIN2"; }   // TIN1 tenia los contadores de 8 bits
+
+    static int trackedKey(int i)
+    {
+        static const int keys[KEY_COUNT] = { GLFW_KEY_W, GLFW_KEY_S, GLFW_KEY_A, GLFW_KEY_D,
+                                             GLFW_KEY_ESCAPE, GLFW_KEY_O, GLFW_KEY_G, GLFW_KEY_P };
+        return keys[i];
+    }
+
+    std::fstream file;
+    std::vector<glm::vec2> mouseMoves;
+    std::vector<float> scrolls;
+    uint16_t keyState = 0;
+    float frameTime = 0.0f;
+    bool finished = false;
+    unsigned int frames = 0;
+
+    template <typename T>
+    void write(const T& value)
+    {
+        file.write((const char*)&value, sizeof(T));
+    }
+
+    template <typename T>
+    bool read(T& value)
+    {
+        return (bool)file.read((char*)&value, sizeof(T));
+    }
+};
+
+#endif
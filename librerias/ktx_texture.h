@@ -0,0 +1,294 @@
+#ifndef KTX_TEXTURE_H
+#define KTX_TEXTURE_H
+
+#include <glad/glad.h>
+#include <GLFW/glfw3.h>
+
+#include <vector>
+#include <map>
+#include <string>
+#include <fstream>
+#include <algorithm>
+#include <iostream>
+#include <cstdint>
+
+// Formatos comprimidos por bloques que no estan en el glad de GL 3.3 (S3TC y BPTC son extensiones)
+#ifndef GL_COMPRESSED_RGB_S3TC_DXT1_EXT
+#define GL_COMPRESSED_RGB_S3TC_DXT1_EXT 0x83F0
+#endif
+#ifndef GL_COMPRESSED_RGBA_S3TC_DXT5_EXT
+#define GL_COMPRESSED_RGBA_S3TC_DXT5_EXT 0x83F3
+#endif
+#ifndef GL_COMPRESSED_RGBA_BPTC_UNORM
+#define GL_COMPRESSED_RGBA_BPTC_UNORM 0x8E8C
+#endif
+
+// Texturas cocinadas por TextureCooker: contenedor KTX 1.1 con un formato comprimido por bloques
+// (BC1, BC3, BC4, BC5 o BC7) y la cadena de mips completa ya calculada, asi que al cargar no se
+// decodifica ningun PNG/JPEG ni se llama a glGenerateMipmap: cada nivel va tal cual a
+// glCompressedTexImage2D. Solo se escribe y se lee lo que usa el cooker (una cara, sin arrays,
+// sin pares clave/valor, little-endian).
+//
+// El archivo cocinado va al lado del original con extension .ktx (ver cookedTexturePath); si no
+// existe o el driver no soporta su formato se sigue usando el original.
+struct KtxImage
+{
+    GLenum internalFormat = 0;
+    GLenum baseFormat = 0;     // GL_RGB, GL_RGBA, GL_RED o GL_RG
+    int width = 0, height = 0;
+    std::vector<std::vector<unsigned char>> levels;
+};
+
+// Bytes por bloque de 4x4
+inline unsigned int compressedBlockBytes(GLenum internalFormat)
+{
+    return internalFormat == GL_COMPRESSED_RGB_S3TC_DXT1_EXT || internalFormat == GL_COMPRESSED_RED_RGTC1 ? 8 : 16;
+}
+
+inline size_t compressedLevelBytes(GLenum internalFormat, int width, int height)
+{
+    return (size_t)((width + 3) / 4) * ((height + 3) / 4) * compressedBlockBytes(internalFormat);
+}
+
+inline const char* compressedFormatName(GLenum internalFormat)
+{
+    switch (internalFormat)
+    {
+    case GL_COMPRESSED_RGB_S3TC_DXT1_EXT: return "BC1";
+    case GL_COMPRESSED_RGBA_S3TC_DXT5_EXT: return "BC3";
+    case GL_COMPRESSED_RED_RGTC1: return "BC4";
+    case GL_COMPRESSED_RG_RGTC2: return "BC5";
+    case GL_COMPRESSED_RGBA_BPTC_UNORM: return "BC7";
+    default: return "?";
+    }
+}
+
+// RGTC es de GL 3.0; S3TC y BPTC dependen del driver. Necesita contexto.
+inline bool compressedFormatSupported(GLenum internalFormat)
+{
+    static std::map<GLenum, bool> supported;
+    auto it = supported.find(internalFormat);
+    if (it != supported.end())
+        return it->second;
+
+    bool result = false;
+    if (internalFormat == GL_COMPRESSED_RED_RGTC1 || internalFormat == GL_COMPRESSED_RG_RGTC2)
+    {
+        result = true;
+    }
+    else if (internalFormat == GL_COMPRESSED_RGB_S3TC_DXT1_EXT || internalFormat == GL_COMPRESSED_RGBA_S3TC_DXT5_EXT)
+    {
+        result = glfwExtensionSupported("GL_EXT_texture_compression_s3tc") != 0;
+    }
+    else if (internalFormat == GL_COMPRESSED_RGBA_BPTC_UNORM)
+    {
+        GLint major = 0, minor = 0;
+        glGetIntegerv(GL_MAJOR_VERSION, &major);
+        glGetIntegerv(GL_MINOR_VERSION, &minor);
+        result = major > 4 || (major == 4 && minor >= 2) || glfwExtensionSupported("GL_ARB_texture_compression_bptc");
+    }
+    supported[internalFormat] = result;
+    return result;
+}
+
+// "dir/pared_baseColor.png" -> "dir/pared_baseColor.ktx"
+inline std::string cookedTexturePath(const std::string& path)
+{
+    size_t dot = path.find_last_of('.');
+    size_t slash = path.find_last_of("/\\");
+    if (dot == std::string::npos || (slash != std::string::npos && dot < slash))
+        return path + ".ktx";
+    return path.substr(0, dot) + ".ktx";
+}
+
+inline const unsigned char* ktxIdentifier()
+{
+    static const unsigned char identifier[12] = { 0xAB, 'K', 'T', 'X', ' ', '1', '1', 0xBB, '\r', '\n', 0x1A, '\n' };
+    return identifier;
+}
+
+// Cabecera KTX 1.1 despues del identificador
+struct KtxHeader
+{
+    uint32_t endianness;
+    uint32_t glType;
+    uint32_t glTypeSize;
+    uint32_t glFormat;
+    uint32_t glInternalFormat;
+    uint32_t glBaseInternalFormat;
+    uint32_t pixelWidth;
+    uint32_t pixelHeight;
+    uint32_t pixelDepth;
+    uint32_t numberOfArrayElements;
+    uint32_t numberOfFaces;
+    uint32_t numberOfMipmapLevels;
+    uint32_t bytesOfKeyValueData;
+};
+
+inline bool writeKtx(const std::string& path, const KtxImage& image)
+{
+    std::ofstream file(path, std::ios::binary | std::ios::trunc);
+    if (!file.is_open())
+        return false;
+
+    KtxHeader header = {};
+    header.endianness = 0x04030201;
+    header.glTypeSize = 1;
+    header.glInternalFormat = image.internalFormat;
+    header.glBaseInternalFormat = image.baseFormat;
+    header.pixelWidth = (uint32_t)image.width;
+    header.pixelHeight = (uint32_t)image.height;
+    header.numberOfFaces = 1;
+    header.numberOfMipmapLevels = (uint32_t)image.levels.size();
+    file.write((const char*)ktxIdentifier(), 12);
+    file.write((const char*)&header, sizeof(header));
+    for (const std::vector<unsigned char>& level : image.levels)
+    {
+        uint32_t imageSize = (uint32_t)level.size();   // siempre multiplo de 8: no hace falta relleno
+        file.write((const char*)&imageSize, sizeof(imageSize));
+        file.write((const char*)level.data(), level.size());
+    }
+    return (bool)file;
+}
+
+// headerOnly: solo tamano, formato y numero de niveles (levels queda con vectores vacios).
+// firstLevel: los niveles anteriores se saltan y quedan vacios (MipStreamer).
+inline bool readKtx(const std::string& path, KtxImage& image, bool headerOnly = false, int firstLevel = 0)
+{
+    std::ifstream file(path, std::ios::binary);
+    if (!file.is_open())
+        return false;
+
+    unsigned char identifier[12] = {};
+    KtxHeader header = {};
+    file.read((char*)identifier, 12);
+    file.read((char*)&header, sizeof(header));
+    if (!file || !std::equal(identifier, identifier + 12, ktxIdentifier()) || header.endianness != 0x04030201 ||
+        header.glType != 0 || header.numberOfFaces != 1 || header.numberOfArrayElements != 0 || header.pixelDepth != 0 ||
+        header.numberOfMipmapLevels == 0)
+    {
+        std::cout << "KTX::Archivo no valido: " << path << std::endl;
+        return false;
+    }
+    file.seekg(header.bytesOfKeyValueData, std::ios::cur);
+
+    image.internalFormat = header.glInternalFormat;
+    image.baseFormat = header.glBaseInternalFormat;
+    image.width = (int)header.pixelWidth;
+    image.height = (int)header.pixelHeight;
+    image.levels.resize(header.numberOfMipmapLevels);
+    if (headerOnly)
+        return true;
+    int width = image.width, height = image.height;
+    for (size_t index = 0; index < image.levels.size(); index++)
+    {
+        uint32_t imageSize = 0;
+        file.read((char*)&imageSize, sizeof(imageSize));
+        if (!file || imageSize != compressedLevelBytes(image.internalFormat, width, height))
+        {
+            std::cout << "KTX::Nivel de mip incorrecto en " << path << std::endl;
+            return false;
+        }
+        if ((int)index < firstLevel)
+            file.seekg(imageSize, std::ios::cur);
+        else
+        {
+            image.levels[index].resize(imageSize);
+            file.read((char*)image.levels[index].data(), imageSize);
+        }
+        width = std::max(1, width / 2);
+        height = std::max(1, height / 2);
+    }
+    return (bool)file;
+}
+
+// Un bloque gris medio (normal plana en BC5) para rellenar texturas que aun no se han cargado
+inline const unsigned char* compressedPlaceholderBlock(GLenum internalFormat)
+{
+    static const unsigned char bc1[8] = { 0x10, 0x84, 0x10, 0x84, 0, 0, 0, 0 };
+    static const unsigned char bc3[16] = { 0xFF, 0xFF, 0, 0, 0, 0, 0, 0, 0x10, 0x84, 0x10, 0x84, 0, 0, 0, 0 };
+    static const unsigned char bc4[16] = { 0x80, 0x80, 0, 0, 0, 0, 0, 0, 0x80, 0x80, 0, 0, 0, 0, 0, 0 };   // BC5 = 2 x BC4
+    static const unsigned char bc7[16] = { 0x40, 0x20, 0x10, 0x08, 0x04, 0x02, 0xFF, 0x7F, 0, 0, 0, 0, 0, 0, 0, 0 };   // modo 6
+    switch (internalFormat)
+    {
+    case GL_COMPRESSED_RGB_S3TC_DXT1_EXT: return bc1;
+    case GL_COMPRESSED_RGBA_S3TC_DXT5_EXT: return bc3;
+    case GL_COMPRESSED_RGBA_BPTC_UNORM: return bc7;
+    default: return bc4;
+    }
+}
+
+// Filtros y swizzle comunes; target es GL_TEXTURE_2D o GL_TEXTURE_2D_ARRAY ya enlazado
+inline void setCookedTextureParameters(GLenum target, const KtxImage& image)
+{
+    glTexParameteri(target, GL_TEXTURE_BASE_LEVEL, 0);
+    glTexParameteri(target, GL_TEXTURE_MAX_LEVEL, (GLint)image.levels.size() - 1);
+    glTexParameteri(target, GL_TEXTURE_WRAP_S, GL_REPEAT);
+    glTexParameteri(target, GL_TEXTURE_WRAP_T, GL_REPEAT);
+    glTexParameteri(target, GL_TEXTURE_MIN_FILTER, image.levels.size() > 1 ? GL_LINEAR_MIPMAP_LINEAR : GL_LINEAR);
+    glTexParameteri(target, GL_TEXTURE_MAG_FILTER, GL_LINEAR);
+    if (image.internalFormat == GL_COMPRESSED_RED_RGTC1)
+    {
+        // Las mascaras en gris se guardan en un canal: se leen como antes (r, r, r, 1)
+        GLint swizzle[4] = { GL_RED, GL_RED, GL_RED, GL_ONE };
+        glTexParameteriv(target, GL_TEXTURE_SWIZZLE_RGBA, swizzle);
+    }
+}
+
+// Sube un KTX como GL_TEXTURE_2D. Devuelve 0 si no existe, no es valido o el driver no tiene el formato.
+inline GLuint loadCookedTexture(const std::string& path)
+{
+    KtxImage image;
+    if (!readKtx(path, image))
+        return 0;
+    if (!compressedFormatSupported(image.internalFormat))
+    {
+        std::cout << "KTX::" << compressedFormatName(image.internalFormat) << " no soportado, se usa el original de " << path << std::endl;
+        return 0;
+    }
+
+    GLuint id;
+    glGenTextures(1, &id);
+    glBindTexture(GL_TEXTURE_2D, id);
+    int width = image.width, height = image.height;
+    for (size_t level = 0; level < image.levels.size(); level++)
+    {
+        glCompressedTexImage2D(GL_TEXTURE_2D, (GLint)level, image.internalFormat, width, height, 0,
+                               (GLsizei)image.levels[level].size(), image.levels[level].data());
+        width = std::max(1, width / 2);
+        height = std::max(1, height / 2);
+    }
+    setCookedTextureParameters(GL_TEXTURE_2D, image);
+    glBindTexture(GL_TEXTURE_2D, 0);
+    return id;
+}
+
+// Cambia las texturas de un Model de learnopengl por sus versiones cocinadas cuando existen.
+// Llamar justo despues de cargarlo y antes de copiar sus texturas (StaticGeometry, LodModel).
+// Devuelve cuantas se cambiaron.
+template <typename ModelType>
+unsigned int useCookedTextures(ModelType& model)
+{
+    std::map<unsigned int, unsigned int> replaced;
+    for (auto& texture : model.textures_loaded)
+    {
+        GLuint cooked = loadCookedTexture(cookedTexturePath(model.directory + '/' + texture.path));
+        if (!cooked)
+            continue;
+        replaced[texture.id] = cooked;
+        glDeleteTextures(1, &texture.id);
+        texture.id = cooked;
+    }
+    for (auto& mesh : model.meshes)
+        for (auto& texture : mesh.textures)
+        {
+            auto it = replaced.find(texture.id);
+            if (it != replaced.end())
+                texture.id = it->second;
+        }
+    if (!replaced.empty())
+        std::cout << "KTX::" << replaced.size() << " texturas cocinadas en " << model.directory << std::endl;
+    return (unsigned int)replaced.size();
+}
+
+#endif
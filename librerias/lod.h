@@ -0,0 +1,393 @@
+#ifndef LOD_H
+#define LOD_H
+
+#include <glad/glad.h>
+#include <glm/glm.hpp>
+
+#include <learnopengl/model.h>
+#include <learnopengl/frustum_culling.h>
+#include <learnopengl/render_queue.h>
+
+#include <vector>
+#include <map>
+#include <queue>
+#include <algorithm>
+#include <cmath>
+#include <cfloat>
+#include <cstddef>
+#include <iostream>
+
+// Niveles de detalle (LOD) generados al cargar los props.
+//
+// Cada mesh se simplifica con colapso de aristas guiado por quadricas de error (Garland-Heckbert)
+// a varias proporciones de triangulos. Los colapsos son de un vertice sobre un vecino (sin crear
+// vertices nuevos), asi que todos los niveles usan el VBO que ya creo el Mesh de learnopengl (se
+// saca de su VAO) y solo se anade un EBO con los indices de todos los niveles.
+// Los vertices de borde del grafo de indices no se mueven nunca: ahi estan los bordes abiertos y
+// las costuras de UV/normales (learnopengl duplica esos vertices), que si no se abririan.
+//
+// En tiempo de ejecucion el nivel se elige por el tamano proyectado en pantalla de la esfera
+// envolvente, con histeresis por instancia para que no haya parpadeo al cruzar un umbral.
+
+// Quadrica simetrica 4x4 (10 coeficientes)
+struct Quadric
+{
+    double a2 = 0, ab = 0, ac = 0, ad = 0, b2 = 0, bc = 0, bd = 0, c2 = 0, cd = 0, d2 = 0;
+
+    void addPlane(const glm::vec3& n, float d, float weight)
+    {
+        a2 += weight * n.x * n.x; ab += weight * n.x * n.y; ac += weight * n.x * n.z; ad += weight * n.x * d;
+        b2 += weight * n.y * n.y; bc += weight * n.y * n.z; bd += weight * n.y * d;
+        c2 += weight * n.z * n.z; cd += weight * n.z * d;
+        d2 += weight * d * d;
+    }
+
+    Quadric& operator+=(const Quadric& q)
+    {
+        a2 += q.a2; ab += q.ab; ac += q.ac; ad += q.ad; b2 += q.b2;
+        bc += q.bc; bd += q.bd; c2 += q.c2; cd += q.cd; d2 += q.d2;
+        return *this;
+    }
+
+    double error(const glm::vec3& p) const
+    {
+        double x = p.x, y = p.y, z = p.z;
+        return a2 * x * x + 2 * ab * x * y + 2 * ac * x * z + 2 * ad * x
+             + b2 * y * y + 2 * bc * y * z + 2 * bd * y
+             + c2 * z * z + 2 * cd * z + d2;
+    }
+};
+
+// Simplifica una lista de triangulos hasta targetIndexCount indices (o hasta que no quede ningun
+// colapso valido). Devuelve los indices nuevos, que apuntan a los mismos vertices.
+inline std::vector<unsigned int> simplifyIndices(const std::vector<glm::vec3>& positions, const std::vector<unsigned int>& indices,
+                                                 size_t targetIndexCount)
+{
+    size_t vertexCount = positions.size();
+    size_t triangleCount = indices.size() / 3;
+    std::vector<unsigned int> triangles(indices.begin(), indices.begin() + triangleCount * 3);
+    std::vector<bool> triangleAlive(triangleCount, true);
+    std::vector<std::vector<unsigned int>> vertexTriangles(vertexCount);
+    std::vector<Quadric> quadrics(vertexCount);
+
+    // Quadricas por vertice, ponderadas por el area de cada triangulo
+    for (unsigned int t = 0; t < triangleCount; t++)
+    {
+        const glm::vec3& a = positions[triangles[t * 3]];
+        glm::vec3 n = glm::cross(positions[triangles[t * 3 + 1]] - a, positions[triangles[t * 3 + 2]] - a);
+        float length = glm::length(n);
+        for (int k = 0; k < 3; k++)
+            vertexTriangles[triangles[t * 3 + k]].push_back(t);
+        if (length <= 0.0f)
+            continue;
+        n /= length;
+        float d = -glm::dot(n, a);
+        for (int k = 0; k < 3; k++)
+            quadrics[triangles[t * 3 + k]].addPlane(n, d, length * 0.5f);
+    }
+
+    // Aristas usadas por un solo triangulo (o por mas de dos): sus vertices quedan fijos
+    std::map<std::pair<unsigned int, unsigned int>, int> edgeUse;
+    for (size_t t = 0; t < triangleCount; t++)
+    {
+        for (int k = 0; k < 3; k++)
+        {
+            unsigned int a = triangles[t * 3 + k], b = triangles[t * 3 + (k + 1) % 3];
+            edgeUse[std::make_pair(std::min(a, b), std::max(a, b))]++;
+        }
+    }
+    std::vector<bool> locked(vertexCount, false);
+    for (const auto& edge : edgeUse)
+        if (edge.second != 2)
+            locked[edge.first.first] = locked[edge.first.second] = true;
+
+    struct Candidate
+    {
+        double cost;
+        unsigned int from, to;
+        unsigned int fromVersion, toVersion;
+        bool operator<(const Candidate& o) const { return cost > o.cost; } // cola de minimos
+    };
+    std::priority_queue<Candidate> candidates;
+    std::vector<unsigned int> version(vertexCount, 0);
+    std::vector<bool> removed(vertexCount, false);
+
+    auto pushCandidate = [&](unsigned int from, unsigned int to) {
+        if (locked[from] || removed[from] || removed[to] || from == to)
+            return;
+        Quadric q = quadrics[from];
+        q += quadrics[to];
+        candidates.push({ q.error(positions[to]), from, to, version[from], version[to] });
+    };
+    for (const auto& edge : edgeUse)
+    {
+        pushCandidate(edge.first.first, edge.first.second);
+        pushCandidate(edge.first.second, edge.first.first);
+    }
+
+    size_t aliveTriangles = triangleCount;
+    std::vector<unsigned int> neighbours;
+    while (aliveTriangles * 3 > targetIndexCount && !candidates.empty())
+    {
+        Candidate candidate = candidates.top();
+        candidates.pop();
+        unsigned int u = candidate.from, v = candidate.to;
+        if (removed[u] || removed[v] || version[u] != candidate.fromVersion || version[v] != candidate.toVersion)
+            continue;
+
+        // Rechazar el colapso si algun triangulo que sobrevive se da la vuelta o queda degenerado
+        bool valid = true;
+        for (unsigned int t : vertexTriangles[u])
+        {
+            if (!triangleAlive[t])
+                continue;
+            unsigned int* tri = &triangles[t * 3];
+            if (tri[0] == v || tri[1] == v || tri[2] == v)
+                continue;
+            glm::vec3 p[3], q[3];
+            for (int k = 0; k < 3; k++)
+            {
+                p[k] = positions[tri[k]];
+                q[k] = tri[k] == u ? positions[v] : p[k];
+            }
+            glm::vec3 oldNormal = glm::cross(p[1] - p[0], p[2] - p[0]);
+            glm::vec3 newNormal = glm::cross(q[1] - q[0], q[2] - q[0]);
+            float oldLength = glm::length(oldNormal), newLength = glm::length(newNormal);
+            if (newLength <= 1e-12f || (oldLength > 0.0f && glm::dot(oldNormal, newNormal) < 0.2f * oldLength * newLength))
+            {
+                valid = false;
+                break;
+            }
+        }
+        if (!valid)
+            continue;
+
+        // Aplicar: u desaparece y sus triangulos pasan a v
+        removed[u] = true;
+        for (unsigned int t : vertexTriangles[u])
+        {
+            if (!triangleAlive[t])
+                continue;
+            unsigned int* tri = &triangles[t * 3];
+            if (tri[0] == v || tri[1] == v || tri[2] == v)
+            {
+                triangleAlive[t] = false;
+                aliveTriangles--;
+                continue;
+            }
+            for (int k = 0; k < 3; k++)
+                if (tri[k] == u)
+                    tri[k] = v;
+            vertexTriangles[v].push_back(t);
+        }
+        vertexTriangles[u].clear();
+        quadrics[v] += quadrics[u];
+        version[v]++;
+
+        // Nuevos costes alrededor de v
+        neighbours.clear();
+        for (unsigned int t : vertexTriangles[v])
+        {
+            if (!triangleAlive[t])
+                continue;
+            for (int k = 0; k < 3; k++)
+                if (triangles[t * 3 + k] != v)
+                    neighbours.push_back(triangles[t * 3 + k]);
+        }
+        std::sort(neighbours.begin(), neighbours.end());
+        neighbours.erase(std::unique(neighbours.begin(), neighbours.end()), neighbours.end());
+        for (unsigned int n : neighbours)
+        {
+            pushCandidate(v, n);
+            pushCandidate(n, v);
+        }
+    }
+
+    std::vector<unsigned int> result;
+    result.reserve(aliveTriangles * 3);
+    for (size_t t = 0; t < triangleCount; t++)
+        if (triangleAlive[t])
+            result.insert(result.end(), triangles.begin() + t * 3, triangles.begin() + t * 3 + 3);
+    return result;
+}
+
+// Tamano en pixeles (diametro) de una esfera vista desde la camara
+inline float projectedSize(const glm::vec3& center, float radius, const glm::vec3& cameraPos, float fovYDegrees, float viewportHeight)
+{
+    float distance = glm::length(center - cameraPos);
+    if (distance <= radius)
+        return FLT_MAX;
+    return viewportHeight * radius / (distance * std::tan(glm::radians(fovYDegrees) * 0.5f));
+}
+
+// Nivel siguiente de una instancia segun su tamano en pantalla: thresholds[l] es el tamano minimo
+// para el nivel l y hay que pasarlo en un porcentaje hysteresis para cambiar (LodModel, GltfModel)
+inline unsigned int stepLodLevel(unsigned int level, float size, const std::vector<float>& thresholds, size_t levelCount, float hysteresis)
+{
+    while (level + 1 < levelCount && level < thresholds.size() && size < thresholds[level] * (1.0f - hysteresis))
+        level++;
+    while (level > 0 && level - 1 < thresholds.size() && size >= thresholds[level - 1] * (1.0f + hysteresis))
+        level--;
+    return level;
+}
+
+class LodModel
+{
+public:
+    // Histeresis relativa: para cambiar de nivel hay que pasar el umbral en este porcentaje
+    float hysteresis = 0.15f;
+
+    // ratios: proporcion de triangulos de cada nivel (el primero debe ser 1).
+    // thresholds: tamano minimo en pantalla (pixeles) para usar cada nivel; el ultimo debe ser 0.
+    LodModel(const Model& model, const std::vector<float>& ratios = { 1.0f, 0.5f, 0.25f, 0.1f },
+             const std::vector<float>& thresholds = { 300.0f, 120.0f, 50.0f, 0.0f })
+        : model(model), thresholds(thresholds)
+    {
+        levels.resize(ratios.size());
+        for (unsigned int m = 0; m < model.meshes.size(); m++)
+        {
+            const Mesh& mesh = model.meshes[m];
+            std::vector<glm::vec3> positions;
+            positions.reserve(mesh.vertices.size());
+            for (const Vertex& vertex : mesh.vertices)
+                positions.push_back(vertex.Position);
+
+            // Todos los niveles van seguidos en un mismo EBO
+            std::vector<unsigned int> allIndices;
+            for (size_t l = 0; l < ratios.size(); l++)
+            {
+                std::vector<unsigned int> levelIndices = l == 0 ? mesh.indices
+                    : simplifyIndices(positions, mesh.indices, (size_t)(mesh.indices.size() * ratios[l]));
+                levels[l].push_back({ (GLsizei)levelIndices.size(), allIndices.size() * sizeof(unsigned int) });
+                allIndices.insert(allIndices.end(), levelIndices.begin(), levelIndices.end());
+            }
+
+            // El VBO de Mesh es privado: se lee del atributo 0 de su VAO. Si no hay (mesh vacio) se
+            // sube una copia de los vertices.
+            MeshBuffers buffers;
+            GLint meshVBO = 0;
+            glBindVertexArray(mesh.VAO);
+            glGetVertexAttribiv(0, GL_VERTEX_ATTRIB_ARRAY_BUFFER_BINDING, &meshVBO);
+            buffers.VBO = (GLuint)meshVBO;
+            glGenVertexArrays(1, &buffers.VAO);
+            glGenBuffers(1, &buffers.EBO);
+            glBindVertexArray(buffers.VAO);
+            if (buffers.VBO)
+                glBindBuffer(GL_ARRAY_BUFFER, buffers.VBO);
+            else
+            {
+                glGenBuffers(1, &buffers.VBO);
+                buffers.ownsVBO = true;
+                glBindBuffer(GL_ARRAY_BUFFER, buffers.VBO);
+                glBufferData(GL_ARRAY_BUFFER, mesh.vertices.size() * sizeof(Vertex), mesh.vertices.data(), GL_STATIC_DRAW);
+            }
+            glBindBuffer(GL_ELEMENT_ARRAY_BUFFER, buffers.EBO);
+            glBufferData(GL_ELEMENT_ARRAY_BUFFER, allIndices.size() * sizeof(unsigned int), allIndices.data(), GL_STATIC_DRAW);
+            glEnableVertexAttribArray(0);
+            glVertexAttribPointer(0, 3, GL_FLOAT, GL_FALSE, sizeof(Vertex), (void*)offsetof(Vertex, Position));
+            glEnableVertexAttribArray(1);
+            glVertexAttribPointer(1, 3, GL_FLOAT, GL_FALSE, sizeof(Vertex), (void*)offsetof(Vertex, Normal));
+            glEnableVertexAttribArray(2);
+            glVertexAttribPointer(2, 2, GL_FLOAT, GL_FALSE, sizeof(Vertex), (void*)offsetof(Vertex, TexCoords));
+            glEnableVertexAttribArray(3);
+            glVertexAttribPointer(3, 3, GL_FLOAT, GL_FALSE, sizeof(Vertex), (void*)offsetof(Vertex, Tangent));
+            glEnableVertexAttribArray(4);
+            glVertexAttribPointer(4, 3, GL_FLOAT, GL_FALSE, sizeof(Vertex), (void*)offsetof(Vertex, Bitangent));
+            glBindVertexArray(0);
+            meshBuffers.push_back(buffers);
+        }
+
+        AABB box = computeModelAABB(model);
+        localCenter = (box.min + box.max) * 0.5f;
+        localRadius = glm::length(box.max - box.min) * 0.5f;
+
+        std::cout << "LOD::" << model.directory << " triangulos por nivel:";
+        for (size_t l = 0; l < levels.size(); l++)
+            std::cout << " " << triangleCount(l);
+        std::cout << std::endl;
+    }
+
+    ~LodModel()
+    {
+        for (const MeshBuffers& buffers : meshBuffers)
+        {
+            glDeleteBuffers(1, &buffers.EBO);
+            if (buffers.ownsVBO)
+                glDeleteBuffers(1, &buffers.VBO);
+            glDeleteVertexArrays(1, &buffers.VAO);
+        }
+    }
+
+    LodModel(const LodModel&) = delete;
+    LodModel& operator=(const LodModel&) = delete;
+
+    unsigned int levelCount() const { return (unsigned int)levels.size(); }
+    unsigned int meshCount() const { return (unsigned int)meshBuffers.size(); }
+
+    size_t triangleCount(size_t level) const
+    {
+        size_t count = 0;
+        for (const Range& range : levels[level])
+            count += range.indexCount / 3;
+        return count;
+    }
+
+    // Elige el nivel de una instancia. bias > 0 baja el detalle (cada unidad divide el tamano por 2).
+    unsigned int selectLevel(unsigned int instance, const glm::mat4& modelMatrix, const glm::vec3& cameraPos,
+                             float fovYDegrees, float viewportHeight, float bias = 0.0f)
+    {
+        if (instance >= currentLevel.size())
+            currentLevel.resize(instance + 1, 0);
+        unsigned int& level = currentLevel[instance];
+
+        float scale = std::max(glm::length(glm::vec3(modelMatrix[0])),
+                      std::max(glm::length(glm::vec3(modelMatrix[1])), glm::length(glm::vec3(modelMatrix[2]))));
+        glm::vec3 center = glm::vec3(modelMatrix * glm::vec4(localCenter, 1.0f));
+        float size = projectedSize(center, localRadius * scale, cameraPos, fovYDegrees, viewportHeight);
+        if (size < FLT_MAX)
+            size *= std::pow(2.0f, -bias);
+
+        level = stepLodLevel(level, size, thresholds, levels.size(), hysteresis);
+        return level;
+    }
+
+    // Dibuja un mesh directamente con el programa que este activo (sin texturas, para las sombras)
+    void draw(unsigned int mesh, unsigned int level) const
+    {
+        const Range& range = levels[level][mesh];
+        glBindVertexArray(meshBuffers[mesh].VAO);
+        glDrawElements(GL_TRIANGLES, range.indexCount, GL_UNSIGNED_INT, (void*)range.indexOffset);
+    }
+
+    // Encola un mesh del modelo al nivel indicado, con las texturas del mesh original
+    DrawCommand& submitMesh(RenderQueue& queue, RenderPass pass, GLuint program, unsigned int mesh, unsigned int level,
+                            const glm::mat4& modelMatrix, float depth, GLuint conditionalQuery = 0)
+    {
+        const Range& range = levels[level][mesh];
+        return queue.submitDraw(pass, program, meshBuffers[mesh].VAO, range.indexCount, range.indexOffset,
+                                model.meshes[mesh].textures, modelMatrix, depth, conditionalQuery);
+    }
+
+private:
+    struct Range
+    {
+        GLsizei indexCount;
+        size_t indexOffset;  // en bytes
+    };
+
+    struct MeshBuffers
+    {
+        GLuint VAO = 0, VBO = 0, EBO = 0;
+        bool ownsVBO = false;   // si no, el VBO es del Mesh
+    };
+
+    const Model& model;
+    std::vector<float> thresholds;
+    std::vector<std::vector<Range>> levels;  // levels[nivel][mesh]
+    std::vector<MeshBuffers> meshBuffers;
+    std::vector<unsigned int> currentLevel;  // por instancia
+    glm::vec3 localCenter;
+    float localRadius = 0.0f;
+};
+
+#endif
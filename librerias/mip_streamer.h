@@ -0,0 +1,326 @@
+#ifndef MIP_STREAMER_H
+#define MIP_STREAMER_H
+
+#include <glad/glad.h>
+
+#include <learnopengl/ktx_texture.h>
+#include <learnopengl/texture_streamer.h>
+
+#include <vector>
+#include <map>
+#include <string>
+#include <algorithm>
+#include <iostream>
+#include <cmath>
+#include <cstdint>
+
+// Streaming de mips de las texturas cocinadas (.ktx) segun lo que se ve.
+//
+// load() sube solo los mips pequenos (hasta residentSize pixels de lado), que se quedan siempre, y
+// deja la textura con GL_TEXTURE_BASE_LEVEL en el primero de ellos. Cada frame se llama a request()
+// con el tamano en pantalla de lo que usa cada textura; update() calcula que nivel hace falta
+// (el que tiene mas o menos un texel por pixel) y pide al TextureStreamer el siguiente nivel mas
+// grande de las que se quedan cortas, uno cada vez. Cuando llega se baja BASE_LEVEL: la textura
+// sigue siendo la misma, asi que los materiales que ya la tienen no se enteran.
+//
+// Todo lo que esta por encima de los mips fijos cuenta para budgetBytes. Si un nivel nuevo no cabe
+// se quitan antes los mips de arriba de las texturas que llevan mas tiempo sin pedirse (se sube
+// BASE_LEVEL y se deja el nivel con tamano 0 para que el driver libere su memoria).
+//
+// Si el tamano no se divide exacto hasta los mips fijos (p. ej. 70x45) el driver no puede deducir
+// el nivel 0 de los que tiene y al crearlo despues rehace la textura (Mesa pierde los otros
+// niveles). Esas se crean con todos los niveles desde el principio: se cargan igual por partes,
+// pero quitar un nivel solo sube BASE_LEVEL.
+class MipStreamer
+{
+public:
+    size_t budgetBytes = 96 * 1024 * 1024;
+    int residentSize = 64;     // lado maximo de los mips que se cargan al principio y no se quitan
+    float bias = 0.0f;         // > 0 pide menos resolucion (cada unidad es un nivel)
+    int maxLoadsInFlight = 8;  // niveles pedidos al TextureStreamer que aun no han llegado
+
+    // El TextureStreamer tiene que vivir mas que el MipStreamer (se declara antes)
+    explicit MipStreamer(TextureStreamer& streamer) : streamer(streamer) {}
+
+    MipStreamer(const MipStreamer&) = delete;
+    MipStreamer& operator=(const MipStreamer&) = delete;
+
+    // Crea la textura con sus mips pequenos. 0 si el .ktx no existe, no es valido o el driver no tiene el formato.
+    GLuint load(const std::string& path)
+    {
+        KtxImage header;
+        if (!readKtx(path, header, true))
+            return 0;
+        if (!compressedFormatSupported(header.internalFormat))
+        {
+            std::cout << "MIP_STREAMER::" << compressedFormatName(header.internalFormat) << " no soportado, se usa el original de " << path << std::endl;
+            return 0;
+        }
+        int levels = (int)header.levels.size();
+        int resident = 0;
+        while (resident + 1 < levels && std::max(levelWidth(header, resident), levelHeight(header, resident)) > residentSize)
+            resident++;
+
+        KtxImage image;
+        if (!readKtx(path, image, false, resident))
+            return 0;
+
+        bool fixedStorage = levelWidth(image, resident) << resident != image.width ||
+                            levelHeight(image, resident) << resident != image.height;
+
+        GLuint id;
+        glGenTextures(1, &id);
+        glBindTexture(GL_TEXTURE_2D, id);
+        for (int level = 0; level < resident && fixedStorage; level++)
+            glCompressedTexImage2D(GL_TEXTURE_2D, level, image.internalFormat, levelWidth(image, level), levelHeight(image, level), 0,
+                                   (GLsizei)levelBytes(image, level), nullptr);
+        for (int level = resident; level < levels; level++)
+            glCompressedTexImage2D(GL_TEXTURE_2D, level, image.internalFormat, levelWidth(image, level), levelHeight(image, level), 0,
+                                   (GLsizei)image.levels[level].size(), image.levels[level].data());
+        setCookedTextureParameters(GL_TEXTURE_2D, image);
+        glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_BASE_LEVEL, resident);
+        glBindTexture(GL_TEXTURE_2D, 0);
+
+        StreamedTexture& texture = textures[id];
+        texture.path = path;
+        texture.header = header;
+        texture.resident = resident;
+        texture.base = resident;
+        texture.wanted = resident;
+        texture.fixedStorage = fixedStorage;
+        texture.serial = ++serials;
+        return id;
+    }
+
+    // Deja de seguir una textura (se va a borrar, despues de esto). Si tenia un nivel en camino se
+    // cancela en el streamer para que no se suba a un id ya borrado.
+    void forget(GLuint id)
+    {
+        auto it = textures.find(id);
+        if (it == textures.end())
+            return;
+        streamer.cancel(id);
+        const StreamedTexture& texture = it->second;
+        streamedBytes -= bytesAbove(texture, texture.loading ? texture.base - 1 : texture.base);
+        textures.erase(it);
+    }
+
+    bool isStreamed(GLuint id) const { return textures.count(id) != 0; }
+
+    // La textura se ve este frame ocupando screenSize pixels (el diametro de lo que la usa)
+    void request(GLuint id, float screenSize)
+    {
+        auto it = textures.find(id);
+        if (it == textures.end())
+            return;
+        StreamedTexture& texture = it->second;
+        int size = std::max(texture.header.width, texture.header.height);
+        int level = (int)std::floor(std::log2(std::max(1.0f, (float)size / std::max(screenSize, 1.0f))) + bias);
+        texture.wanted = std::min(texture.wanted, std::max(0, std::min(level, texture.resident)));
+        texture.lastUse = frame;
+    }
+
+    // Todas las texturas de una lista (mesh.textures) con el mismo tamano en pantalla
+    template <typename TextureList>
+    void requestTextures(const TextureList& list, float screenSize)
+    {
+        for (const auto& texture : list)
+            request(texture.id, screenSize);
+    }
+
+    // Una vez por frame despues de los request: pide los niveles que faltan y quita los que no caben
+    void update()
+    {
+        // Las que mas se quedan cortas primero
+        std::vector<std::pair<int, GLuint>> candidates;
+        for (auto& entry : textures)
+        {
+            const StreamedTexture& texture = entry.second;
+            if (!texture.loading && !texture.failed && texture.wanted < texture.base)
+                candidates.push_back(std::make_pair(texture.wanted - texture.base, entry.first));
+        }
+        std::sort(candidates.begin(), candidates.end());
+
+        for (auto& candidate : candidates)
+        {
+            if (loadsInFlight >= maxLoadsInFlight)
+                break;
+            StreamedTexture& texture = textures[candidate.second];
+            int level = texture.base - 1;
+            size_t bytes = levelBytes(texture.header, level);
+            if (!makeRoom(bytes, candidate.second))
+            {
+                overBudget++;
+                break;
+            }
+            startLoad(candidate.second, texture, level);
+        }
+
+        // Lo pedido vale para este frame: el siguiente se vuelve a calcular
+        for (auto& entry : textures)
+            entry.second.wanted = entry.second.resident;
+        frame++;
+    }
+
+    size_t residentBytes() const { return streamedBytes; }
+
+    void report() const
+    {
+        unsigned int full = 0;
+        for (auto& entry : textures)
+            if (entry.second.base == 0)
+                full++;
+        std::cout << "MIP_STREAMER::" << textures.size() << " texturas (" << full << " a resolucion completa), "
+                  << streamedBytes / (1024 * 1024) << " de " << budgetBytes / (1024 * 1024) << " MB, "
+                  << loadedLevels << " niveles cargados, " << evictedLevels << " quitados, "
+                  << overBudget << " frames sin sitio" << std::endl;
+    }
+
+private:
+    struct StreamedTexture
+    {
+        std::string path;
+        KtxImage header;       // tamano, formato y numero de niveles (sin datos)
+        int resident = 0;      // primer nivel fijo
+        int base = 0;          // GL_TEXTURE_BASE_LEVEL: los niveles base.. estan en memoria
+        int wanted = 0;        // nivel que hace falta este frame
+        bool loading = false;  // base - 1 esta en el TextureStreamer
+        bool failed = false;   // un nivel no se pudo leer: no se piden mas
+        bool fixedStorage = false;   // todos los niveles creados desde el principio
+        uint64_t lastUse = 0;  // ultimo frame en que se pidio
+        uint64_t serial = 0;   // para reconocer la textura cuando vuelve el nivel
+    };
+
+    TextureStreamer& streamer;
+    std::map<GLuint, StreamedTexture> textures;
+    size_t streamedBytes = 0;   // niveles por encima de los fijos, incluidos los que estan en camino
+    int loadsInFlight = 0;
+    uint64_t frame = 1;
+    uint64_t serials = 0;
+    unsigned int loadedLevels = 0;
+    unsigned int evictedLevels = 0;
+    unsigned int overBudget = 0;
+
+    static int levelWidth(const KtxImage& image, int level) { return std::max(1, image.width >> level); }
+    static int levelHeight(const KtxImage& image, int level) { return std::max(1, image.height >> level); }
+
+    static size_t levelBytes(const KtxImage& image, int level)
+    {
+        return compressedLevelBytes(image.internalFormat, levelWidth(image, level), levelHeight(image, level));
+    }
+
+    // Bytes de los niveles que no son fijos desde level
+    static size_t bytesAbove(const StreamedTexture& texture, int level)
+    {
+        size_t bytes = 0;
+        for (int l = level; l < texture.resident; l++)
+            bytes += levelBytes(texture.header, l);
+        return bytes;
+    }
+
+    // Quita mips de arriba (la textura menos usada primero) hasta que quepan bytes mas. No toca
+    // las que estan cargando, la que se va a cargar ni las que se han pedido este frame a ese nivel.
+    bool makeRoom(size_t bytes, GLuint loadingId)
+    {
+        while (streamedBytes + bytes > budgetBytes)
+        {
+            GLuint victim = 0;
+            const StreamedTexture* oldest = nullptr;
+            for (auto& entry : textures)
+            {
+                const StreamedTexture& texture = entry.second;
+                if (entry.first == loadingId || texture.loading || texture.base >= texture.resident)
+                    continue;
+                if (texture.lastUse == frame && texture.base >= texture.wanted)
+                    continue;   // se esta viendo y no le sobra resolucion
+                if (!oldest || texture.lastUse < oldest->lastUse)
+                {
+                    oldest = &texture;
+                    victim = entry.first;
+                }
+            }
+            if (!oldest)
+                return false;
+            evictTop(victim, textures[victim]);
+        }
+        return true;
+    }
+
+    void evictTop(GLuint id, StreamedTexture& texture)
+    {
+        int level = texture.base;
+        texture.base++;
+        glBindTexture(GL_TEXTURE_2D, id);
+        glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_BASE_LEVEL, texture.base);
+        if (!texture.fixedStorage)
+            glCompressedTexImage2D(GL_TEXTURE_2D, level, texture.header.internalFormat, 0, 0, 0, 0, nullptr);
+        glBindTexture(GL_TEXTURE_2D, 0);
+        streamedBytes -= levelBytes(texture.header, level);
+        evictedLevels++;
+    }
+
+    void startLoad(GLuint id, StreamedTexture& texture, int level)
+    {
+        // El nivel se crea vacio y el TextureStreamer lo rellena; no se ve hasta bajar BASE_LEVEL
+        if (!texture.fixedStorage)
+        {
+            glBindTexture(GL_TEXTURE_2D, id);
+            glCompressedTexImage2D(GL_TEXTURE_2D, level, texture.header.internalFormat, levelWidth(texture.header, level),
+                                   levelHeight(texture.header, level), 0, (GLsizei)levelBytes(texture.header, level), nullptr);
+            glBindTexture(GL_TEXTURE_2D, 0);
+        }
+        texture.loading = true;
+        streamedBytes += levelBytes(texture.header, level);
+        loadsInFlight++;
+
+        std::string path = texture.path;
+        uint64_t serial = texture.serial;
+        streamer.enqueue(id, 0,
+                         [path, level](StreamImage& out) { return decodeLevel(path, level, out); },
+                         [this, id, serial, level](bool ok) { levelDone(id, serial, level, ok); },
+                         GL_TEXTURE_2D);
+    }
+
+    // En un hilo del TextureStreamer
+    static bool decodeLevel(const std::string& path, int level, StreamImage& out)
+    {
+        KtxImage image;
+        if (!readKtx(path, image, false, level) || level >= (int)image.levels.size())
+            return false;
+        out.width = image.width;
+        out.height = image.height;
+        out.compressed = image.internalFormat;
+        out.firstLevel = level;
+        out.levels.push_back(std::move(image.levels[level]));
+        return true;
+    }
+
+    // En el hilo de render, cuando el TextureStreamer ha subido el nivel
+    void levelDone(GLuint id, uint64_t serial, int level, bool ok)
+    {
+        loadsInFlight--;
+        auto it = textures.find(id);
+        if (it == textures.end() || it->second.serial != serial)
+            return;   // la textura se olvido mientras tanto
+        StreamedTexture& texture = it->second;
+        texture.loading = false;
+        glBindTexture(GL_TEXTURE_2D, id);
+        if (ok)
+        {
+            texture.base = level;
+            glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_BASE_LEVEL, level);
+            loadedLevels++;
+        }
+        else
+        {
+            std::cout << "MIP_STREAMER::No se pudo leer el nivel " << level << " de " << texture.path << std::endl;
+            if (!texture.fixedStorage)
+                glCompressedTexImage2D(GL_TEXTURE_2D, level, texture.header.internalFormat, 0, 0, 0, 0, nullptr);
+            streamedBytes -= levelBytes(texture.header, level);
+            texture.failed = true;
+        }
+        glBindTexture(GL_TEXTURE_2D, 0);
+    }
+};
+
+#endif
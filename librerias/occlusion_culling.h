@@ -0,0 +1,226 @@
+#ifndef OCCLUSION_CULLING_H
+#define OCCLUSION_CULLING_H
+
+#include <glad/glad.h>
+#include <glm/glm.hpp>
+#include <glm/gtc/matrix_transform.hpp>
+
+#include <learnopengl/program_cache.h>
+#include <learnopengl/model.h>
+#include <learnopengl/frustum_culling.h>
+#include <learnopengl/pvs.h>
+
+#include <vector>
+
+// Occlusion culling por hardware (GL 3.3, GL_ANY_SAMPLES_PASSED).
+//
+// Cada objeto (mesh de la casa o prop grande) tiene una query. Despues de dibujar la escena se
+// dibuja la caja envolvente de los objetos probados en el frame, sin escribir color ni profundidad.
+// En el frame siguiente se usa el resultado si ya esta disponible (nunca se espera a la GPU); si
+// todavia no lo esta, el objeto se dibuja con render condicional (GL_QUERY_NO_WAIT) para que sea la
+// propia GPU la que lo descarte cuando ya tenga el resultado.
+class OcclusionCuller
+{
+public:
+    bool enabled = true;
+
+    OcclusionCuller(const char* vertexPath, const char* fragmentPath)
+        : boxShader(vertexPath, fragmentPath)
+    {
+        // Cubo unitario [0,1]^3 dibujado con triangulos
+        float cube[] = {
+            0,0,0, 1,0,0, 1,1,0,  0,0,0, 1,1,0, 0,1,0,
+            0,0,1, 1,1,1, 1,0,1,  0,0,1, 0,1,1, 1,1,1,
+            0,0,0, 0,1,1, 0,0,1,  0,0,0, 0,1,0, 0,1,1,
+            1,0,0, 1,0,1, 1,1,1,  1,0,0, 1,1,1, 1,1,0,
+            0,0,0, 0,0,1, 1,0,1,  0,0,0, 1,0,1, 1,0,0,
+            0,1,0, 1,1,1, 0,1,1,  0,1,0, 1,1,0, 1,1,1
+        };
+        glGenVertexArrays(1, &boxVAO);
+        glGenBuffers(1, &boxVBO);
+        glBindVertexArray(boxVAO);
+        glBindBuffer(GL_ARRAY_BUFFER, boxVBO);
+        glBufferData(GL_ARRAY_BUFFER, sizeof(cube), cube, GL_STATIC_DRAW);
+        glEnableVertexAttribArray(0);
+        glVertexAttribPointer(0, 3, GL_FLOAT, GL_FALSE, 3 * sizeof(float), (void*)0);
+        glBindVertexArray(0);
+    }
+
+    ~OcclusionCuller()
+    {
+        for (const ObjectState& object : objects)
+            if (object.query != 0)
+                glDeleteQueries(1, &object.query);
+        glDeleteBuffers(1, &boxVBO);
+        glDeleteVertexArrays(1, &boxVAO);
+    }
+
+    // Reserva estado para los ids [0, count)
+    void resize(unsigned int count)
+    {
+        if (count > objects.size())
+            objects.resize(count);
+    }
+
+    // Decide si el objeto se dibuja este frame. Devuelve false si se puede saltar por completo.
+    // Si conditionalQuery sale distinto de 0 hay que dibujarlo dentro de glBeginConditionalRender con esa query.
+    bool test(unsigned int id, const AABB& box, const glm::vec3& cameraPos, GLuint& conditionalQuery)
+    {
+        resize(id + 1);
+        ObjectState& object = objects[id];
+        object.box = box;
+        tested.push_back(id);
+        conditionalQuery = 0;
+
+        if (!enabled)
+            return true;
+
+        // Si la camara esta dentro de la caja (o casi, por el plano cercano) la query no sirve
+        const float margin = 0.15f;
+        if (cameraPos.x > box.min.x - margin && cameraPos.x < box.max.x + margin &&
+            cameraPos.y > box.min.y - margin && cameraPos.y < box.max.y + margin &&
+            cameraPos.z > box.min.z - margin && cameraPos.z < box.max.z + margin)
+        {
+            object.visible = true;
+            return true;
+        }
+
+        if (object.pending)
+        {
+            GLuint available = 0;
+            glGetQueryObjectuiv(object.query, GL_QUERY_RESULT_AVAILABLE, &available);
+            if (available)
+            {
+                GLuint samples = 0;
+                glGetQueryObjectuiv(object.query, GL_QUERY_RESULT, &samples);
+                object.visible = samples != 0;
+                object.pending = false;
+            }
+        }
+
+        if (object.pending)
+        {
+            // Resultado aun en vuelo: que lo decida la GPU sin bloquear
+            conditionalQuery = object.query;
+            return true;
+        }
+        return object.visible;
+    }
+
+    // Dibuja las cajas de los objetos probados en este frame dentro de sus queries.
+    // Se llama una vez al final del frame, con toda la profundidad de la escena ya escrita.
+    void issueQueries(const glm::mat4& projection, const glm::mat4& view)
+    {
+        if (!enabled)
+        {
+            tested.clear();
+            return;
+        }
+
+        boxShader.use();
+        boxShader.setMat4("projection", projection);
+        boxShader.setMat4("view", view);
+
+        glColorMask(GL_FALSE, GL_FALSE, GL_FALSE, GL_FALSE);
+        glDepthMask(GL_FALSE);
+        glDepthFunc(GL_LEQUAL);
+        glBindVertexArray(boxVAO);
+
+        const float padding = 0.01f; // evita que una caja plana quede a la misma profundidad que su mesh
+        for (unsigned int id : tested)
+        {
+            ObjectState& object = objects[id];
+            if (object.pending)
+                continue;
+            if (object.query == 0)
+                glGenQueries(1, &object.query);
+
+            glm::vec3 size = object.box.max - object.box.min + glm::vec3(2.0f * padding);
+            glm::mat4 model = glm::translate(glm::mat4(1.0f), object.box.min - glm::vec3(padding));
+            model = glm::scale(model, size);
+            boxShader.setMat4("model", model);
+
+            glBeginQuery(GL_ANY_SAMPLES_PASSED, object.query);
+            glDrawArrays(GL_TRIANGLES, 0, 36);
+            glEndQuery(GL_ANY_SAMPLES_PASSED);
+            object.pending = true;
+        }
+
+        glBindVertexArray(0);
+        glDepthFunc(GL_LESS);
+        glDepthMask(GL_TRUE);
+        glColorMask(GL_TRUE, GL_TRUE, GL_TRUE, GL_TRUE);
+        tested.clear();
+    }
+
+private:
+    struct ObjectState
+    {
+        GLuint query = 0;
+        bool pending = false;     // hay una query enviada cuyo resultado no se ha leido
+        bool visible = true;      // ultimo resultado conocido
+        AABB box;
+    };
+
+    CachedShader boxShader;
+    unsigned int boxVAO = 0, boxVBO = 0;
+    std::vector<ObjectState> objects;
+    std::vector<unsigned int> tested;
+};
+
+// Mesh que sobrevive al culling en este frame
+struct VisibleMesh
+{
+    unsigned int index;
+    GLuint conditionalQuery;  // 0 si el resultado de la occlusion query ya se conoce
+    float depth;              // distancia de la camara al centro de la caja
+};
+
+// Frustum + occlusion culling por mesh. Los ids de los meshes son firstId + indice del mesh.
+// pvsBits (opcional) es el bitset precalculado de la celda de la camara y visibleMask (opcional) viene de la
+// visibilidad por portales; ambos descartan meshes antes de cualquier otra prueba.
+inline void cullMeshes(unsigned int meshCount, const std::vector<AABB>& bounds, const Frustum& frustum,
+                       OcclusionCuller& occlusion, unsigned int firstId, const glm::vec3& cameraPos, CullingStats& stats,
+                       std::vector<VisibleMesh>& visible,
+                       const std::vector<bool>* visibleMask = nullptr, const uint8_t* pvsBits = nullptr)
+{
+    visible.clear();
+    for (unsigned int i = 0; i < meshCount; i++)
+    {
+        stats.tested++;
+        if (pvsBits && !PVSData::isVisible(pvsBits, (unsigned int)i))
+        {
+            stats.pvsCulled++;
+            continue;
+        }
+        if (visibleMask && i < visibleMask->size() && !(*visibleMask)[i])
+        {
+            stats.portalCulled++;
+            continue;
+        }
+        // Sin caja no se puede probar contra el frustum ni con una query: se dibuja
+        if (i >= bounds.size())
+        {
+            visible.push_back({ i, 0, 0.0f });
+            stats.drawn++;
+            continue;
+        }
+        if (!frustum.intersects(bounds[i]))
+        {
+            stats.culled++;
+            continue;
+        }
+        unsigned int id = firstId + (unsigned int)i;
+        GLuint conditionalQuery = 0;
+        if (!occlusion.test(id, bounds[i], cameraPos, conditionalQuery))
+        {
+            stats.occluded++;
+            continue;
+        }
+        float depth = glm::length((bounds[i].min + bounds[i].max) * 0.5f - cameraPos);
+        visible.push_back({ i, conditionalQuery, depth });
+        stats.drawn++;
+    }
+}
+
+#endif
@@ -0,0 +1,353 @@
+#ifndef PORTAL_VISIBILITY_H
+#define PORTAL_VISIBILITY_H
+
+#include <glm/glm.hpp>
+
+#include <learnopengl/frustum_culling.h>
+
+#include <vector>
+#include <string>
+#include <fstream>
+#include <sstream>
+#include <iostream>
+#include <algorithm>
+#include <cfloat>
+
+// Visibilidad por celdas y portales para el interior de la casa.
+//
+// Las celdas (habitaciones) son cajas y los portales son poligonos (puertas, ventanas) que conectan
+// dos celdas. Se definen a mano en un archivo de texto:
+//
+//   cell   <nombre> <minX> <minY> <minZ> <maxX> <maxY> <maxZ>
+//   portal <celdaA> <celdaB> <x y z> <x y z> <x y z> [<x y z> ...]
+//
+// Cada frame se parte de la celda de la camara y se recorren los portales recursivamente. Cada
+// portal se recorta contra el plano cercano, se proyecta a pantalla y su rectangulo se intersecta
+// con el rectangulo por el que se llego; si queda vacio, la celda de detras no se ve por ahi. Si
+// el portal cruza el plano cercano (la camara esta en la puerta) pasa el rectangulo entero.
+// Si la camara no esta dentro de ninguna celda (por ejemplo fuera de la casa) todo es visible.
+class CellPortalGraph
+{
+public:
+    // Rectangulo en coordenadas normalizadas de pantalla
+    struct ScreenRect
+    {
+        float minX, minY, maxX, maxY;
+
+        bool empty() const { return minX >= maxX || minY >= maxY; }
+        ScreenRect intersect(const ScreenRect& o) const
+        {
+            return { std::max(minX, o.minX), std::max(minY, o.minY), std::min(maxX, o.maxX), std::min(maxY, o.maxY) };
+        }
+        ScreenRect merge(const ScreenRect& o) const
+        {
+            return { std::min(minX, o.minX), std::min(minY, o.minY), std::max(maxX, o.maxX), std::max(maxY, o.maxY) };
+        }
+    };
+
+    struct Portal
+    {
+        int targetCell;
+        std::vector<glm::vec3> polygon;
+    };
+
+    struct Cell
+    {
+        std::string name;
+        AABB bounds;
+        std::vector<Portal> portals;
+        std::vector<unsigned int> meshes;
+
+        // estado del frame
+        bool visible = false;
+        ScreenRect rect;
+    };
+
+    int maxDepth = 16;
+
+    // Carga el archivo de celdas. Devuelve false (y el sistema queda desactivado) si no existe o esta mal.
+    bool load(const char* path)
+    {
+        cells.clear();
+        std::ifstream file(path);
+        if (!file.is_open())
+        {
+            std::cout << "PORTALS::No se encontro el archivo de celdas: " << path << std::endl;
+            return false;
+        }
+
+        std::string line;
+        int lineNumber = 0;
+        while (std::getline(file, line))
+        {
+            lineNumber++;
+            std::istringstream in(line);
+            std::string keyword;
+            if (!(in >> keyword) || keyword[0] == '#')
+                continue;
+
+            if (keyword == "cell")
+            {
+                Cell cell;
+                in >> cell.name >> cell.bounds.min.x >> cell.bounds.min.y >> cell.bounds.min.z
+                   >> cell.bounds.max.x >> cell.bounds.max.y >> cell.bounds.max.z;
+                if (in.fail())
+                {
+                    std::cout << "PORTALS::Celda mal definida en la linea " << lineNumber << std::endl;
+                    continue;
+                }
+                cells.push_back(cell);
+            }
+            else if (keyword == "portal")
+            {
+                std::string nameA, nameB;
+                in >> nameA >> nameB;
+                int a = findCellByName(nameA), b = findCellByName(nameB);
+                std::vector<glm::vec3> polygon;
+                glm::vec3 p;
+                while (in >> p.x >> p.y >> p.z)
+                    polygon.push_back(p);
+                if (a < 0 || b < 0 || polygon.size() < 3)
+                {
+                    std::cout << "PORTALS::Portal mal definido en la linea " << lineNumber << std::endl;
+                    continue;
+                }
+                cells[a].portals.push_back({ b, polygon });
+                cells[b].portals.push_back({ a, polygon });
+            }
+        }
+        std::cout << "PORTALS::" << cells.size() << " celdas cargadas de " << path << std::endl;
+        return !cells.empty();
+    }
+
+    // Asigna cada mesh a las celdas cuya caja toca. Los meshes que no tocan ninguna se dibujan siempre.
+    void assignMeshes(const std::vector<AABB>& meshBounds)
+    {
+        meshCells.assign(meshBounds.size(), std::vector<int>());
+        for (Cell& cell : cells)
+            cell.meshes.clear();
+        for (unsigned int i = 0; i < meshBounds.size(); i++)
+        {
+            for (int c = 0; c < (int)cells.size(); c++)
+            {
+                if (overlaps(meshBounds[i], cells[c].bounds))
+                {
+                    cells[c].meshes.push_back(i);
+                    meshCells[i].push_back(c);
+                }
+            }
+        }
+        this->meshBounds = meshBounds;
+        visibleMeshes.assign(meshBounds.size(), true);
+    }
+
+    // Luces con su alcance: una luz cuenta como visible si su esfera toca alguna celda visible
+    // (aunque ella este en otra habitacion, ilumina lo que se ve por la puerta)
+    void assignLights(const std::vector<glm::vec3>& lightPositions, float range)
+    {
+        this->lightPositions = lightPositions;
+        lightRange = range;
+        visibleLights.assign(lightPositions.size(), true);
+    }
+
+    int findCell(const glm::vec3& p) const
+    {
+        for (int c = 0; c < (int)cells.size(); c++)
+        {
+            const AABB& b = cells[c].bounds;
+            if (p.x >= b.min.x && p.x <= b.max.x && p.y >= b.min.y && p.y <= b.max.y && p.z >= b.min.z && p.z <= b.max.z)
+                return c;
+        }
+        return -1;
+    }
+
+    // Calcula el conjunto visible del frame
+    void computeVisibility(const glm::vec3& cameraPos, const glm::mat4& viewProjection)
+    {
+        for (Cell& cell : cells)
+            cell.visible = false;
+
+        cameraCell = findCell(cameraPos);
+        if (cameraCell < 0)
+        {
+            std::fill(visibleMeshes.begin(), visibleMeshes.end(), true);
+            std::fill(visibleLights.begin(), visibleLights.end(), true);
+            return;
+        }
+
+        ScreenRect fullScreen = { -1.0f, -1.0f, 1.0f, 1.0f };
+        std::vector<int> path;
+        visitCell(cameraCell, fullScreen, viewProjection, path);
+
+        for (unsigned int i = 0; i < visibleMeshes.size(); i++)
+        {
+            if (meshCells[i].empty())
+            {
+                visibleMeshes[i] = true;
+                continue;
+            }
+            bool visible = false;
+            ScreenRect meshRect = projectBox(meshBounds[i], viewProjection);
+            for (int c : meshCells[i])
+            {
+                if (!cells[c].visible)
+                    continue;
+                if (c == cameraCell || !meshRect.intersect(cells[c].rect).empty())
+                {
+                    visible = true;
+                    break;
+                }
+            }
+            visibleMeshes[i] = visible;
+        }
+
+        for (unsigned int i = 0; i < visibleLights.size(); i++)
+        {
+            visibleLights[i] = false;
+            for (const Cell& cell : cells)
+            {
+                if (cell.visible && sphereOverlaps(cell.bounds, lightPositions[i], lightRange))
+                {
+                    visibleLights[i] = true;
+                    break;
+                }
+            }
+        }
+    }
+
+    bool active() const { return cameraCell >= 0; }
+    bool isLightVisible(unsigned int light) const { return light >= visibleLights.size() || visibleLights[light]; }
+
+    // Para objetos que se mueven (el fantasma): visible si su celda lo es o si no esta en ninguna
+    bool isPointVisible(const glm::vec3& p) const
+    {
+        if (cameraCell < 0)
+            return true;
+        int c = findCell(p);
+        return c < 0 || cells[c].visible;
+    }
+
+    // Mascara por mesh (visible por portales) para cullMeshes
+    const std::vector<bool>& meshMask() const { return visibleMeshes; }
+
+private:
+    std::vector<Cell> cells;
+    std::vector<AABB> meshBounds;
+    std::vector<std::vector<int>> meshCells;
+    std::vector<glm::vec3> lightPositions;
+    float lightRange = 0.0f;
+    std::vector<bool> visibleMeshes;
+    std::vector<bool> visibleLights;
+    int cameraCell = -1;
+
+    int findCellByName(const std::string& name) const
+    {
+        for (int c = 0; c < (int)cells.size(); c++)
+            if (cells[c].name == name)
+                return c;
+        return -1;
+    }
+
+    static bool overlaps(const AABB& a, const AABB& b)
+    {
+        return a.min.x <= b.max.x && a.max.x >= b.min.x &&
+               a.min.y <= b.max.y && a.max.y >= b.min.y &&
+               a.min.z <= b.max.z && a.max.z >= b.min.z;
+    }
+
+    static bool sphereOverlaps(const AABB& box, const glm::vec3& center, float radius)
+    {
+        glm::vec3 d = glm::clamp(center, box.min, box.max) - center;
+        return glm::dot(d, d) <= radius * radius;
+    }
+
+    void visitCell(int c, const ScreenRect& rect, const glm::mat4& viewProjection, std::vector<int>& path)
+    {
+        Cell& cell = cells[c];
+        cell.rect = cell.visible ? cell.rect.merge(rect) : rect;
+        cell.visible = true;
+
+        if ((int)path.size() >= maxDepth)
+            return;
+
+        path.push_back(c);
+        for (const Portal& portal : cell.portals)
+        {
+            // No volver por una celda que ya esta en el camino actual
+            if (std::find(path.begin(), path.end(), portal.targetCell) != path.end())
+                continue;
+
+            // Con la camara en la puerta (el portal cruza el plano cercano) el rectangulo recortado
+            // puede quedar casi plano aunque se vea por el: se usa entero el rectangulo por el que se llego
+            bool crossesNear = false;
+            ScreenRect portalRect = projectPolygon(portal.polygon, viewProjection, crossesNear);
+            ScreenRect clipped = crossesNear ? rect : rect.intersect(portalRect);
+            if (!clipped.empty())
+                visitCell(portal.targetCell, clipped, viewProjection, path);
+        }
+        path.pop_back();
+    }
+
+    // Rectangulo en pantalla de un poligono recortado contra el plano cercano (w > nearW) en clip
+    // space: entran los vertices de delante y los puntos donde cada arista cruza el plano. Asi un
+    // portal en el que esta la camara da un rectangulo que llega a los bordes de la pantalla en vez
+    // de perderse. Si queda entero detras el rectangulo es vacio. crossesNear dice si se recorto.
+    static ScreenRect projectPolygon(const std::vector<glm::vec3>& polygon, const glm::mat4& viewProjection, bool& crossesNear)
+    {
+        ScreenRect rect = { FLT_MAX, FLT_MAX, -FLT_MAX, -FLT_MAX };
+        glm::vec4 previous = viewProjection * glm::vec4(polygon.back(), 1.0f);
+        crossesNear = false;
+        for (const glm::vec3& p : polygon)
+        {
+            glm::vec4 v = viewProjection * glm::vec4(p, 1.0f);
+            crossesNear |= addClippedEdge(rect, previous, v);
+            previous = v;
+        }
+        return rect;
+    }
+
+    // Lo mismo con las 8 esquinas y las 12 aristas de una caja
+    static ScreenRect projectBox(const AABB& box, const glm::mat4& viewProjection)
+    {
+        glm::vec4 corners[8];
+        for (int i = 0; i < 8; i++)
+        {
+            corners[i] = viewProjection * glm::vec4(i & 1 ? box.max.x : box.min.x,
+                                                    i & 2 ? box.max.y : box.min.y,
+                                                    i & 4 ? box.max.z : box.min.z, 1.0f);
+        }
+        ScreenRect rect = { FLT_MAX, FLT_MAX, -FLT_MAX, -FLT_MAX };
+        for (int i = 0; i < 8; i++)
+            for (int axis = 1; axis < 8; axis <<= 1)
+                if (!(i & axis))
+                    addClippedEdge(rect, corners[i], corners[i | axis]);
+        return rect;
+    }
+
+    // Anade al rectangulo el final b de la arista si esta delante del plano cercano, y el punto de
+    // corte si la arista lo cruza (y entonces devuelve true)
+    static bool addClippedEdge(ScreenRect& rect, const glm::vec4& a, const glm::vec4& b)
+    {
+        const float nearW = 1e-4f;
+        bool crosses = (a.w > nearW) != (b.w > nearW);
+        if (crosses)
+        {
+            float t = (nearW - a.w) / (b.w - a.w);
+            addPoint(rect, a + (b - a) * t);
+        }
+        if (b.w > nearW)
+            addPoint(rect, b);
+        return crosses;
+    }
+
+    static void addPoint(ScreenRect& rect, const glm::vec4& v)
+    {
+        float x = v.x / v.w, y = v.y / v.w;
+        rect.minX = std::min(rect.minX, x);
+        rect.minY = std::min(rect.minY, y);
+        rect.maxX = std::max(rect.maxX, x);
+        rect.maxY = std::max(rect.maxY, y);
+    }
+};
+
+#endif
@@ -0,0 +1,389 @@
+#ifndef PROGRAM_CACHE_H
+#define PROGRAM_CACHE_H
+
+#include <glad/glad.h>
+#include <GLFW/glfw3.h>
+#include <glm/glm.hpp>
+#include <glm/gtc/type_ptr.hpp>
+
+#include <vector>
+#include <map>
+#include <string>
+#include <fstream>
+#include <sstream>
+#include <iostream>
+#include <cstdio>
+#include <cstdint>
+
+#ifdef _WIN32
+#include <direct.h>
+#else
+#include <sys/stat.h>
+#endif
+
+// Constantes de GL 4.1 / ARB_get_program_binary y KHR_parallel_shader_compile que no estan en el glad de GL 3.3
+#ifndef GL_PROGRAM_BINARY_RETRIEVABLE_HINT
+#define GL_PROGRAM_BINARY_RETRIEVABLE_HINT 0x8257
+#endif
+#ifndef GL_PROGRAM_BINARY_LENGTH
+#define GL_PROGRAM_BINARY_LENGTH 0x8741
+#endif
+#ifndef GL_NUM_PROGRAM_BINARY_FORMATS
+#define GL_NUM_PROGRAM_BINARY_FORMATS 0x87FE
+#endif
+#ifndef GL_MAX_SHADER_COMPILER_THREADS_KHR
+#define GL_MAX_SHADER_COMPILER_THREADS_KHR 0x91B0
+#endif
+#ifndef GL_COMPLETION_STATUS_KHR
+#define GL_COMPLETION_STATUS_KHR 0x91B1
+#endif
+
+// Cache de programas enlazados y compilacion en paralelo.
+//
+// request() no espera a nada: si hay un binario guardado con la misma clave lo carga con
+// glProgramBinary; si no, manda a compilar y enlazar los dos shaders sin pedir el estado, asi el
+// driver puede trabajar con todos a la vez (con KHR_parallel_shader_compile en sus propios hilos)
+// mientras se cargan los modelos. finish() pide el estado del enlazado, escribe los errores y
+// guarda el binario nuevo. El programa se puede usar antes de finish (GL espera por su cuenta).
+//
+// La clave es un hash del codigo fuente de los dos shaders (ya con los #defines) y de
+// GL_VENDOR, GL_RENDERER y GL_VERSION: si cambia el shader o el driver el binario no coincide, se
+// compila del codigo y se sobrescribe. Si el driver rechaza un binario con la clave correcta
+// tambien se vuelve a compilar, ya en request(): el programa se puede usar antes de finish y no
+// puede quedar sin enlazar. Hay un archivo por programa, con el nombre del hash de su nombre.
+class ProgramCache
+{
+public:
+    std::string directory = "shader_cache";
+    bool enabled = true;   // false = siempre desde el codigo, sin leer ni escribir binarios
+
+    static ProgramCache& instance()
+    {
+        static ProgramCache cache;
+        return cache;
+    }
+
+    // Devuelve el programa, que puede estar todavia compilandose. name identifica el programa
+    // (rutas y #defines) para elegir su archivo en la cache.
+    GLuint request(const std::string& name, const std::string& vertexSource, const std::string& fragmentSource)
+    {
+        loadExtensions();
+
+        Pending pending;
+        pending.name = name;
+        pending.vertexSource = vertexSource;
+        pending.fragmentSource = fragmentSource;
+        pending.key = hash(vertexSource + '\0' + fragmentSource + '\0' + driver);
+
+        GLuint program = glCreateProgram();
+        if (binarySupported && enabled && loadBinary(program, pending))
+        {
+            pending.fromBinary = true;
+            hits++;
+        }
+        else
+        {
+            compile(program, pending);
+            misses++;
+        }
+        this->pending[program] = pending;
+        return program;
+    }
+
+    // Sin bloquear: true si el programa ya esta enlazado (sin la extension solo se sabe esperando)
+    bool isReady(GLuint program) const
+    {
+        if (!pending.count(program))
+            return true;
+        if (!parallelCompile)
+            return false;
+        GLint done = 0;
+        glGetProgramiv(program, GL_COMPLETION_STATUS_KHR, &done);
+        return done != 0;
+    }
+
+    // Espera al enlazado, escribe los errores y guarda el binario si se compilo del codigo
+    bool finish(GLuint program)
+    {
+        auto it = pending.find(program);
+        if (it == pending.end())
+            return true;
+        Pending entry = it->second;
+        pending.erase(it);
+
+        GLint success = 0;
+        glGetProgramiv(program, GL_LINK_STATUS, &success);
+        if (!entry.fromBinary)
+        {
+            if (!success)
+                printErrors(program, entry);
+            glDetachShader(program, entry.vertex);
+            glDetachShader(program, entry.fragment);
+            glDeleteShader(entry.vertex);
+            glDeleteShader(entry.fragment);
+            if (success && binarySupported && enabled)
+                saveBinary(program, entry);
+        }
+        return success != 0;
+    }
+
+    void finishAll()
+    {
+        while (!pending.empty())
+            finish(pending.begin()->first);
+    }
+
+    void report() const
+    {
+        std::cout << "PROGRAM_CACHE::" << hits << " programas de la cache, " << misses << " compilados"
+                  << (binarySupported ? "" : " (binarios no soportados)")
+                  << (parallelCompile ? ", compilacion en paralelo" : "") << std::endl;
+    }
+
+    static std::string readFile(const std::string& path)
+    {
+        std::ifstream file(path);
+        if (!file.is_open())
+        {
+            std::cout << "PROGRAM_CACHE::No se pudo leer " << path << std::endl;
+            return std::string();
+        }
+        std::stringstream stream;
+        stream << file.rdbuf();
+        return stream.str();
+    }
+
+private:
+    typedef void (APIENTRYP GetProgramBinaryProc)(GLuint program, GLsizei bufSize, GLsizei* length, GLenum* binaryFormat, void* binary);
+    typedef void (APIENTRYP ProgramBinaryProc)(GLuint program, GLenum binaryFormat, const void* binary, GLsizei length);
+    typedef void (APIENTRYP ProgramParameteriProc)(GLuint program, GLenum pname, GLint value);
+    typedef void (APIENTRYP MaxShaderCompilerThreadsProc)(GLuint count);
+
+    struct Pending
+    {
+        std::string name;
+        std::string vertexSource;
+        std::string fragmentSource;
+        uint64_t key = 0;
+        GLuint vertex = 0;
+        GLuint fragment = 0;
+        bool fromBinary = false;
+    };
+
+    std::map<GLuint, Pending> pending;
+    std::string driver;   // GL_VENDOR, GL_RENDERER y GL_VERSION
+    bool loaded = false;
+    bool binarySupported = false;
+    bool parallelCompile = false;
+    GetProgramBinaryProc getProgramBinary = nullptr;
+    ProgramBinaryProc programBinary = nullptr;
+    ProgramParameteriProc programParameteri = nullptr;
+    unsigned int hits = 0;
+    unsigned int misses = 0;
+
+    ProgramCache() = default;
+    ProgramCache(const ProgramCache&) = delete;
+    ProgramCache& operator=(const ProgramCache&) = delete;
+
+    static const char* magic() { return "TPB1"; }
+
+    // La primera vez, con el contexto ya creado
+    void loadExtensions()
+    {
+        if (loaded)
+            return;
+        loaded = true;
+
+        driver = std::string((const char*)glGetString(GL_VENDOR)) + '\n' + (const char*)glGetString(GL_RENDERER) + '\n' +
+                 (const char*)glGetString(GL_VERSION);
+
+        GLint major = 0, minor = 0;
+        glGetIntegerv(GL_MAJOR_VERSION, &major);
+        glGetIntegerv(GL_MINOR_VERSION, &minor);
+        if (major > 4 || (major == 4 && minor >= 1) || glfwExtensionSupported("GL_ARB_get_program_binary"))
+        {
+            getProgramBinary = (GetProgramBinaryProc)glfwGetProcAddress("glGetProgramBinary");
+            programBinary = (ProgramBinaryProc)glfwGetProcAddress("glProgramBinary");
+            programParameteri = (ProgramParameteriProc)glfwGetProcAddress("glProgramParameteri");
+        }
+        // Algunos drivers no ofrecen ningun formato aunque tengan la funcion
+        GLint formats = 0;
+        if (getProgramBinary)
+            glGetIntegerv(GL_NUM_PROGRAM_BINARY_FORMATS, &formats);
+        binarySupported = getProgramBinary && programBinary && programParameteri && formats > 0;
+
+        MaxShaderCompilerThreadsProc maxThreads = nullptr;
+        if (glfwExtensionSupported("GL_KHR_parallel_shader_compile"))
+            maxThreads = (MaxShaderCompilerThreadsProc)glfwGetProcAddress("glMaxShaderCompilerThreadsKHR");
+        else if (glfwExtensionSupported("GL_ARB_parallel_shader_compile"))
+            maxThreads = (MaxShaderCompilerThreadsProc)glfwGetProcAddress("glMaxShaderCompilerThreadsARB");
+        if (maxThreads)
+        {
+            maxThreads(0xFFFFFFFF);   // tantos hilos como quiera el driver
+            parallelCompile = true;
+        }
+
+        if (binarySupported)
+            makeDirectory(directory);
+    }
+
+    // FNV-1a de 64 bits
+    static uint64_t hash(const std::string& text)
+    {
+        uint64_t h = 14695981039346656037ull;
+        for (unsigned char c : text)
+        {
+            h ^= c;
+            h *= 1099511628211ull;
+        }
+        return h;
+    }
+
+    static void makeDirectory(const std::string& path)
+    {
+#ifdef _WIN32
+        _mkdir(path.c_str());
+#else
+        mkdir(path.c_str(), 0755);
+#endif
+    }
+
+    std::string binaryPath(const std::string& name) const
+    {
+        char file[32];
+        std::snprintf(file, sizeof(file), "/%016llx.bin", (unsigned long long)hash(name));
+        return directory + file;
+    }
+
+    // Manda a compilar y enlazar sin pedir el estado (eso lo hace finish)
+    void compile(GLuint program, Pending& entry)
+    {
+        entry.vertex = compileStage(GL_VERTEX_SHADER, entry.vertexSource);
+        entry.fragment = compileStage(GL_FRAGMENT_SHADER, entry.fragmentSource);
+        glAttachShader(program, entry.vertex);
+        glAttachShader(program, entry.fragment);
+        if (binarySupported && enabled)
+            programParameteri(program, GL_PROGRAM_BINARY_RETRIEVABLE_HINT, GL_TRUE);
+        glLinkProgram(program);
+    }
+
+    static GLuint compileStage(GLenum type, const std::string& source)
+    {
+        GLuint shader = glCreateShader(type);
+        const char* code = source.c_str();
+        glShaderSource(shader, 1, &code, nullptr);
+        glCompileShader(shader);
+        return shader;
+    }
+
+    static void printErrors(GLuint program, const Pending& entry)
+    {
+        char log[1024];
+        GLint success = 0;
+        glGetShaderiv(entry.vertex, GL_COMPILE_STATUS, &success);
+        if (!success)
+        {
+            glGetShaderInfoLog(entry.vertex, sizeof(log), nullptr, log);
+            std::cout << "PROGRAM_CACHE::Error compilando el vertex shader de " << entry.name << "\n" << log << std::endl;
+        }
+        glGetShaderiv(entry.fragment, GL_COMPILE_STATUS, &success);
+        if (!success)
+        {
+            glGetShaderInfoLog(entry.fragment, sizeof(log), nullptr, log);
+            std::cout << "PROGRAM_CACHE::Error compilando el fragment shader de " << entry.name << "\n" << log << std::endl;
+        }
+        glGetProgramInfoLog(program, sizeof(log), nullptr, log);
+        std::cout << "PROGRAM_CACHE::Error enlazando " << entry.name << "\n" << log << std::endl;
+    }
+
+    // Formato: "TPB1", clave (uint64), formato del binario (uint32), tamano (uint32), binario
+    bool loadBinary(GLuint program, const Pending& entry)
+    {
+        std::ifstream file(binaryPath(entry.name), std::ios::binary);
+        if (!file.is_open())
+            return false;
+        char header[4] = {};
+        uint64_t key = 0;
+        uint32_t format = 0, length = 0;
+        file.read(header, 4);
+        file.read((char*)&key, sizeof(key));
+        file.read((char*)&format, sizeof(format));
+        file.read((char*)&length, sizeof(length));
+        if (!file || std::string(header, 4) != magic() || key != entry.key || length == 0)
+            return false;
+        std::vector<char> binary(length);
+        if (!file.read(binary.data(), length))
+            return false;
+        programBinary(program, (GLenum)format, binary.data(), (GLsizei)length);
+
+        // glProgramBinary no compila nada: el estado se sabe enseguida y se pide aqui para que
+        // un binario rechazado (p. ej. actualizacion con la misma cadena de version) se compile
+        // antes de que alguien use el programa
+        GLint success = 0;
+        glGetProgramiv(program, GL_LINK_STATUS, &success);
+        if (!success)
+        {
+            std::cout << "PROGRAM_CACHE::Binario rechazado, se compila " << entry.name << std::endl;
+            return false;
+        }
+        return true;
+    }
+
+    void saveBinary(GLuint program, const Pending& entry)
+    {
+        GLint length = 0;
+        glGetProgramiv(program, GL_PROGRAM_BINARY_LENGTH, &length);
+        if (length <= 0)
+            return;
+        std::vector<char> binary(length);
+        GLenum format = 0;
+        getProgramBinary(program, length, nullptr, &format, binary.data());
+
+        std::ofstream file(binaryPath(entry.name), std::ios::binary | std::ios::trunc);
+        if (!file.is_open())
+        {
+            std::cout << "PROGRAM_CACHE::No se pudo escribir en " << directory << std::endl;
+            return;
+        }
+        uint32_t format32 = format, length32 = (uint32_t)length;
+        file.write(magic(), 4);
+        file.write((const char*)&entry.key, sizeof(entry.key));
+        file.write((const char*)&format32, sizeof(format32));
+        file.write((const char*)&length32, sizeof(length32));
+        file.write(binary.data(), length);
+    }
+};
+
+// Sustituto de Shader de learnopengl que pasa por la ProgramCache: mismos setters, pero el
+// constructor no espera a que termine la compilacion (ver ProgramCache::finishAll).
+class CachedShader
+{
+public:
+    unsigned int ID = 0;
+
+    CachedShader() = default;
+
+    CachedShader(const char* vertexPath, const char* fragmentPath)
+    {
+        ID = ProgramCache::instance().request(std::string(vertexPath) + "|" + fragmentPath,
+                                              ProgramCache::readFile(vertexPath), ProgramCache::readFile(fragmentPath));
+    }
+
+    void use() const { glUseProgram(ID); }
+    void setBool(const std::string& name, bool value) const { glUniform1i(location(name), (int)value); }
+    void setInt(const std::string& name, int value) const { glUniform1i(location(name), value); }
+    void setFloat(const std::string& name, float value) const { glUniform1f(location(name), value); }
+    void setVec2(const std::string& name, const glm::vec2& value) const { glUniform2fv(location(name), 1, glm::value_ptr(value)); }
+    void setVec2(const std::string& name, float x, float y) const { glUniform2f(location(name), x, y); }
+    void setVec3(const std::string& name, const glm::vec3& value) const { glUniform3fv(location(name), 1, glm::value_ptr(value)); }
+    void setVec3(const std::string& name, float x, float y, float z) const { glUniform3f(location(name), x, y, z); }
+    void setVec4(const std::string& name, const glm::vec4& value) const { glUniform4fv(location(name), 1, glm::value_ptr(value)); }
+    void setVec4(const std::string& name, float x, float y, float z, float w) const { glUniform4f(location(name), x, y, z, w); }
+    void setMat3(const std::string& name, const glm::mat3& value) const { glUniformMatrix3fv(location(name), 1, GL_FALSE, glm::value_ptr(value)); }
+    void setMat4(const std::string& name, const glm::mat4& value) const { glUniformMatrix4fv(location(name), 1, GL_FALSE, glm::value_ptr(value)); }
+
+private:
+    GLint location(const std::string& name) const { return glGetUniformLocation(ID, name.c_str()); }
+};
+
+#endif
@@ -0,0 +1,208 @@
+#ifndef PVS_H
+#define PVS_H
+
+#include <glm/glm.hpp>
+
+#include <vector>
+#include <fstream>
+#include <iostream>
+#include <cstdint>
+#include <cstring>
+#include <cmath>
+
+// Potentially Visible Set precalculado (lo genera PVSBaker.cpp).
+//
+// El suelo de la casa se divide en una rejilla de celdas en XZ. Para cada celda caminable se guarda
+// un bitset con un bit por mesh de la casa (1 = visible desde algun punto de la celda). Los bitsets
+// repetidos se guardan una sola vez y cada uno va comprimido con RLE de bytes a cero, porque la
+// mayoria de los meshes no se ven desde una celda dada.
+//
+// Formato del archivo (little endian):
+//   char[4]  "PVS1"
+//   float    originX, originZ, cellSize
+//   uint32   cellsX, cellsZ, meshCount, vertexCount
+//   uint32   setCount
+//   setCount x { uint32 compressedSize; uint8 data[compressedSize] }
+//   uint32   cellSet[cellsX * cellsZ]   (PVS_NO_SET si la celda no es caminable)
+const uint32_t PVS_NO_SET = 0xFFFFFFFFu;
+
+struct PVSData
+{
+    float originX = 0.0f, originZ = 0.0f, cellSize = 1.0f;
+    uint32_t cellsX = 0, cellsZ = 0;
+    uint32_t meshCount = 0;
+    uint32_t vertexCount = 0;                  // para detectar que el modelo cambio desde el bake
+    std::vector<std::vector<uint8_t>> sets;    // bitsets unicos, sin comprimir
+    std::vector<uint32_t> cellSet;             // indice en sets por celda
+
+    uint32_t bytesPerSet() const { return (meshCount + 7) / 8; }
+
+    // Consulta en tiempo de ejecucion: un indice y un puntero. nullptr si la posicion no tiene datos.
+    const uint8_t* lookup(const glm::vec3& position) const
+    {
+        if (cellSet.empty())
+            return nullptr;
+        int x = (int)std::floor((position.x - originX) / cellSize);
+        int z = (int)std::floor((position.z - originZ) / cellSize);
+        if (x < 0 || z < 0 || x >= (int)cellsX || z >= (int)cellsZ)
+            return nullptr;
+        uint32_t set = cellSet[(size_t)z * cellsX + x];
+        return set == PVS_NO_SET ? nullptr : sets[set].data();
+    }
+
+    static bool isVisible(const uint8_t* bits, unsigned int mesh)
+    {
+        return (bits[mesh >> 3] >> (mesh & 7)) & 1;
+    }
+
+    // RLE: un byte distinto de cero se copia tal cual; una racha de ceros se guarda como 0x00 + longitud (1..255)
+    static std::vector<uint8_t> compress(const std::vector<uint8_t>& bits)
+    {
+        std::vector<uint8_t> out;
+        for (size_t i = 0; i < bits.size();)
+        {
+            if (bits[i] != 0)
+            {
+                out.push_back(bits[i++]);
+                continue;
+            }
+            size_t run = 0;
+            while (i < bits.size() && bits[i] == 0 && run < 255)
+            {
+                i++;
+                run++;
+            }
+            out.push_back(0);
+            out.push_back((uint8_t)run);
+        }
+        return out;
+    }
+
+    static bool decompress(const std::vector<uint8_t>& data, size_t expectedSize, std::vector<uint8_t>& bits)
+    {
+        bits.clear();
+        bits.reserve(expectedSize);
+        for (size_t i = 0; i < data.size(); i++)
+        {
+            if (data[i] != 0)
+            {
+                bits.push_back(data[i]);
+                continue;
+            }
+            if (++i >= data.size())
+                return false;
+            bits.insert(bits.end(), data[i], 0);
+        }
+        return bits.size() == expectedSize;
+    }
+
+    // Devuelve el indice del set (reutilizando uno igual si ya existe)
+    uint32_t addSet(const std::vector<uint8_t>& bits)
+    {
+        for (uint32_t i = 0; i < sets.size(); i++)
+            if (sets[i] == bits)
+                return i;
+        sets.push_back(bits);
+        return (uint32_t)sets.size() - 1;
+    }
+
+    bool save(const char* path) const
+    {
+        std::ofstream file(path, std::ios::binary);
+        if (!file.is_open())
+            return false;
+        file.write("PVS1", 4);
+        writeValue(file, originX);
+        writeValue(file, originZ);
+        writeValue(file, cellSize);
+        writeValue(file, cellsX);
+        writeValue(file, cellsZ);
+        writeValue(file, meshCount);
+        writeValue(file, vertexCount);
+        writeValue(file, (uint32_t)sets.size());
+        for (const std::vector<uint8_t>& set : sets)
+        {
+            std::vector<uint8_t> packed = compress(set);
+            writeValue(file, (uint32_t)packed.size());
+            file.write((const char*)packed.data(), packed.size());
+        }
+        file.write((const char*)cellSet.data(), cellSet.size() * sizeof(uint32_t));
+        return file.good();
+    }
+
+    // expectedMeshCount / expectedVertexCount vienen del modelo cargado; si no coinciden el PVS esta desactualizado
+    bool load(const char* path, uint32_t expectedMeshCount, uint32_t expectedVertexCount)
+    {
+        *this = PVSData();
+        std::ifstream file(path, std::ios::binary);
+        if (!file.is_open())
+        {
+            std::cout << "PVS::No se encontro " << path << " (ejecutar PVSBaker)" << std::endl;
+            return false;
+        }
+
+        char magic[4];
+        file.read(magic, 4);
+        uint32_t setCount = 0;
+        if (std::memcmp(magic, "PVS1", 4) != 0 ||
+            !readValue(file, originX) || !readValue(file, originZ) || !readValue(file, cellSize) ||
+            !readValue(file, cellsX) || !readValue(file, cellsZ) || !readValue(file, meshCount) ||
+            !readValue(file, vertexCount) || !readValue(file, setCount))
+        {
+            std::cout << "PVS::Archivo invalido: " << path << std::endl;
+            *this = PVSData();
+            return false;
+        }
+        if (meshCount != expectedMeshCount || vertexCount != expectedVertexCount)
+        {
+            std::cout << "PVS::" << path << " no corresponde al modelo actual, hay que volver a generarlo" << std::endl;
+            *this = PVSData();
+            return false;
+        }
+
+        sets.resize(setCount);
+        for (uint32_t i = 0; i < setCount; i++)
+        {
+            uint32_t size = 0;
+            readValue(file, size);
+            std::vector<uint8_t> packed(size);
+            file.read((char*)packed.data(), size);
+            if (!file || !decompress(packed, bytesPerSet(), sets[i]))
+            {
+                std::cout << "PVS::Set " << i << " corrupto en " << path << std::endl;
+                *this = PVSData();
+                return false;
+            }
+        }
+
+        cellSet.resize((size_t)cellsX * cellsZ);
+        file.read((char*)cellSet.data(), cellSet.size() * sizeof(uint32_t));
+        if (!file)
+        {
+            *this = PVSData();
+            return false;
+        }
+        for (uint32_t& set : cellSet)
+            if (set != PVS_NO_SET && set >= setCount)
+                set = PVS_NO_SET;
+
+        std::cout << "PVS::" << cellsX << "x" << cellsZ << " celdas, " << setCount << " sets distintos" << std::endl;
+        return true;
+    }
+
+private:
+    template <typename T>
+    static void writeValue(std::ofstream& file, const T& value)
+    {
+        file.write((const char*)&value, sizeof(T));
+    }
+
+    template <typename T>
+    static bool readValue(std::ifstream& file, T& value)
+    {
+        file.read((char*)&value, sizeof(T));
+        return (bool)file;
+    }
+};
+
+#endif
@@ -0,0 +1,459 @@
+#ifndef RENDER_QUEUE_H
+#define RENDER_QUEUE_H
+
+#include <glad/glad.h>
+#include <GLFW/glfw3.h>
+#include <glm/glm.hpp>
+#include <glm/gtc/type_ptr.hpp>
+
+#include <learnopengl/mesh.h>
+#include <learnopengl/gpu_profiler.h>
+
+#include <vector>
+#include <map>
+#include <unordered_map>
+#include <string>
+#include <cstdint>
+#include <cstring>
+
+// Cola de render ordenada por estado.
+//
+// Durante el frame no se dibuja nada: cada mesh se envia como un comando con una clave de 64 bits
+//
+//   [63..60] pasada  [59..48] programa  [47..32] material (conjunto de texturas)  [31..0] profundidad
+//
+// Al final del frame las claves se ordenan con radix sort y los comandos se ejecutan en ese orden,
+// saltando los cambios de programa, VAO y texturas que ya estan puestos. Para comparar, tambien se
+// cuentan los cambios que habria hecho el orden de envio original.
+enum RenderPass
+{
+    RENDER_PASS_OPAQUE = 0,      // de delante hacia atras
+    RENDER_PASS_TRANSPARENT = 1  // de atras hacia delante
+};
+
+#ifndef GL_DRAW_INDIRECT_BUFFER
+#define GL_DRAW_INDIRECT_BUFFER 0x8F3F
+#endif
+
+// Mismo formato que espera glMultiDrawElementsIndirect
+struct DrawElementsIndirectCommand
+{
+    GLuint count;
+    GLuint instanceCount;
+    GLuint firstIndex;
+    GLint baseVertex;
+    GLuint baseInstance;
+};
+
+// Varios draws con el mismo estado que se envian con una sola llamada
+struct MultiDrawList
+{
+    std::vector<DrawElementsIndirectCommand> commands;
+
+    // Con GL 4.3 los comandos ya estan subidos a este buffer; si es 0 se usa el camino de GL 3.3
+    GLuint indirectBuffer = 0;
+    size_t indirectOffset = 0;
+
+    // Camino de GL 3.3 (glMultiDrawElementsBaseVertex)
+    std::vector<GLsizei> counts;
+    std::vector<const void*> offsets;
+    std::vector<GLint> baseVertices;
+};
+
+// glMultiDrawElementsIndirect (GL 4.3 / ARB_multi_draw_indirect) no esta en el glad de GL 3.3: se carga a mano.
+// Devuelve nullptr si el driver no lo soporta.
+typedef void (APIENTRYP MultiDrawElementsIndirectProc)(GLenum mode, GLenum type, const void* indirect, GLsizei drawcount, GLsizei stride);
+
+inline MultiDrawElementsIndirectProc multiDrawElementsIndirect()
+{
+    static bool loaded = false;
+    static MultiDrawElementsIndirectProc proc = nullptr;
+    if (!loaded)
+    {
+        loaded = true;
+        GLint major = 0, minor = 0;
+        glGetIntegerv(GL_MAJOR_VERSION, &major);
+        glGetIntegerv(GL_MINOR_VERSION, &minor);
+        if (major > 4 || (major == 4 && minor >= 3) || glfwExtensionSupported("GL_ARB_multi_draw_indirect"))
+            proc = (MultiDrawElementsIndirectProc)glfwGetProcAddress("glMultiDrawElementsIndirect");
+    }
+    return proc;
+}
+
+struct DrawCommand
+{
+    uint64_t key = 0;
+    GLuint program = 0;
+    GLuint vao = 0;
+    GLsizei indexCount = 0;
+    size_t indexOffset = 0;                         // en bytes dentro del EBO
+    GLenum indexType = GL_UNSIGNED_INT;             // los glTF pueden traer indices de 8 o 16 bits
+    const std::vector<Texture>* textures = nullptr; // convencion de nombres de learnopengl (texture_diffuse1, ...)
+    const MultiDrawList* multiDraw = nullptr;       // si no es nulo, se dibuja la lista en vez de indexCount/indexOffset
+    glm::mat4 model = glm::mat4(1.0f);
+    GLuint conditionalQuery = 0;                    // occlusion query para glBeginConditionalRender (0 = ninguna)
+    bool hasLightPos = false;                       // la lampara recibe la posicion de su luz
+    glm::vec3 lightPos = glm::vec3(0.0f);
+
+    DrawCommand& setLightPos(const glm::vec3& position)
+    {
+        hasLightPos = true;
+        lightPos = position;
+        return *this;
+    }
+
+    DrawCommand& setIndexType(GLenum type)
+    {
+        indexType = type;
+        return *this;
+    }
+};
+
+// Cambios de estado de un frame
+struct StateChangeStats
+{
+    unsigned int draws = 0;
+    unsigned int programChanges = 0;
+    unsigned int vaoBinds = 0;
+    unsigned int textureBinds = 0;
+
+    unsigned int total() const { return programChanges + vaoBinds + textureBinds; }
+};
+
+class RenderQueue
+{
+public:
+    StateChangeStats unsortedStats; // lo que habria costado el orden de envio
+    StateChangeStats sortedStats;   // lo que costo el orden final
+
+    // Si hay profiler, los draws de cada programa se miden como una pasada con el nombre que se le
+    // haya dado (la clave ordena por programa, asi que quedan seguidos)
+    GpuProfiler* profiler = nullptr;
+
+    void setProgramName(GLuint program, const std::string& name)
+    {
+        programNames[program] = name;
+    }
+
+    // Encola un mesh de learnopengl. depth es la distancia a la camara.
+    DrawCommand& submitMesh(RenderPass pass, GLuint program, const Mesh& mesh, const glm::mat4& model, float depth, GLuint conditionalQuery = 0)
+    {
+        return submitDraw(pass, program, mesh.VAO, (GLsizei)mesh.indices.size(), 0, mesh.textures, model, depth, conditionalQuery);
+    }
+
+    // Encola un rango de indices de cualquier VAO (indexOffset en bytes)
+    DrawCommand& submitDraw(RenderPass pass, GLuint program, GLuint vao, GLsizei indexCount, size_t indexOffset,
+                            const std::vector<Texture>& textures, const glm::mat4& model, float depth, GLuint conditionalQuery = 0)
+    {
+        DrawCommand command;
+        command.program = program;
+        command.vao = vao;
+        command.indexCount = indexCount;
+        command.indexOffset = indexOffset;
+        command.textures = &textures;
+        command.model = model;
+        command.conditionalQuery = conditionalQuery;
+        command.key = makeKey(pass, programIndex(program), materialIndex(textures), depth);
+        commands.push_back(command);
+        return commands.back();
+    }
+
+    // Encola una lista de draws que comparten VAO y texturas (geometria estatica agrupada por material)
+    DrawCommand& submitMultiDraw(RenderPass pass, GLuint program, GLuint vao, const std::vector<Texture>& textures,
+                                 const MultiDrawList& list, const glm::mat4& model, float depth)
+    {
+        DrawCommand command;
+        command.program = program;
+        command.vao = vao;
+        command.textures = &textures;
+        command.multiDraw = &list;
+        command.model = model;
+        command.key = makeKey(pass, programIndex(program), materialIndex(textures), depth);
+        commands.push_back(command);
+        return commands.back();
+    }
+
+    // Ordena y ejecuta todos los comandos del frame y vacia la cola
+    void execute()
+    {
+        unsortedStats = simulate();
+        sortKeys();
+
+        StateChangeStats stats;
+        GLuint currentProgram = 0, currentVAO = 0;
+        for (GLuint& texture : boundTextures)
+            texture = 0;
+
+        for (uint32_t index : order)
+        {
+            const DrawCommand& command = commands[index];
+            stats.draws++;
+
+            if (command.program != currentProgram)
+            {
+                if (profiler)
+                {
+                    profiler->end(profilerScope);
+                    profilerScope = profiler->begin(programName(command.program));
+                }
+                glUseProgram(command.program);
+                currentProgram = command.program;
+                stats.programChanges++;
+            }
+            ProgramState& program = programState(command.program);
+
+            if (command.textures)
+                stats.textureBinds += bindTextures(program, command.program, *command.textures);
+
+            if (command.vao != currentVAO)
+            {
+                glBindVertexArray(command.vao);
+                currentVAO = command.vao;
+                stats.vaoBinds++;
+            }
+
+            glUniformMatrix4fv(program.modelLocation, 1, GL_FALSE, glm::value_ptr(command.model));
+            if (command.hasLightPos)
+                glUniform3fv(program.lightPosLocation, 1, glm::value_ptr(command.lightPos));
+
+            if (command.multiDraw)
+            {
+                executeMultiDraw(*command.multiDraw);
+                continue;
+            }
+
+            if (command.conditionalQuery)
+                glBeginConditionalRender(command.conditionalQuery, GL_QUERY_NO_WAIT);
+            glDrawElements(GL_TRIANGLES, command.indexCount, command.indexType, (void*)command.indexOffset);
+            if (command.conditionalQuery)
+                glEndConditionalRender();
+        }
+
+        if (profiler)
+            profiler->end(profilerScope);
+        profilerScope = -1;
+        glBindVertexArray(0);
+        glActiveTexture(GL_TEXTURE0);
+        sortedStats = stats;
+        commands.clear();
+    }
+
+private:
+    static const int MAX_TEXTURE_UNITS = 16;
+
+    struct ProgramState
+    {
+        GLint modelLocation = -1;
+        GLint lightPosLocation = -1;
+        std::map<std::string, GLint> samplerLocations;
+        std::map<GLint, GLint> samplerUnits;  // valor actual de cada sampler (es estado del programa)
+    };
+
+    std::vector<DrawCommand> commands;
+    std::vector<uint64_t> keys, keysTemp;
+    std::vector<uint32_t> order, orderTemp;
+    std::map<GLuint, uint32_t> programIds;
+    std::unordered_map<uint64_t, uint32_t> materialIds;   // hash de los ids de las texturas -> indice
+    std::map<GLuint, ProgramState> programs;
+    GLuint boundTextures[MAX_TEXTURE_UNITS] = {};
+    std::map<GLuint, std::string> programNames;
+    int profilerScope = -1;
+
+    const char* programName(GLuint program)
+    {
+        std::string& name = programNames[program];
+        if (name.empty())
+            name = "programa " + std::to_string(program);
+        return name.c_str();
+    }
+
+    static uint64_t makeKey(RenderPass pass, uint32_t program, uint32_t material, float depth)
+    {
+        if (depth < 0.0f)
+            depth = 0.0f;
+        uint32_t depthBits;
+        std::memcpy(&depthBits, &depth, sizeof(depthBits)); // un float positivo se ordena igual que sus bits
+        if (pass == RENDER_PASS_TRANSPARENT)
+            depthBits = ~depthBits;
+        return ((uint64_t)(pass & 0xF) << 60) | ((uint64_t)(program & 0xFFF) << 48) |
+               ((uint64_t)(material & 0xFFFF) << 32) | depthBits;
+    }
+
+    uint32_t programIndex(GLuint program)
+    {
+        auto it = programIds.find(program);
+        if (it != programIds.end())
+            return it->second;
+        uint32_t id = (uint32_t)programIds.size();
+        programIds[program] = id;
+        return id;
+    }
+
+    // Indice del conjunto de texturas, por un hash FNV-1a de sus ids para no reservar memoria en
+    // cada envio. Una colision solo junta dos materiales en el orden, no cambia lo que se dibuja.
+    uint32_t materialIndex(const std::vector<Texture>& textures)
+    {
+        uint64_t hash = 14695981039346656037ull;
+        for (const Texture& texture : textures)
+        {
+            hash ^= texture.id;
+            hash *= 1099511628211ull;
+        }
+        auto it = materialIds.find(hash);
+        if (it != materialIds.end())
+            return it->second;
+        uint32_t id = (uint32_t)materialIds.size();
+        materialIds.emplace(hash, id);
+        return id;
+    }
+
+    ProgramState& programState(GLuint program)
+    {
+        auto it = programs.find(program);
+        if (it != programs.end())
+            return it->second;
+        ProgramState& state = programs[program];
+        state.modelLocation = glGetUniformLocation(program, "model");
+        state.lightPosLocation = glGetUniformLocation(program, "lightPos");
+        return state;
+    }
+
+    GLint samplerLocation(ProgramState& program, GLuint programId, const std::string& name)
+    {
+        auto it = program.samplerLocations.find(name);
+        if (it != program.samplerLocations.end())
+            return it->second;
+        GLint location = glGetUniformLocation(programId, name.c_str());
+        program.samplerLocations[name] = location;
+        return location;
+    }
+
+    // Nombre del sampler igual que Mesh::Draw: texture_diffuse1, texture_specular1, texture_normal1, texture_height1.
+    // Los tipos que empiezan por "array_" (array_diffuse1, ...) son GL_TEXTURE_2D_ARRAY.
+    static std::string samplerName(const std::vector<Texture>& textures, size_t i)
+    {
+        unsigned int number = 1;
+        for (size_t j = 0; j < i; j++)
+            if (textures[j].type == textures[i].type)
+                number++;
+        return textures[i].type + std::to_string(number);
+    }
+
+    unsigned int bindTextures(ProgramState& program, GLuint programId, const std::vector<Texture>& textures)
+    {
+        unsigned int binds = 0;
+        for (size_t i = 0; i < textures.size() && i < MAX_TEXTURE_UNITS; i++)
+        {
+            GLint location = samplerLocation(program, programId, samplerName(textures, i));
+            auto unit = program.samplerUnits.find(location);
+            if (location >= 0 && (unit == program.samplerUnits.end() || unit->second != (GLint)i))
+            {
+                glUniform1i(location, (GLint)i);
+                program.samplerUnits[location] = (GLint)i;
+            }
+            if (boundTextures[i] != textures[i].id)
+            {
+                glActiveTexture(GL_TEXTURE0 + (GLenum)i);
+                glBindTexture(textures[i].type.compare(0, 6, "array_") == 0 ? GL_TEXTURE_2D_ARRAY : GL_TEXTURE_2D, textures[i].id);
+                boundTextures[i] = textures[i].id;
+                binds++;
+            }
+        }
+        return binds;
+    }
+
+    static void executeMultiDraw(const MultiDrawList& list)
+    {
+        GLsizei drawCount = (GLsizei)list.commands.size();
+        if (drawCount == 0)
+            return;
+        MultiDrawElementsIndirectProc indirect = multiDrawElementsIndirect();
+        if (indirect && list.indirectBuffer)
+        {
+            glBindBuffer(GL_DRAW_INDIRECT_BUFFER, list.indirectBuffer);
+            indirect(GL_TRIANGLES, GL_UNSIGNED_INT, (const void*)list.indirectOffset, drawCount, 0);
+            glBindBuffer(GL_DRAW_INDIRECT_BUFFER, 0);
+        }
+        else
+        {
+            glMultiDrawElementsBaseVertex(GL_TRIANGLES, list.counts.data(), GL_UNSIGNED_INT,
+                                          (const void* const*)list.offsets.data(), drawCount, list.baseVertices.data());
+        }
+    }
+
+    // Cuenta los cambios de estado del orden de envio sin tocar OpenGL
+    StateChangeStats simulate() const
+    {
+        StateChangeStats stats;
+        GLuint currentProgram = 0, currentVAO = 0;
+        GLuint textures[MAX_TEXTURE_UNITS] = {};
+        for (const DrawCommand& command : commands)
+        {
+            stats.draws++;
+            if (command.program != currentProgram)
+            {
+                currentProgram = command.program;
+                stats.programChanges++;
+            }
+            if (command.textures)
+            {
+                for (size_t i = 0; i < command.textures->size() && i < MAX_TEXTURE_UNITS; i++)
+                {
+                    if (textures[i] != (*command.textures)[i].id)
+                    {
+                        textures[i] = (*command.textures)[i].id;
+                        stats.textureBinds++;
+                    }
+                }
+            }
+            if (command.vao != currentVAO)
+            {
+                currentVAO = command.vao;
+                stats.vaoBinds++;
+            }
+        }
+        return stats;
+    }
+
+    // Radix sort LSD de 8 bits sobre las claves; se saltan los bytes que son iguales en todas
+    void sortKeys()
+    {
+        size_t count = commands.size();
+        keys.resize(count);
+        keysTemp.resize(count);
+        order.resize(count);
+        orderTemp.resize(count);
+        for (size_t i = 0; i < count; i++)
+        {
+            keys[i] = commands[i].key;
+            order[i] = (uint32_t)i;
+        }
+
+        for (int shift = 0; shift < 64; shift += 8)
+        {
+            size_t histogram[256] = {};
+            for (size_t i = 0; i < count; i++)
+                histogram[(keys[i] >> shift) & 0xFF]++;
+            if (count == 0 || histogram[(keys[0] >> shift) & 0xFF] == count)
+                continue;
+
+            size_t offset = 0;
+            for (size_t& bucket : histogram)
+            {
+                size_t size = bucket;
+                bucket = offset;
+                offset += size;
+            }
+            for (size_t i = 0; i < count; i++)
+            {
+                size_t destination = histogram[(keys[i] >> shift) & 0xFF]++;
+                keysTemp[destination] = keys[i];
+                orderTemp[destination] = order[i];
+            }
+            keys.swap(keysTemp);
+            order.swap(orderTemp);
+        }
+    }
+};
+
+#endif
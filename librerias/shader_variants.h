@@ -0,0 +1,168 @@
+#ifndef SHADER_VARIANTS_H
+#define SHADER_VARIANTS_H
+
+#include <glad/glad.h>
+
+#include <learnopengl/mesh.h>
+#include <learnopengl/program_cache.h>
+
+#include <vector>
+#include <map>
+#include <memory>
+#include <string>
+#include <iostream>
+
+// Variantes de un shader segun las caracteristicas del material.
+//
+// Un mismo par vertex/fragment se especializa con #defines insertados despues de #version, uno
+// por bit de la mascara de caracteristicas, y cada combinacion se compila la primera vez que se
+// pide y se guarda por su mascara. Asi un material sin mapa de normales no paga su lectura ni su
+// TBN, y uno opaco no paga el discard del alpha test. La mascara sale de las texturas del material
+// (materialFeatures); el alpha test se activa si la textura difusa tiene canal alfa.
+enum MaterialFeature
+{
+    MATERIAL_TEXTURE_ARRAY = 1 << 0,   // difusa en un sampler2DArray con la capa en el vertice
+    MATERIAL_NORMAL_MAP = 1 << 1,
+    MATERIAL_SPECULAR_MAP = 1 << 2,
+    MATERIAL_EMISSIVE_MAP = 1 << 3,
+    MATERIAL_ALPHA_TEST = 1 << 4,
+    MATERIAL_METALLIC_ROUGHNESS = 1 << 5,   // glTF: rugosidad en G, metalico en B
+    MATERIAL_FEATURE_COUNT = 6
+};
+
+inline const char* materialFeatureDefine(int bit)
+{
+    static const char* defines[MATERIAL_FEATURE_COUNT] = { "TEXTURE_ARRAY", "NORMAL_MAP", "SPECULAR_MAP", "EMISSIVE_MAP", "ALPHA_TEST",
+                                                           "METALLIC_ROUGHNESS" };
+    return defines[bit];
+}
+
+// Caracteristicas de un material a partir de sus texturas (tipos de learnopengl, "array_diffuse" y
+// "texture_metallicRoughness" de los glTF)
+inline unsigned int materialFeatures(const std::vector<Texture>& textures)
+{
+    unsigned int features = 0;
+    for (const Texture& texture : textures)
+    {
+        GLenum target = GL_TEXTURE_2D;
+        if (texture.type == "array_diffuse")
+        {
+            features |= MATERIAL_TEXTURE_ARRAY;
+            target = GL_TEXTURE_2D_ARRAY;
+        }
+        else if (texture.type == "texture_normal")
+            features |= MATERIAL_NORMAL_MAP;
+        else if (texture.type == "texture_specular")
+            features |= MATERIAL_SPECULAR_MAP;
+        else if (texture.type == "texture_emissive")
+            features |= MATERIAL_EMISSIVE_MAP;
+        else if (texture.type == "texture_metallicRoughness")
+            features |= MATERIAL_METALLIC_ROUGHNESS;
+
+        if (texture.type == "array_diffuse" || texture.type == "texture_diffuse")
+        {
+            GLint alphaBits = 0;
+            glBindTexture(target, texture.id);
+            glGetTexLevelParameteriv(target, 0, GL_TEXTURE_ALPHA_SIZE, &alphaBits);
+            glBindTexture(target, 0);
+            if (alphaBits > 0)
+                features |= MATERIAL_ALPHA_TEST;
+        }
+    }
+    return features;
+}
+
+// Programa de una variante. Tiene los mismos setters que Shader de learnopengl (ver CachedShader)
+// para que el codigo que pone uniforms sirva para los dos.
+class ShaderVariant : public CachedShader
+{
+public:
+    unsigned int features = 0;
+};
+
+class ShaderVariants
+{
+public:
+    ShaderVariants(const char* vertexPath, const char* fragmentPath)
+        : vertexPath(vertexPath), fragmentPath(fragmentPath)
+    {
+        vertexSource = ProgramCache::readFile(vertexPath);
+        fragmentSource = ProgramCache::readFile(fragmentPath);
+    }
+
+    ~ShaderVariants()
+    {
+        for (auto& variant : variants)
+            glDeleteProgram(variant.second->ID);
+    }
+
+    ShaderVariants(const ShaderVariants&) = delete;
+    ShaderVariants& operator=(const ShaderVariants&) = delete;
+
+    // Variante para una mascara de MaterialFeature; se pide a la ProgramCache la primera vez (el
+    // enlazado puede seguir en marcha al volver, ver ProgramCache::finishAll)
+    ShaderVariant& get(unsigned int features)
+    {
+        auto it = variants.find(features);
+        if (it != variants.end())
+            return *it->second;
+
+        std::unique_ptr<ShaderVariant> variant(new ShaderVariant());
+        variant->features = features;
+        std::string block = defines(features);
+        variant->ID = ProgramCache::instance().request(vertexPath + "|" + fragmentPath + "|" + describe(features),
+                                                       specialize(vertexSource, block), specialize(fragmentSource, block));
+        std::cout << "SHADER_VARIANTS::" << fragmentPath << " variante " << describe(features) << std::endl;
+        ShaderVariant& result = *variant;
+        variants[features] = std::move(variant);
+        return result;
+    }
+
+    // Aplica f a todas las variantes ya compiladas (uniforms comunes del frame)
+    template <typename F>
+    void forEach(F f)
+    {
+        for (auto& variant : variants)
+            f(*variant.second);
+    }
+
+    size_t variantCount() const { return variants.size(); }
+
+    // Bloque de #defines de una mascara
+    static std::string defines(unsigned int features)
+    {
+        std::string block;
+        for (int bit = 0; bit < MATERIAL_FEATURE_COUNT; bit++)
+            if (features & (1u << bit))
+                block += std::string("#define ") + materialFeatureDefine(bit) + "\n";
+        return block;
+    }
+
+    static std::string describe(unsigned int features)
+    {
+        std::string text;
+        for (int bit = 0; bit < MATERIAL_FEATURE_COUNT; bit++)
+            if (features & (1u << bit))
+                text += (text.empty() ? "" : "|") + std::string(materialFeatureDefine(bit));
+        return text.empty() ? "BASE" : text;
+    }
+
+    // Inserta el bloque despues de la linea #version (que tiene que ser la primera directiva)
+    static std::string specialize(const std::string& source, const std::string& block)
+    {
+        size_t version = source.find("#version");
+        if (version == std::string::npos)
+            return block + source;
+        size_t lineEnd = source.find('\n', version);
+        if (lineEnd == std::string::npos)
+            return source + "\n" + block;
+        return source.substr(0, lineEnd + 1) + block + source.substr(lineEnd + 1);
+    }
+
+private:
+    std::string vertexPath, fragmentPath;
+    std::string vertexSource, fragmentSource;
+    std::map<unsigned int, std::unique_ptr<ShaderVariant>> variants;
+};
+
+#endif
@@ -0,0 +1,305 @@
+#ifndef SHADOW_ATLAS_H
+#define SHADOW_ATLAS_H
+
+#include <glad/glad.h>
+#include <glm/glm.hpp>
+#include <glm/gtc/matrix_transform.hpp>
+
+#include <learnopengl/program_cache.h>
+#include <learnopengl/frustum_culling.h>
+#include <learnopengl/static_geometry.h>
+#include <learnopengl/lod.h>
+#include <learnopengl/gltf_model.h>
+
+#include <vector>
+#include <string>
+#include <algorithm>
+#include <iostream>
+
+// Objeto que se mueve y proyecta sombra (lamparas que se balancean, fantasma)
+struct ShadowCaster
+{
+    AABB bounds;               // en mundo
+    glm::mat4 model;
+    LodModel* lod;             // se dibuja con su nivel mas bajo
+    int excludedLight;         // luz que no debe sombrear (la lampara que la contiene), -1 ninguna
+};
+
+// Atlas de sombras de luces puntuales con cache de lo estatico.
+//
+// Cada luz tiene 6 tiles (caras de cubo) en una textura de profundidad. Se guarda la distancia a la
+// luz dividida por el alcance. Hay dos atlas:
+//   - estatico: la casa y los props que no se mueven (addStaticProp), se dibuja una sola vez al cargar
+//   - final: el que se muestrea; cada cara es una copia del estatico mas los objetos que se mueven
+// Cada frame solo se vuelven a dibujar las caras cuyo frustum contiene algun objeto en movimiento
+// (o que lo contenian y hay que limpiar), como mucho faceBudget caras, en orden de prioridad:
+// luces cercanas a la camara y caras que llevan mas frames sin actualizarse primero.
+class ShadowAtlas
+{
+public:
+    unsigned int faceBudget = 6;
+    float bias = 0.02f;   // metros; el shader le suma el tamano de un texel a la distancia del fragmento
+
+    // Estadisticas del ultimo frame
+    unsigned int facesUpdated = 0;
+    unsigned int facesPending = 0;
+
+    ShadowAtlas(const char* vertexPath, const char* fragmentPath, unsigned int lightCount, float range, int tileSize = 256)
+        : depthShader(vertexPath, fragmentPath), lightCount(lightCount), range(range), tileSize(tileSize)
+    {
+        unsigned int tiles = lightCount * 6;
+        tilesPerRow = 1;
+        while (tilesPerRow * tilesPerRow < tiles)
+            tilesPerRow++;
+        atlasSize = tilesPerRow * tileSize;
+
+        createTarget(staticTexture, staticFBO);
+        createTarget(finalTexture, finalFBO);
+        faces.resize(tiles);
+
+        // Caras del cubo en el mismo orden que las elige el shader (+X, -X, +Y, -Y, +Z, -Z)
+        glm::vec3 directions[6] = { { 1, 0, 0 }, { -1, 0, 0 }, { 0, 1, 0 }, { 0, -1, 0 }, { 0, 0, 1 }, { 0, 0, -1 } };
+        glm::vec3 ups[6] = { { 0, -1, 0 }, { 0, -1, 0 }, { 0, 0, 1 }, { 0, 0, -1 }, { 0, -1, 0 }, { 0, -1, 0 } };
+        glm::mat4 projection = glm::perspective(glm::radians(90.0f), 1.0f, 0.02f, range);
+        for (int f = 0; f < 6; f++)
+            faceMatrices[f] = projection * glm::lookAt(glm::vec3(0.0f), directions[f], ups[f]);
+
+        std::cout << "SHADOWS::Atlas de " << atlasSize << "x" << atlasSize << " (" << tiles << " caras de " << tileSize << ")" << std::endl;
+    }
+
+    ~ShadowAtlas()
+    {
+        glDeleteFramebuffers(1, &staticFBO);
+        glDeleteFramebuffers(1, &finalFBO);
+        glDeleteTextures(1, &staticTexture);
+        glDeleteTextures(1, &finalTexture);
+    }
+
+    ShadowAtlas(const ShadowAtlas&) = delete;
+    ShadowAtlas& operator=(const ShadowAtlas&) = delete;
+
+    // Prop glTF que no se mueve: se dibuja en el atlas estatico con la casa (llamar antes de renderStatic)
+    void addStaticProp(const GltfModel& prop, const glm::mat4& model)
+    {
+        staticProps.push_back({ &prop, model });
+    }
+
+    // Dibuja la geometria estatica en todas las caras y la copia al atlas final. Se llama una vez.
+    void renderStatic(const std::vector<glm::vec3>& lights, StaticGeometry& geometry, const glm::mat4& model)
+    {
+        lightPositions = lights;
+        beginPass(staticFBO);
+        for (unsigned int light = 0; light < lightCount && light < lights.size(); light++)
+        {
+            for (int f = 0; f < 6; f++)
+            {
+                setFace(light, f, true);
+                depthShader.setMat4("model", model);
+                geometry.drawAll();
+                for (const StaticProp& prop : staticProps)
+                    prop.model->drawAll(depthShader, prop.transform);
+            }
+        }
+        endPass();
+
+        glBindFramebuffer(GL_READ_FRAMEBUFFER, staticFBO);
+        glBindFramebuffer(GL_DRAW_FRAMEBUFFER, finalFBO);
+        glBlitFramebuffer(0, 0, atlasSize, atlasSize, 0, 0, atlasSize, atlasSize, GL_DEPTH_BUFFER_BIT, GL_NEAREST);
+        glBindFramebuffer(GL_FRAMEBUFFER, 0);
+    }
+
+    // Vuelve a dibujar las caras afectadas por objetos en movimiento, dentro del presupuesto del frame.
+    // Deja activo el framebuffer target con el viewport width x height.
+    void update(const std::vector<ShadowCaster>& casters, const glm::vec3& cameraPos, int width, int height, GLuint target = 0)
+    {
+        frame++;
+        candidates.clear();
+        for (unsigned int light = 0; light < lightCount && light < lightPositions.size(); light++)
+        {
+            const glm::vec3& position = lightPositions[light];
+            AABB volume = { position - glm::vec3(range), position + glm::vec3(range) };
+            for (int f = 0; f < 6; f++)
+            {
+                FaceState& face = faces[light * 6 + f];
+                face.casters.clear();
+                Frustum faceFrustum;
+                bool frustumReady = false;
+                for (unsigned int c = 0; c < casters.size(); c++)
+                {
+                    if (casters[c].excludedLight == (int)light || !overlaps(casters[c].bounds, volume))
+                        continue;
+                    if (!frustumReady)
+                    {
+                        faceFrustum.update(faceMatrices[f] * glm::translate(glm::mat4(1.0f), -position));
+                        frustumReady = true;
+                    }
+                    if (faceFrustum.intersects(casters[c].bounds))
+                        face.casters.push_back(c);
+                }
+                // Hay que redibujar si tiene objetos o si los tenia (para borrarlos)
+                if (!face.casters.empty() || face.hasDynamic)
+                {
+                    float staleness = (float)(frame - face.lastUpdate);
+                    float priority = staleness / (1.0f + glm::length(position - cameraPos));
+                    candidates.push_back({ priority, light * 6 + f });
+                }
+            }
+        }
+
+        std::sort(candidates.begin(), candidates.end(),
+                  [](const Candidate& a, const Candidate& b) { return a.priority > b.priority; });
+        facesUpdated = (unsigned int)std::min<size_t>(candidates.size(), faceBudget);
+        facesPending = (unsigned int)candidates.size() - facesUpdated;
+        if (facesUpdated == 0)
+            return;
+
+        // Restaurar la parte estatica de las caras elegidas
+        glBindFramebuffer(GL_READ_FRAMEBUFFER, staticFBO);
+        glBindFramebuffer(GL_DRAW_FRAMEBUFFER, finalFBO);
+        for (unsigned int i = 0; i < facesUpdated; i++)
+        {
+            int x, y;
+            tileOrigin(candidates[i].face, x, y);
+            glBlitFramebuffer(x, y, x + tileSize, y + tileSize, x, y, x + tileSize, y + tileSize, GL_DEPTH_BUFFER_BIT, GL_NEAREST);
+        }
+
+        // Y dibujar encima los objetos que se mueven
+        beginPass(finalFBO);
+        for (unsigned int i = 0; i < facesUpdated; i++)
+        {
+            FaceState& face = faces[candidates[i].face];
+            setFace(candidates[i].face / 6, candidates[i].face % 6, false);
+            for (unsigned int c : face.casters)
+            {
+                const ShadowCaster& caster = casters[c];
+                depthShader.setMat4("model", caster.model);
+                unsigned int level = caster.lod->levelCount() - 1;
+                for (unsigned int m = 0; m < caster.lod->meshCount(); m++)
+                    caster.lod->draw(m, level);
+            }
+            face.hasDynamic = !face.casters.empty();
+            face.lastUpdate = frame;
+        }
+        endPass();
+        glBindFramebuffer(GL_FRAMEBUFFER, target);
+        glViewport(0, 0, width, height);
+    }
+
+    // Atlas y parametros de muestreo para el shader de la casa
+    template <typename ShaderType>
+    void bind(ShaderType& shader, int unit)
+    {
+        shader.use();
+        shader.setInt("shadowAtlas", unit);
+        for (int f = 0; f < 6; f++)
+            shader.setMat4("shadowFaces[" + std::to_string(f) + "]", faceMatrices[f]);
+        shader.setFloat("shadowTilesPerRow", (float)tilesPerRow);
+        shader.setFloat("shadowTileScale", 1.0f / tilesPerRow);
+        shader.setFloat("shadowTexel", 1.0f / tileSize);
+        shader.setFloat("shadowBias", bias);
+        glActiveTexture(GL_TEXTURE0 + unit);
+        glBindTexture(GL_TEXTURE_2D, finalTexture);
+        glActiveTexture(GL_TEXTURE0);
+    }
+
+private:
+    struct FaceState
+    {
+        std::vector<unsigned int> casters;  // objetos en movimiento dentro de la cara este frame
+        bool hasDynamic = false;            // el atlas final tiene objetos dibujados en esta cara
+        unsigned int lastUpdate = 0;
+    };
+
+    struct Candidate
+    {
+        float priority;
+        unsigned int face;
+    };
+
+    struct StaticProp
+    {
+        const GltfModel* model;
+        glm::mat4 transform;
+    };
+
+    CachedShader depthShader;
+    unsigned int lightCount;
+    float range;
+    int tileSize;
+    int tilesPerRow = 1;
+    int atlasSize = 0;
+    GLuint staticTexture = 0, finalTexture = 0;
+    GLuint staticFBO = 0, finalFBO = 0;
+    glm::mat4 faceMatrices[6];
+    std::vector<glm::vec3> lightPositions;
+    std::vector<StaticProp> staticProps;
+    std::vector<FaceState> faces;
+    std::vector<Candidate> candidates;
+    unsigned int frame = 0;
+
+    void createTarget(GLuint& texture, GLuint& fbo)
+    {
+        glGenTextures(1, &texture);
+        glBindTexture(GL_TEXTURE_2D, texture);
+        glTexImage2D(GL_TEXTURE_2D, 0, GL_DEPTH_COMPONENT24, atlasSize, atlasSize, 0, GL_DEPTH_COMPONENT, GL_FLOAT, nullptr);
+        glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_MIN_FILTER, GL_NEAREST);
+        glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_MAG_FILTER, GL_NEAREST);
+        glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_WRAP_S, GL_CLAMP_TO_EDGE);
+        glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_WRAP_T, GL_CLAMP_TO_EDGE);
+        glBindTexture(GL_TEXTURE_2D, 0);
+
+        glGenFramebuffers(1, &fbo);
+        glBindFramebuffer(GL_FRAMEBUFFER, fbo);
+        glFramebufferTexture2D(GL_FRAMEBUFFER, GL_DEPTH_ATTACHMENT, GL_TEXTURE_2D, texture, 0);
+        glDrawBuffer(GL_NONE);
+        glReadBuffer(GL_NONE);
+        if (glCheckFramebufferStatus(GL_FRAMEBUFFER) != GL_FRAMEBUFFER_COMPLETE)
+            std::cout << "SHADOWS::El framebuffer del atlas no esta completo" << std::endl;
+        glBindFramebuffer(GL_FRAMEBUFFER, 0);
+    }
+
+    void tileOrigin(unsigned int face, int& x, int& y) const
+    {
+        x = (int)(face % tilesPerRow) * tileSize;
+        y = (int)(face / tilesPerRow) * tileSize;
+    }
+
+    void beginPass(GLuint fbo)
+    {
+        glBindFramebuffer(GL_FRAMEBUFFER, fbo);
+        glEnable(GL_SCISSOR_TEST);
+        glEnable(GL_DEPTH_TEST);
+        glDepthFunc(GL_LESS);
+        depthShader.use();
+        depthShader.setFloat("range", range);
+    }
+
+    void endPass()
+    {
+        glDisable(GL_SCISSOR_TEST);
+        glBindVertexArray(0);
+        glBindFramebuffer(GL_FRAMEBUFFER, 0);
+    }
+
+    void setFace(unsigned int light, int f, bool clear)
+    {
+        int x, y;
+        tileOrigin(light * 6 + f, x, y);
+        glViewport(x, y, tileSize, tileSize);
+        glScissor(x, y, tileSize, tileSize);
+        if (clear)
+            glClear(GL_DEPTH_BUFFER_BIT);
+        const glm::vec3& position = lightPositions[light];
+        depthShader.setMat4("lightSpace", faceMatrices[f] * glm::translate(glm::mat4(1.0f), -position));
+        depthShader.setVec3("lightPos", position);
+    }
+
+    static bool overlaps(const AABB& a, const AABB& b)
+    {
+        return a.min.x <= b.max.x && a.max.x >= b.min.x &&
+               a.min.y <= b.max.y && a.max.y >= b.min.y &&
+               a.min.z <= b.max.z && a.max.z >= b.min.z;
+    }
+};
+
+#endif
@@ -0,0 +1,397 @@
+#ifndef STATIC_GEOMETRY_H
+#define STATIC_GEOMETRY_H
+
+#include <glad/glad.h>
+#include <glm/glm.hpp>
+
+#include <learnopengl/model.h>
+#include <learnopengl/render_queue.h>
+#include <learnopengl/occlusion_culling.h>
+#include <learnopengl/texture_array.h>
+#include <learnopengl/shader_variants.h>
+#include <learnopengl/texture_cache.h>
+
+#include <vector>
+#include <algorithm>
+#include <iostream>
+#include <cfloat>
+#include <cstddef>
+
+// Geometria estatica de un modelo empaquetada en un unico VBO/EBO.
+//
+// Los meshes se agrupan por material (misma lista de texturas en el mismo orden) y se copian al
+// buffer compartido en ese orden, asi que todos los meshes de un material quedan contiguos. Cada
+// frame los meshes visibles de un material se envian con una sola llamada:
+//   - glMultiDrawElementsIndirect si hay GL 4.3 / ARB_multi_draw_indirect (comandos en un buffer)
+//   - glMultiDrawElementsBaseVertex en GL 3.3
+// El VAO usa las mismas locations que Mesh de learnopengl (0 posicion, 1 normal, 2 uv, 3 tangente,
+// 4 bitangente), asi que sirven los mismos shaders. Los huesos no se copian: la casa no tiene.
+//
+// Con un TextureArrays la textura difusa de cada mesh pasa a ser una capa de un GL_TEXTURE_2D_ARRAY
+// (sampler array_diffuse1) y la capa va en cada vertice (location 5). Los meshes cuyas difusas
+// caen en el mismo array y tienen los mismos mapas de normales/especular/emision (que siguen siendo
+// texturas 2D) comparten material aunque antes tuvieran texturas distintas. Las difusas 2D del
+// modelo que ya no usa ningun material quedan en arrayedTextures() para que se puedan soltar.
+// Si ademas se pasa un TextureStreamer los arrays se crean al momento y sus capas se cargan en
+// segundo plano (ver TextureArrays::build).
+//
+// Cada material guarda su mascara de MaterialFeature; con submit(queue, ShaderVariants&, ...) cada
+// multi-draw usa la variante del shader que solo lee las texturas que tiene ese material.
+//
+// Dentro de un multi-draw no se puede usar render condicional por mesh, asi que los meshes cuya
+// occlusion query aun no ha vuelto se dibujan (como si fueran visibles) en vez de esperar.
+class StaticGeometry
+{
+public:
+    StaticGeometry(const Model& model, TextureArrays* arrays = nullptr, TextureStreamer* streamer = nullptr)
+    {
+        // Capa de la textura difusa de cada mesh
+        std::vector<float> meshLayer(model.meshes.size(), 0.0f);
+        std::vector<std::vector<Texture>> meshTextures(model.meshes.size());
+        if (arrays)
+        {
+            std::vector<unsigned int> meshSlot(model.meshes.size());
+            for (unsigned int i = 0; i < model.meshes.size(); i++)
+            {
+                std::string path;
+                GLuint source = 0;
+                for (const Texture& texture : model.meshes[i].textures)
+                {
+                    if (texture.type == "texture_diffuse")
+                    {
+                        path = model.directory + '/' + texture.path;
+                        source = texture.id;   // sin .ktx la capa se copia de aqui, sin decodificar otra vez
+                        break;
+                    }
+                }
+                meshSlot[i] = arrays->add(path, source);
+            }
+            arrays->build(streamer);   // con streamer las capas llegan en segundo plano
+            for (unsigned int i = 0; i < model.meshes.size(); i++)
+            {
+                const TextureArrays::Slot& slot = arrays->slot(meshSlot[i]);
+                if (slot.array < 0)
+                {
+                    meshTextures[i] = model.meshes[i].textures;   // no se pudo cargar: se queda en 2D
+                    continue;
+                }
+                meshTextures[i].push_back({ arrays->arrayId(slot.array), "array_diffuse", "" });
+                meshLayer[i] = (float)slot.layer;
+                for (const Texture& texture : model.meshes[i].textures)
+                {
+                    if (texture.type != "texture_diffuse")
+                        meshTextures[i].push_back(texture);
+                    else if (std::find(arrayed.begin(), arrayed.end(), texture.id) == arrayed.end())
+                        arrayed.push_back(texture.id);
+                }
+            }
+        }
+        else
+        {
+            for (unsigned int i = 0; i < model.meshes.size(); i++)
+                meshTextures[i] = model.meshes[i].textures;
+        }
+
+        // Agrupar meshes por material
+        std::vector<std::vector<unsigned int>> batchMeshes;
+        meshBatch.resize(model.meshes.size());
+        for (unsigned int i = 0; i < model.meshes.size(); i++)
+        {
+            const std::vector<Texture>& textures = meshTextures[i];
+            unsigned int b = 0;
+            while (b < batches.size() && !sameTextures(batches[b].textures, textures))
+                b++;
+            if (b == batches.size())
+            {
+                batches.push_back(Batch());
+                batches.back().textures = textures;
+                batches.back().features = materialFeatures(textures);
+                batchMeshes.push_back(std::vector<unsigned int>());
+            }
+            batchMeshes[b].push_back(i);
+            meshBatch[i] = b;
+        }
+
+        // Solo las difusas que no se siguen usando como 2D en otro material (o en otro hueco)
+        for (const Batch& batch : batches)
+            for (const Texture& texture : batch.textures)
+                arrayed.erase(std::remove(arrayed.begin(), arrayed.end(), texture.id), arrayed.end());
+
+        // Copiar vertices e indices en orden de material
+        std::vector<StaticVertex> vertices;
+        std::vector<unsigned int> indices;
+        ranges.resize(model.meshes.size());
+        for (const std::vector<unsigned int>& meshes : batchMeshes)
+        {
+            for (unsigned int i : meshes)
+            {
+                const Mesh& mesh = model.meshes[i];
+                MeshRange& range = ranges[i];
+                range.firstIndex = (GLuint)indices.size();
+                range.count = (GLuint)mesh.indices.size();
+                range.baseVertex = (GLint)vertices.size();
+                for (const Vertex& v : mesh.vertices)
+                    vertices.push_back({ v.Position, v.Normal, v.TexCoords, v.Tangent, v.Bitangent, meshLayer[i] });
+                indices.insert(indices.end(), mesh.indices.begin(), mesh.indices.end());
+            }
+        }
+
+        glGenVertexArrays(1, &VAO);
+        glGenBuffers(1, &VBO);
+        glGenBuffers(1, &EBO);
+        glBindVertexArray(VAO);
+        glBindBuffer(GL_ARRAY_BUFFER, VBO);
+        glBufferData(GL_ARRAY_BUFFER, vertices.size() * sizeof(StaticVertex), vertices.data(), GL_STATIC_DRAW);
+        glBindBuffer(GL_ELEMENT_ARRAY_BUFFER, EBO);
+        glBufferData(GL_ELEMENT_ARRAY_BUFFER, indices.size() * sizeof(unsigned int), indices.data(), GL_STATIC_DRAW);
+
+        glEnableVertexAttribArray(0);
+        glVertexAttribPointer(0, 3, GL_FLOAT, GL_FALSE, sizeof(StaticVertex), (void*)offsetof(StaticVertex, Position));
+        glEnableVertexAttribArray(1);
+        glVertexAttribPointer(1, 3, GL_FLOAT, GL_FALSE, sizeof(StaticVertex), (void*)offsetof(StaticVertex, Normal));
+        glEnableVertexAttribArray(2);
+        glVertexAttribPointer(2, 2, GL_FLOAT, GL_FALSE, sizeof(StaticVertex), (void*)offsetof(StaticVertex, TexCoords));
+        glEnableVertexAttribArray(3);
+        glVertexAttribPointer(3, 3, GL_FLOAT, GL_FALSE, sizeof(StaticVertex), (void*)offsetof(StaticVertex, Tangent));
+        glEnableVertexAttribArray(4);
+        glVertexAttribPointer(4, 3, GL_FLOAT, GL_FALSE, sizeof(StaticVertex), (void*)offsetof(StaticVertex, Bitangent));
+        glEnableVertexAttribArray(5);
+        glVertexAttribPointer(5, 1, GL_FLOAT, GL_FALSE, sizeof(StaticVertex), (void*)offsetof(StaticVertex, Layer));
+        glBindVertexArray(0);
+
+        if (multiDrawElementsIndirect())
+            glGenBuffers(1, &indirectBuffer);
+
+        std::cout << "STATIC_GEOMETRY::" << model.meshes.size() << " meshes en " << batches.size() << " materiales, "
+                  << vertices.size() << " vertices, "
+                  << (indirectBuffer ? "glMultiDrawElementsIndirect" : "glMultiDrawElementsBaseVertex") << std::endl;
+    }
+
+    ~StaticGeometry()
+    {
+        if (indirectBuffer)
+            glDeleteBuffers(1, &indirectBuffer);
+        glDeleteBuffers(1, &EBO);
+        glDeleteBuffers(1, &VBO);
+        glDeleteVertexArrays(1, &VAO);
+    }
+
+    StaticGeometry(const StaticGeometry&) = delete;
+    StaticGeometry& operator=(const StaticGeometry&) = delete;
+
+    size_t batchCount() const { return batches.size(); }
+
+    // Texturas 2D del modelo que se cambiaron por capas de los arrays y ya no dibuja ningun material
+    const std::vector<GLuint>& arrayedTextures() const { return arrayed; }
+
+    // Texturas con las que se dibuja un mesh (las de su material)
+    const std::vector<Texture>& meshTextures(unsigned int mesh) const { return batches[meshBatch[mesh]].textures; }
+
+    // Mascaras de caracteristicas distintas entre todos los materiales
+    std::vector<unsigned int> featureMasks() const
+    {
+        std::vector<unsigned int> masks;
+        for (const Batch& batch : batches)
+            if (std::find(masks.begin(), masks.end(), batch.features) == masks.end())
+                masks.push_back(batch.features);
+        return masks;
+    }
+
+    // Dibuja todos los meshes de una vez con el programa que este activo (sombras, sin texturas)
+    void drawAll()
+    {
+        if (allCounts.empty())
+        {
+            for (const MeshRange& range : ranges)
+            {
+                allCounts.push_back((GLsizei)range.count);
+                allOffsets.push_back((const void*)(range.firstIndex * sizeof(unsigned int)));
+                allBaseVertices.push_back(range.baseVertex);
+            }
+        }
+        glBindVertexArray(VAO);
+        glMultiDrawElementsBaseVertex(GL_TRIANGLES, allCounts.data(), GL_UNSIGNED_INT,
+                                      (const void* const*)allOffsets.data(), (GLsizei)allCounts.size(), allBaseVertices.data());
+        glBindVertexArray(0);
+    }
+
+    // Encola un multi-draw por material con los meshes visibles del frame (resultado de cullMeshes)
+    void submit(RenderQueue& queue, GLuint program, const std::vector<VisibleMesh>& visible, const glm::mat4& modelMatrix)
+    {
+        prepare(visible);
+        for (Batch& batch : batches)
+            if (!batch.list.commands.empty())
+                queue.submitMultiDraw(RENDER_PASS_OPAQUE, program, VAO, batch.textures, batch.list, modelMatrix, batch.depth);
+    }
+
+    // Igual, pero cada material con la variante de su mascara de caracteristicas. Solo los materiales
+    // que tienen todas las de required y ninguna de excluded (el G-buffer deja fuera la emision).
+    void submit(RenderQueue& queue, ShaderVariants& variants, const std::vector<VisibleMesh>& visible, const glm::mat4& modelMatrix,
+                unsigned int required = 0, unsigned int excluded = 0)
+    {
+        prepare(visible);
+        for (Batch& batch : batches)
+            if (!batch.list.commands.empty() && (batch.features & required) == required && !(batch.features & excluded))
+                queue.submitMultiDraw(RENDER_PASS_OPAQUE, variants.get(batch.features).ID, VAO, batch.textures, batch.list, modelMatrix, batch.depth);
+    }
+
+private:
+    // Listas de draws de cada material con los meshes visibles
+    void prepare(const std::vector<VisibleMesh>& visible)
+    {
+        for (Batch& batch : batches)
+        {
+            batch.list.commands.clear();
+            batch.depth = FLT_MAX;
+        }
+
+        // De delante hacia atras dentro de cada material, para aprovechar el early-z
+        sorted = visible;
+        std::sort(sorted.begin(), sorted.end(), [](const VisibleMesh& a, const VisibleMesh& b) { return a.depth < b.depth; });
+        for (const VisibleMesh& mesh : sorted)
+        {
+            const MeshRange& range = ranges[mesh.index];
+            Batch& batch = batches[meshBatch[mesh.index]];
+            batch.list.commands.push_back({ range.count, 1, range.firstIndex, range.baseVertex, 0 });
+            batch.depth = std::min(batch.depth, mesh.depth);
+        }
+
+        if (indirectBuffer)
+            uploadIndirect();
+        else
+            buildBaseVertexLists();
+    }
+
+    struct StaticVertex
+    {
+        glm::vec3 Position;
+        glm::vec3 Normal;
+        glm::vec2 TexCoords;
+        glm::vec3 Tangent;
+        glm::vec3 Bitangent;
+        float Layer;       // capa del array de texturas (0 sin arrays)
+    };
+
+    struct MeshRange
+    {
+        GLuint firstIndex;
+        GLuint count;
+        GLint baseVertex;
+    };
+
+    struct Batch
+    {
+        std::vector<Texture> textures;
+        unsigned int features = 0;   // MaterialFeature
+        MultiDrawList list;
+        float depth = 0.0f;
+    };
+
+    GLuint VAO = 0, VBO = 0, EBO = 0;
+    GLuint indirectBuffer = 0;
+    size_t indirectCapacity = 0;
+    std::vector<Batch> batches;
+    std::vector<MeshRange> ranges;
+    std::vector<unsigned int> meshBatch;
+    std::vector<GLuint> arrayed;
+    std::vector<VisibleMesh> sorted;
+    std::vector<DrawElementsIndirectCommand> staging;
+    std::vector<GLsizei> allCounts;
+    std::vector<const void*> allOffsets;
+    std::vector<GLint> allBaseVertices;
+
+    static bool sameTextures(const std::vector<Texture>& a, const std::vector<Texture>& b)
+    {
+        if (a.size() != b.size())
+            return false;
+        for (size_t i = 0; i < a.size(); i++)
+            if (a[i].id != b[i].id || a[i].type != b[i].type)
+                return false;
+        return true;
+    }
+
+    // Sube los comandos de todos los materiales a un unico buffer indirecto (huerfano cada frame)
+    void uploadIndirect()
+    {
+        staging.clear();
+        for (Batch& batch : batches)
+        {
+            batch.list.indirectBuffer = indirectBuffer;
+            batch.list.indirectOffset = staging.size() * sizeof(DrawElementsIndirectCommand);
+            staging.insert(staging.end(), batch.list.commands.begin(), batch.list.commands.end());
+        }
+        if (staging.empty())
+            return;
+
+        size_t size = staging.size() * sizeof(DrawElementsIndirectCommand);
+        glBindBuffer(GL_DRAW_INDIRECT_BUFFER, indirectBuffer);
+        if (size > indirectCapacity)
+            indirectCapacity = std::max(size, ranges.size() * sizeof(DrawElementsIndirectCommand));
+        glBufferData(GL_DRAW_INDIRECT_BUFFER, indirectCapacity, nullptr, GL_STREAM_DRAW);
+        glBufferSubData(GL_DRAW_INDIRECT_BUFFER, 0, size, staging.data());
+        glBindBuffer(GL_DRAW_INDIRECT_BUFFER, 0);
+    }
+
+    void buildBaseVertexLists()
+    {
+        for (Batch& batch : batches)
+        {
+            MultiDrawList& list = batch.list;
+            list.counts.clear();
+            list.offsets.clear();
+            list.baseVertices.clear();
+            for (const DrawElementsIndirectCommand& command : list.commands)
+            {
+                list.counts.push_back((GLsizei)command.count);
+                list.offsets.push_back((const void*)(command.firstIndex * sizeof(unsigned int)));
+                list.baseVertices.push_back(command.baseVertex);
+            }
+        }
+    }
+};
+
+// Suelta en la TextureCache las difusas 2D de un modelo que el StaticGeometry ya tiene en sus
+// arrays (una referencia por cada una de textures_loaded, como en shareModelTextures), las borra ya
+// sin esperar a pasar de unusedBudget y pone su id a 0 en textures_loaded y en los meshes para que
+// no quede ningun nombre de textura borrada (o reutilizado por otra).
+inline void releaseArrayedTextures(Model& model, const StaticGeometry& geometry)
+{
+    const std::vector<GLuint>& arrayed = geometry.arrayedTextures();
+    auto isArrayed = [&](GLuint id) { return id && std::find(arrayed.begin(), arrayed.end(), id) != arrayed.end(); };
+    for (Texture& texture : model.textures_loaded)
+        if (isArrayed(texture.id))
+            TextureCache::instance().release(texture.id);
+    TextureCache::instance().evict(0);
+
+    for (Texture& texture : model.textures_loaded)
+        if (isArrayed(texture.id))
+            texture.id = 0;
+    for (Mesh& mesh : model.meshes)
+        for (Texture& texture : mesh.textures)
+            if (isArrayed(texture.id))
+                texture.id = 0;
+}
+
+// Borra el VAO, VBO y EBO de cada Mesh de un modelo que ya esta copiado en un StaticGeometry, para
+// no tener la geometria dos veces en la GPU. Se quedan los vertices e indices en memoria (cajas,
+// colisiones, PVS); despues de esto el modelo ya no se puede dibujar con Model::Draw. El VBO y el
+// EBO de Mesh son privados: se sacan de su VAO (atributo 0 y GL_ELEMENT_ARRAY_BUFFER_BINDING).
+inline void releaseMeshBuffers(Model& model)
+{
+    for (Mesh& mesh : model.meshes)
+    {
+        if (!mesh.VAO)
+            continue;
+        GLint vbo = 0, ebo = 0;
+        glBindVertexArray(mesh.VAO);
+        glGetVertexAttribiv(0, GL_VERTEX_ATTRIB_ARRAY_BUFFER_BINDING, &vbo);
+        glGetIntegerv(GL_ELEMENT_ARRAY_BUFFER_BINDING, &ebo);
+        glBindVertexArray(0);
+        GLuint buffers[2] = { (GLuint)vbo, (GLuint)ebo };
+        glDeleteBuffers(2, buffers);
+        glDeleteVertexArrays(1, &mesh.VAO);
+        mesh.VAO = 0;
+    }
+}
+
+#endif
@@ -0,0 +1,504 @@
+#ifndef TEXTURE_ARRAY_H
+#define TEXTURE_ARRAY_H
+
+#include <glad/glad.h>
+
+#include <learnopengl/stb_image.h>
+#include <learnopengl/ktx_texture.h>
+#include <learnopengl/texture_streamer.h>
+
+#include <vector>
+#include <string>
+#include <map>
+#include <utility>
+#include <algorithm>
+#include <iostream>
+#include <cstdlib>
+
+// Agrupa texturas compatibles (mismo tamano y mismo numero de canales) en GL_TEXTURE_2D_ARRAY.
+//
+// Primero se registran los archivos con add() y luego build() los carga y crea un array por
+// grupo; cada archivo queda como una capa. Asi los meshes que antes tenian texturas distintas
+// comparten el mismo array y se pueden dibujar juntos, pasando la capa al shader.
+// Un path vacio registra una capa blanca de 1x1 (para meshes sin textura difusa).
+// Si hay version cocinada (.ktx, ver ktx_texture.h) se usa esa: las capas comprimidas solo se
+// agrupan con otras del mismo formato y suben sus mips ya calculados. Si no la hay y se pasa a
+// add() la textura 2D que ya se subio de ese archivo (la del Model), la capa se copia de ella en
+// la GPU (glCopyTexSubImage3D desde un framebuffer) en vez de decodificar la imagen otra vez.
+//
+// Con un TextureStreamer build() solo lee la cabecera de cada archivo (tamano y formato), crea los
+// arrays con todos sus niveles y deja que el streamer decodifique y suba las capas en segundo
+// plano. Mientras tanto cada array muestra solo su ultimo nivel (1x1) relleno de gris; cuando ha
+// llegado la ultima capa se generan los mips (o ya venian en el ktx) y se pasa al nivel 0.
+class TextureArrays
+{
+public:
+    struct Slot
+    {
+        int array = -1;  // indice del array (-1 si no se pudo cargar)
+        int layer = 0;
+    };
+
+    // Registra un archivo y devuelve su indice (los paths repetidos devuelven el mismo). source es
+    // la textura 2D que ya se subio de ese archivo (0 si no hay); tiene que existir hasta build().
+    unsigned int add(const std::string& path, GLuint source = 0)
+    {
+        auto it = pathSlots.find(path);
+        if (it != pathSlots.end())
+        {
+            if (!sources[it->second])
+                sources[it->second] = source;
+            return it->second;
+        }
+        unsigned int index = (unsigned int)paths.size();
+        paths.push_back(path);
+        sources.push_back(source);
+        pathSlots[path] = index;
+        return index;
+    }
+
+    // Carga todos los archivos registrados y crea los arrays. Se llama una sola vez.
+    void build(TextureStreamer* streamer = nullptr)
+    {
+        if (streamer)
+        {
+            buildStreamed(*streamer);
+            return;
+        }
+
+        GLint maxLayers = 256;
+        glGetIntegerv(GL_MAX_ARRAY_TEXTURE_LAYERS, &maxLayers);
+
+        std::vector<Image> images(paths.size());
+        for (size_t i = 0; i < paths.size(); i++)
+            images[i] = loadImage(paths[i], sources[i]);
+
+        // Grupos por tamano y formato, partidos si superan el maximo de capas
+        std::map<std::vector<int>, std::vector<unsigned int>> groups = groupImages(images);
+
+        slots.assign(paths.size(), Slot());
+        glPixelStorei(GL_UNPACK_ALIGNMENT, 1);
+        for (auto& group : groups)
+        {
+            const std::vector<unsigned int>& members = group.second;
+            for (size_t first = 0; first < members.size(); first += maxLayers)
+            {
+                size_t count = std::min(members.size() - first, (size_t)maxLayers);
+                const Image& reference = images[members[first]];
+                if (reference.cooked)
+                {
+                    buildCooked(images, members, first, count);
+                    continue;
+                }
+                GLenum format = reference.channels == 1 ? GL_RED : reference.channels == 3 ? GL_RGB : GL_RGBA;
+
+                GLuint id;
+                glGenTextures(1, &id);
+                glBindTexture(GL_TEXTURE_2D_ARRAY, id);
+                glTexImage3D(GL_TEXTURE_2D_ARRAY, 0, format, reference.width, reference.height, (GLsizei)count,
+                             0, format, GL_UNSIGNED_BYTE, nullptr);
+                for (size_t layer = 0; layer < count; layer++)
+                {
+                    unsigned int index = members[first + layer];
+                    if (images[index].source)
+                        copyLayer(images[index], id, (int)layer);
+                    else
+                        glTexSubImage3D(GL_TEXTURE_2D_ARRAY, 0, 0, 0, (GLint)layer, reference.width, reference.height, 1,
+                                        format, GL_UNSIGNED_BYTE, images[index].data);
+                    slots[index].array = (int)arrays.size();
+                    slots[index].layer = (int)layer;
+                }
+                glGenerateMipmap(GL_TEXTURE_2D_ARRAY);
+                glTexParameteri(GL_TEXTURE_2D_ARRAY, GL_TEXTURE_WRAP_S, GL_REPEAT);
+                glTexParameteri(GL_TEXTURE_2D_ARRAY, GL_TEXTURE_WRAP_T, GL_REPEAT);
+                glTexParameteri(GL_TEXTURE_2D_ARRAY, GL_TEXTURE_MIN_FILTER, GL_LINEAR_MIPMAP_LINEAR);
+                glTexParameteri(GL_TEXTURE_2D_ARRAY, GL_TEXTURE_MAG_FILTER, GL_LINEAR);
+                arrays.push_back(id);
+            }
+        }
+        glPixelStorei(GL_UNPACK_ALIGNMENT, 4);
+        glBindTexture(GL_TEXTURE_2D_ARRAY, 0);
+
+        for (Image& image : images)
+            freeImage(image);
+
+        std::cout << "TEXTURE_ARRAY::" << paths.size() << " texturas en " << arrays.size() << " arrays";
+        if (cookedLayers)
+            std::cout << " (" << cookedLayers << " cocinadas)";
+        std::cout << std::endl;
+    }
+
+    ~TextureArrays()
+    {
+        if (!arrays.empty())
+            glDeleteTextures((GLsizei)arrays.size(), arrays.data());
+        if (copyFBO)
+            glDeleteFramebuffers(1, &copyFBO);
+    }
+
+    const Slot& slot(unsigned int index) const { return slots[index]; }
+    bool resident() const { return streamingArrays == 0; }
+    GLuint arrayId(int array) const { return arrays[array]; }
+    size_t arrayCount() const { return arrays.size(); }
+
+private:
+    struct Image
+    {
+        unsigned char* data = nullptr;
+        int width = 0, height = 0, channels = 0;
+        bool fromStb = false;     // liberar con stbi_image_free
+        bool fromMalloc = false;  // liberar con free
+        bool cooked = false;      // niveles comprimidos en ktx
+        bool probed = false;      // solo cabecera (buildStreamed)
+        GLuint source = 0;        // se copia de esta textura 2D (sin data)
+        KtxImage ktx;
+    };
+
+    std::vector<std::string> paths;
+    std::vector<GLuint> sources;
+    GLuint copyFBO = 0;
+    std::map<std::string, unsigned int> pathSlots;
+    std::vector<Slot> slots;
+    std::vector<GLuint> arrays;
+    unsigned int cookedLayers = 0;
+
+    // Arrays que se estan cargando con el TextureStreamer
+    struct StreamedArray
+    {
+        GLenum format = 0;
+        GLenum compressed = 0;
+        int width = 0, height = 0;
+        int levels = 1;
+        int remaining = 0;   // capas sin subir
+    };
+    std::map<int, StreamedArray> streamed;
+    unsigned int streamingArrays = 0;
+
+    static std::map<std::vector<int>, std::vector<unsigned int>> groupImages(const std::vector<Image>& images)
+    {
+        std::map<std::vector<int>, std::vector<unsigned int>> groups;
+        for (unsigned int i = 0; i < images.size(); i++)
+            if (images[i].data || images[i].cooked || images[i].probed || images[i].source)
+                groups[{ images[i].width, images[i].height, images[i].channels, (int)images[i].ktx.internalFormat,
+                         (int)images[i].ktx.levels.size() }].push_back(i);
+        return groups;
+    }
+
+    static GLenum channelFormat(int channels)
+    {
+        return channels == 1 ? GL_RED : channels == 3 ? GL_RGB : GL_RGBA;
+    }
+
+    void buildStreamed(TextureStreamer& streamer)
+    {
+        GLint maxLayers = 256;
+        glGetIntegerv(GL_MAX_ARRAY_TEXTURE_LAYERS, &maxLayers);
+
+        std::vector<Image> images(paths.size());
+        for (size_t i = 0; i < paths.size(); i++)
+            images[i] = probeImage(paths[i], sources[i]);
+        std::map<std::vector<int>, std::vector<unsigned int>> groups = groupImages(images);
+
+        slots.assign(paths.size(), Slot());
+        std::vector<std::pair<int, int>> loadedLayers;   // ya subidas aqui; se cierran al final
+        glPixelStorei(GL_UNPACK_ALIGNMENT, 1);
+        for (auto& group : groups)
+        {
+            const std::vector<unsigned int>& members = group.second;
+            for (size_t first = 0; first < members.size(); first += maxLayers)
+            {
+                size_t count = std::min(members.size() - first, (size_t)maxLayers);
+                const Image& reference = images[members[first]];
+                int array = (int)arrays.size();
+                StreamedArray& info = streamed[array];
+                info.format = channelFormat(reference.channels);
+                info.compressed = reference.cooked ? reference.ktx.internalFormat : 0;
+                info.width = reference.width;
+                info.height = reference.height;
+                info.levels = reference.cooked ? (int)reference.ktx.levels.size() : mipLevelCount(reference.width, reference.height);
+                info.remaining = (int)count;
+
+                // Todos los niveles reservados; el ultimo en gris es lo que se ve mientras carga
+                GLuint id;
+                glGenTextures(1, &id);
+                glBindTexture(GL_TEXTURE_2D_ARRAY, id);
+                for (int level = 0; level < info.levels; level++)
+                {
+                    glTexImage3D(GL_TEXTURE_2D_ARRAY, level, info.compressed ? info.compressed : info.format,
+                                 std::max(1, info.width >> level), std::max(1, info.height >> level), (GLsizei)count,
+                                 0, info.compressed ? GL_RGBA : info.format, GL_UNSIGNED_BYTE, nullptr);
+                }
+                for (size_t layer = 0; layer < count; layer++)
+                    fillPlaceholder(info, info.levels - 1, (int)layer);
+                KtxImage parameters;
+                parameters.internalFormat = info.compressed;
+                parameters.levels.resize(info.levels);
+                setCookedTextureParameters(GL_TEXTURE_2D_ARRAY, parameters);
+                glTexParameteri(GL_TEXTURE_2D_ARRAY, GL_TEXTURE_BASE_LEVEL, info.levels - 1);
+                arrays.push_back(id);
+                streamingArrays++;
+
+                for (size_t layer = 0; layer < count; layer++)
+                {
+                    unsigned int index = members[first + layer];
+                    slots[index].array = array;
+                    slots[index].layer = (int)layer;
+                    if (images[index].data || images[index].source)
+                    {
+                        // La capa blanca de los meshes sin textura y las que se copian de una textura
+                        // ya subida no hace falta mandarlas a ningun hilo
+                        glBindTexture(GL_TEXTURE_2D_ARRAY, id);
+                        if (images[index].source)
+                            copyLayer(images[index], id, (int)layer);
+                        else
+                            glTexSubImage3D(GL_TEXTURE_2D_ARRAY, 0, 0, 0, (GLint)layer, 1, 1, 1, GL_RGBA, GL_UNSIGNED_BYTE, images[index].data);
+                        loadedLayers.push_back(std::make_pair(array, (int)layer));
+                        continue;
+                    }
+                    std::string path = paths[index];
+                    int width = info.width, height = info.height, channels = reference.channels;
+                    GLenum compressed = info.compressed;
+                    streamer.enqueue(id, (int)layer,
+                                     [path, width, height, channels, compressed](StreamImage& out) {
+                                         return decodeLayer(path, width, height, channels, compressed, out);
+                                     },
+                                     [this, array, layer](bool ok) { layerDone(array, (int)layer, ok); });
+                    if (reference.cooked)
+                        cookedLayers++;
+                }
+            }
+        }
+        glPixelStorei(GL_UNPACK_ALIGNMENT, 4);
+
+        std::cout << "TEXTURE_ARRAY::" << paths.size() << " texturas en " << arrays.size() << " arrays, cargando en segundo plano" << std::endl;
+        for (auto& loaded : loadedLayers)
+            layerDone(loaded.first, loaded.second, true);
+        glBindTexture(GL_TEXTURE_2D_ARRAY, 0);
+    }
+
+    static int mipLevelCount(int width, int height)
+    {
+        int levels = 1;
+        while ((width | height) >> levels)
+            levels++;
+        return levels;
+    }
+
+    // Gris en un nivel de una capa
+    static void fillPlaceholder(const StreamedArray& info, int level, int layer)
+    {
+        int width = std::max(1, info.width >> level), height = std::max(1, info.height >> level);
+        if (info.compressed)
+        {
+            unsigned int blockBytes = compressedBlockBytes(info.compressed);
+            std::vector<unsigned char> data(compressedLevelBytes(info.compressed, width, height));
+            for (size_t offset = 0; offset < data.size(); offset += blockBytes)
+                std::copy(compressedPlaceholderBlock(info.compressed), compressedPlaceholderBlock(info.compressed) + blockBytes,
+                          data.begin() + offset);
+            glCompressedTexSubImage3D(GL_TEXTURE_2D_ARRAY, level, 0, 0, layer, width, height, 1, info.compressed,
+                                      (GLsizei)data.size(), data.data());
+        }
+        else
+        {
+            std::vector<unsigned char> data((size_t)width * height * 4, 128);
+            glTexSubImage3D(GL_TEXTURE_2D_ARRAY, level, 0, 0, layer, width, height, 1, GL_RGBA, GL_UNSIGNED_BYTE, data.data());
+        }
+    }
+
+    // En un hilo del TextureStreamer
+    static bool decodeLayer(const std::string& path, int width, int height, int channels, GLenum compressed, StreamImage& out)
+    {
+        Image image = loadImage(path, 0);
+        bool ok = image.width == width && image.height == height &&
+                  (compressed ? image.cooked && image.ktx.internalFormat == compressed : image.data && image.channels == channels);
+        if (ok)
+        {
+            out.width = width;
+            out.height = height;
+            out.format = channelFormat(channels);
+            out.compressed = compressed;
+            if (compressed)
+                out.levels = std::move(image.ktx.levels);
+            else
+                out.levels.push_back(std::vector<unsigned char>(image.data, image.data + (size_t)width * height * channels));
+        }
+        freeImage(image);
+        return ok;
+    }
+
+    // En el hilo de render, cuando el streamer termina una capa
+    void layerDone(int array, int layer, bool ok)
+    {
+        StreamedArray& info = streamed[array];
+        glBindTexture(GL_TEXTURE_2D_ARRAY, arrays[array]);
+        if (!ok)
+        {
+            std::cout << "TEXTURE_ARRAY::Capa " << layer << " del array " << array << " sin cargar, se queda en gris" << std::endl;
+            for (int level = 0; level < (info.compressed ? info.levels : 1); level++)
+                fillPlaceholder(info, level, layer);
+        }
+        if (--info.remaining > 0)
+            return;
+
+        glTexParameteri(GL_TEXTURE_2D_ARRAY, GL_TEXTURE_BASE_LEVEL, 0);
+        if (!info.compressed)
+            glGenerateMipmap(GL_TEXTURE_2D_ARRAY);
+        if (--streamingArrays == 0)
+            std::cout << "TEXTURE_ARRAY::Todas las texturas cargadas" << std::endl;
+    }
+
+    // Solo la cabecera: tamano y formato (la capa blanca si se carga entera)
+    static Image probeImage(const std::string& path, GLuint source)
+    {
+        Image image;
+        if (path.empty())
+            return loadImage(path, 0);
+        if (readKtx(cookedTexturePath(path), image.ktx, true) && compressedFormatSupported(image.ktx.internalFormat))
+        {
+            image.cooked = true;
+            image.width = image.ktx.width;
+            image.height = image.ktx.height;
+            return image;
+        }
+        image.ktx = KtxImage();
+        if (describeSource(source, image))
+            return image;
+        if (!stbi_info(path.c_str(), &image.width, &image.height, &image.channels))
+        {
+            std::cout << "TEXTURE_ARRAY::No se pudo cargar " << path << std::endl;
+            return image;
+        }
+        if (image.channels == 2)
+            image.channels = 4;   // loadImage lo expande a RGBA
+        image.probed = true;
+        return image;
+    }
+
+    // Un array comprimido: cada nivel se sube de una vez con las capas seguidas
+    void buildCooked(const std::vector<Image>& images, const std::vector<unsigned int>& members, size_t first, size_t count)
+    {
+        const KtxImage& reference = images[members[first]].ktx;
+        GLuint id;
+        glGenTextures(1, &id);
+        glBindTexture(GL_TEXTURE_2D_ARRAY, id);
+        std::vector<unsigned char> levelData;
+        int width = reference.width, height = reference.height;
+        for (size_t level = 0; level < reference.levels.size(); level++)
+        {
+            levelData.clear();
+            for (size_t layer = 0; layer < count; layer++)
+            {
+                const std::vector<unsigned char>& data = images[members[first + layer]].ktx.levels[level];
+                levelData.insert(levelData.end(), data.begin(), data.end());
+            }
+            glCompressedTexImage3D(GL_TEXTURE_2D_ARRAY, (GLint)level, reference.internalFormat, width, height, (GLsizei)count,
+                                   0, (GLsizei)levelData.size(), levelData.data());
+            width = std::max(1, width / 2);
+            height = std::max(1, height / 2);
+        }
+        for (size_t layer = 0; layer < count; layer++)
+        {
+            slots[members[first + layer]].array = (int)arrays.size();
+            slots[members[first + layer]].layer = (int)layer;
+        }
+        setCookedTextureParameters(GL_TEXTURE_2D_ARRAY, reference);
+        arrays.push_back(id);
+        cookedLayers += (unsigned int)count;
+    }
+
+    // Tamano y canales de una textura 2D ya subida (como la deja TextureFromFile de learnopengl).
+    // false si no hay o su formato no es de 1, 3 o 4 canales de 8 bits.
+    static bool describeSource(GLuint source, Image& image)
+    {
+        if (!source || !glIsTexture(source))
+            return false;
+        GLint width = 0, height = 0, format = 0;
+        glBindTexture(GL_TEXTURE_2D, source);
+        glGetTexLevelParameteriv(GL_TEXTURE_2D, 0, GL_TEXTURE_WIDTH, &width);
+        glGetTexLevelParameteriv(GL_TEXTURE_2D, 0, GL_TEXTURE_HEIGHT, &height);
+        glGetTexLevelParameteriv(GL_TEXTURE_2D, 0, GL_TEXTURE_INTERNAL_FORMAT, &format);
+        glBindTexture(GL_TEXTURE_2D, 0);
+        int channels = format == GL_RED || format == GL_R8 ? 1 : format == GL_RGB || format == GL_RGB8 ? 3 :
+                       format == GL_RGBA || format == GL_RGBA8 ? 4 : 0;
+        if (width <= 0 || height <= 0 || channels == 0)
+            return false;
+        image.width = width;
+        image.height = height;
+        image.channels = channels;
+        image.source = source;
+        return true;
+    }
+
+    // Copia el nivel 0 de la textura de origen a una capa del array (los dos del mismo tamano y canales)
+    void copyLayer(const Image& image, GLuint array, int layer)
+    {
+        if (!copyFBO)
+            glGenFramebuffers(1, &copyFBO);
+        GLint previous = 0;
+        glGetIntegerv(GL_READ_FRAMEBUFFER_BINDING, &previous);
+        glBindFramebuffer(GL_READ_FRAMEBUFFER, copyFBO);
+        glFramebufferTexture2D(GL_READ_FRAMEBUFFER, GL_COLOR_ATTACHMENT0, GL_TEXTURE_2D, image.source, 0);
+        glReadBuffer(GL_COLOR_ATTACHMENT0);
+        glBindTexture(GL_TEXTURE_2D_ARRAY, array);
+        glCopyTexSubImage3D(GL_TEXTURE_2D_ARRAY, 0, 0, 0, layer, 0, 0, image.width, image.height);
+        glFramebufferTexture2D(GL_READ_FRAMEBUFFER, GL_COLOR_ATTACHMENT0, GL_TEXTURE_2D, 0, 0);
+        glBindFramebuffer(GL_READ_FRAMEBUFFER, (GLuint)previous);
+    }
+
+    static Image loadImage(const std::string& path, GLuint source)
+    {
+        static unsigned char white[4] = { 255, 255, 255, 255 };
+        Image image;
+        if (path.empty())
+        {
+            image.data = white;
+            image.width = image.height = 1;
+            image.channels = 4;
+            return image;
+        }
+        if (readKtx(cookedTexturePath(path), image.ktx) && compressedFormatSupported(image.ktx.internalFormat))
+        {
+            image.cooked = true;
+            image.width = image.ktx.width;
+            image.height = image.ktx.height;
+            return image;
+        }
+        image.ktx = KtxImage();
+        if (describeSource(source, image))
+            return image;
+        image.data = stbi_load(path.c_str(), &image.width, &image.height, &image.channels, 0);
+        if (!image.data)
+        {
+            std::cout << "TEXTURE_ARRAY::No se pudo cargar " << path << std::endl;
+            return image;
+        }
+        if (image.channels == 2)
+        {
+            // GL_RG no se parece a nada que use learnopengl: se expande a RGBA (gris + alfa)
+            unsigned char* rgba = (unsigned char*)malloc((size_t)image.width * image.height * 4);
+            for (size_t p = 0; p < (size_t)image.width * image.height; p++)
+            {
+                rgba[p * 4 + 0] = rgba[p * 4 + 1] = rgba[p * 4 + 2] = image.data[p * 2];
+                rgba[p * 4 + 3] = image.data[p * 2 + 1];
+            }
+            stbi_image_free(image.data);
+            image.data = rgba;
+            image.channels = 4;
+            image.fromMalloc = true;
+            return image;
+        }
+        image.fromStb = true;
+        return image;
+    }
+
+    static void freeImage(Image& image)
+    {
+        if (image.fromStb)
+            stbi_image_free(image.data);
+        else if (image.fromMalloc)
+            free(image.data);
+        image.data = nullptr;
+    }
+};
+
+#endif
@@ -0,0 +1,430 @@
+#ifndef TEXTURE_CACHE_H
+#define TEXTURE_CACHE_H
+
+#include <glad/glad.h>
+
+#include <learnopengl/stb_image.h>
+#include <learnopengl/ktx_texture.h>
+#include <learnopengl/mip_streamer.h>
+
+#include <vector>
+#include <map>
+#include <string>
+#include <fstream>
+#include <algorithm>
+#include <iostream>
+#include <cstdlib>
+#include <cstdint>
+#include <climits>
+#include <cctype>
+
+// Cache de texturas 2D de todo el programa.
+//
+// Cada textura se guarda por su ruta canonica (absoluta, con '/' y sin "." ni "..") y por un hash
+// del contenido del archivo que se sube (el .ktx cocinado si se usa, si no la imagen): pedir el
+// mismo archivo desde otro modelo, o un archivo identico con otro nombre, devuelve el mismo objeto
+// de GL en vez de decodificarlo y subirlo otra vez.
+//
+// Cada acquire/adopt suma una referencia y release la quita. Las texturas sin referencias no se
+// borran enseguida: se quedan por si se vuelven a pedir mientras el total sin usar no pase de
+// unusedBudget bytes, y si pasa se borran primero las que llevan mas tiempo sin usar.
+//
+// Los Model de learnopengl cargan sus texturas por su cuenta; shareModelTextures las registra
+// despues de cargar y cambia las repetidas por la que ya estaba en la cache, y las que tienen
+// version cocinada por esa. Con streaming las cocinadas se cargan con el MipStreamer (solo los
+// mips pequenos al principio).
+class TextureCache
+{
+public:
+    size_t unusedBudget = 64 * 1024 * 1024;
+    MipStreamer* streaming = nullptr;   // si no, las cocinadas se suben enteras
+
+    static TextureCache& instance()
+    {
+        static TextureCache cache;
+        return cache;
+    }
+
+    // Textura de un archivo (la version cocinada si existe). 0 si no se pudo cargar.
+    GLuint acquire(const std::string& path)
+    {
+        std::string canonical = canonicalPath(path);
+        GLuint id = find(canonical);
+        if (id)
+            return id;
+
+        std::string file = uploadedFile(path);
+        uint64_t hash = 0;
+        if (!hashFile(file, hash))
+        {
+            std::cout << "TEXTURE_CACHE::No se pudo leer " << path << std::endl;
+            return 0;
+        }
+        id = findContent(canonical, hash);
+        if (id)
+            return id;
+
+        id = file != path ? loadCooked(file) : 0;
+        if (!id)
+            id = loadImage(path);
+        if (!id)
+            return 0;
+        insert(id, canonical, hash);
+        loads++;
+        return id;
+    }
+
+    // Registra una textura que ya se subio de path. Si ese archivo (o uno igual) ya estaba se borra
+    // id y se devuelve la compartida; si hay version cocinada se borra id y se carga esa; si no, la
+    // cache se queda con id.
+    GLuint adopt(const std::string& path, GLuint id)
+    {
+        std::string canonical = canonicalPath(path);
+        GLuint shared = find(canonical);
+        std::string file = uploadedFile(path);
+        uint64_t hash = 0;
+        if (!shared && hashFile(file, hash))
+            shared = findContent(canonical, hash);
+        if (shared)
+        {
+            if (shared != id)
+            {
+                glDeleteTextures(1, &id);
+                duplicates++;
+            }
+            return shared;
+        }
+        GLuint cooked = file != path ? loadCooked(file) : 0;
+        if (cooked)
+        {
+            glDeleteTextures(1, &id);
+            id = cooked;
+        }
+        insert(id, canonical, hash);
+        return id;
+    }
+
+    void retain(GLuint id)
+    {
+        auto it = entries.find(id);
+        if (it != entries.end())
+            it->second.refs++;
+    }
+
+    void release(GLuint id)
+    {
+        auto it = entries.find(id);
+        if (it == entries.end() || it->second.refs == 0)
+            return;
+        if (--it->second.refs == 0)
+        {
+            it->second.lastUse = ++clock;
+            evict(unusedBudget);
+        }
+    }
+
+    // Borra texturas sin referencias, las mas antiguas primero, hasta que queden como mucho budget bytes
+    void evict(size_t budget)
+    {
+        size_t unused = unusedBytes();
+        while (unused > budget)
+        {
+            auto oldest = entries.end();
+            for (auto it = entries.begin(); it != entries.end(); ++it)
+                if (it->second.refs == 0 && (oldest == entries.end() || it->second.lastUse < oldest->second.lastUse))
+                    oldest = it;
+            if (oldest == entries.end())
+                break;
+            unused -= oldest->second.bytes;
+            remove(oldest);
+            evictions++;
+        }
+    }
+
+    size_t residentBytes() const
+    {
+        size_t bytes = 0;
+        for (auto& entry : entries)
+            bytes += entry.second.bytes;
+        return bytes;
+    }
+
+    size_t unusedBytes() const
+    {
+        size_t bytes = 0;
+        for (auto& entry : entries)
+            if (entry.second.refs == 0)
+                bytes += entry.second.bytes;
+        return bytes;
+    }
+
+    void report() const
+    {
+        std::cout << "TEXTURE_CACHE::" << entries.size() << " texturas (" << residentBytes() / (1024 * 1024) << " MB), "
+                  << hits << " compartidas, " << duplicates << " duplicadas borradas, " << loads << " cargadas, "
+                  << evictions << " expulsadas" << std::endl;
+    }
+
+    // Ruta absoluta con '/' (y en minusculas en Windows) para que dos formas de escribir el mismo
+    // archivo den la misma clave. Si el archivo no existe solo se quitan "." y "..".
+    static std::string canonicalPath(const std::string& path)
+    {
+        std::string result;
+#ifdef _WIN32
+        char full[_MAX_PATH];
+        if (_fullpath(full, path.c_str(), _MAX_PATH))
+            result = full;
+#else
+        char full[PATH_MAX];
+        if (realpath(path.c_str(), full))
+            result = full;
+#endif
+        if (result.empty())
+            result = path;
+        std::replace(result.begin(), result.end(), '\\', '/');
+#ifdef _WIN32
+        std::transform(result.begin(), result.end(), result.begin(), [](unsigned char c) { return (char)std::tolower(c); });
+#endif
+        return normalize(result);
+    }
+
+private:
+    struct Entry
+    {
+        uint64_t hash = 0;
+        std::vector<std::string> paths;   // rutas canonicas que apuntan a esta textura
+        unsigned int refs = 0;
+        size_t bytes = 0;
+        uint64_t lastUse = 0;             // para expulsar primero la que lleva mas tiempo sin usar
+    };
+
+    std::map<GLuint, Entry> entries;
+    std::map<std::string, GLuint> byPath;
+    std::map<uint64_t, GLuint> byHash;
+    uint64_t clock = 0;
+    unsigned int hits = 0;
+    unsigned int duplicates = 0;
+    unsigned int loads = 0;
+    unsigned int evictions = 0;
+
+    TextureCache() = default;
+    TextureCache(const TextureCache&) = delete;
+    TextureCache& operator=(const TextureCache&) = delete;
+
+    GLuint find(const std::string& canonical)
+    {
+        auto it = byPath.find(canonical);
+        if (it == byPath.end())
+            return 0;
+        entries[it->second].refs++;
+        hits++;
+        return it->second;
+    }
+
+    // Mismo contenido con otra ruta: la ruta nueva pasa a apuntar a la misma textura
+    GLuint findContent(const std::string& canonical, uint64_t hash)
+    {
+        auto it = byHash.find(hash);
+        if (it == byHash.end())
+            return 0;
+        Entry& entry = entries[it->second];
+        entry.paths.push_back(canonical);
+        entry.refs++;
+        byPath[canonical] = it->second;
+        hits++;
+        return it->second;
+    }
+
+    void insert(GLuint id, const std::string& canonical, uint64_t hash)
+    {
+        Entry& entry = entries[id];
+        entry.hash = hash;
+        entry.paths.push_back(canonical);
+        entry.refs = 1;
+        entry.bytes = textureBytes(id);
+        byPath[canonical] = id;
+        if (hash)
+            byHash[hash] = id;
+    }
+
+    void remove(std::map<GLuint, Entry>::iterator it)
+    {
+        for (const std::string& path : it->second.paths)
+            byPath.erase(path);
+        auto hashIt = byHash.find(it->second.hash);
+        if (hashIt != byHash.end() && hashIt->second == it->first)
+            byHash.erase(hashIt);
+        GLuint id = it->first;
+        if (streaming)
+            streaming->forget(id);
+        glDeleteTextures(1, &id);
+        entries.erase(it);
+    }
+
+    // El .ktx si existe y el driver tiene su formato (lo mismo que decide useCookedTextures)
+    static std::string uploadedFile(const std::string& path)
+    {
+        std::string cooked = cookedTexturePath(path);
+        KtxImage header;
+        if (readKtx(cooked, header, true) && compressedFormatSupported(header.internalFormat))
+            return cooked;
+        return path;
+    }
+
+    GLuint loadCooked(const std::string& file)
+    {
+        return streaming ? streaming->load(file) : loadCookedTexture(file);
+    }
+
+    // FNV-1a de 64 bits del archivo entero
+    static bool hashFile(const std::string& path, uint64_t& hash)
+    {
+        std::ifstream file(path, std::ios::binary);
+        if (!file.is_open())
+            return false;
+        hash = 14695981039346656037ull;
+        std::vector<char> buffer(64 * 1024);
+        while (file)
+        {
+            file.read(buffer.data(), buffer.size());
+            std::streamsize count = file.gcount();
+            for (std::streamsize i = 0; i < count; i++)
+            {
+                hash ^= (unsigned char)buffer[i];
+                hash *= 1099511628211ull;
+            }
+        }
+        return true;
+    }
+
+    // Quita "." y ".." de una ruta con '/'
+    static std::string normalize(const std::string& path)
+    {
+        std::vector<std::string> parts;
+        size_t start = 0;
+        while (start <= path.size())
+        {
+            size_t end = path.find('/', start);
+            if (end == std::string::npos)
+                end = path.size();
+            std::string part = path.substr(start, end - start);
+            if (part == "..")
+            {
+                if (!parts.empty() && parts.back() != ".." && !parts.back().empty())
+                    parts.pop_back();
+                else
+                    parts.push_back(part);
+            }
+            else if (part != "." && !(part.empty() && !parts.empty()))
+                parts.push_back(part);
+            start = end + 1;
+        }
+        std::string result;
+        for (size_t i = 0; i < parts.size(); i++)
+            result += (i ? "/" : "") + parts[i];
+        return result;
+    }
+
+    // Tamano aproximado en VRAM: todos los niveles que tenga. Las del MipStreamer empiezan en
+    // GL_TEXTURE_BASE_LEVEL y los niveles de encima pueden no existir, asi que no se para en el
+    // primer nivel vacio; lo que el MipStreamer sube despues cuenta en su propio presupuesto.
+    static size_t textureBytes(GLuint id)
+    {
+        // Solo hasta el ultimo nivel que admite el driver: pasarse da GL_INVALID_VALUE
+        static int levelCount = 0;
+        if (!levelCount)
+        {
+            GLint maxSize = 1;
+            glGetIntegerv(GL_MAX_TEXTURE_SIZE, &maxSize);
+            while ((1 << levelCount) <= maxSize)
+                levelCount++;
+        }
+        size_t bytes = 0;
+        glBindTexture(GL_TEXTURE_2D, id);
+        for (int level = 0; level < levelCount; level++)
+        {
+            GLint width = 0, height = 0, compressed = 0;
+            glGetTexLevelParameteriv(GL_TEXTURE_2D, level, GL_TEXTURE_WIDTH, &width);
+            glGetTexLevelParameteriv(GL_TEXTURE_2D, level, GL_TEXTURE_HEIGHT, &height);
+            if (width == 0 || height == 0)
+                continue;
+            glGetTexLevelParameteriv(GL_TEXTURE_2D, level, GL_TEXTURE_COMPRESSED, &compressed);
+            if (compressed)
+            {
+                GLint size = 0;
+                glGetTexLevelParameteriv(GL_TEXTURE_2D, level, GL_TEXTURE_COMPRESSED_IMAGE_SIZE, &size);
+                bytes += (size_t)size;
+            }
+            else
+                bytes += (size_t)width * height * 4;
+        }
+        glBindTexture(GL_TEXTURE_2D, 0);
+        return bytes;
+    }
+
+    // Como TextureFromFile de learnopengl
+    static GLuint loadImage(const std::string& path)
+    {
+        int width, height, channels;
+        unsigned char* data = stbi_load(path.c_str(), &width, &height, &channels, 0);
+        if (!data)
+        {
+            std::cout << "TEXTURE_CACHE::No se pudo cargar " << path << std::endl;
+            return 0;
+        }
+        GLenum format = channels == 1 ? GL_RED : channels == 3 ? GL_RGB : GL_RGBA;
+
+        GLuint id;
+        glGenTextures(1, &id);
+        glBindTexture(GL_TEXTURE_2D, id);
+        glPixelStorei(GL_UNPACK_ALIGNMENT, 1);
+        glTexImage2D(GL_TEXTURE_2D, 0, format, width, height, 0, format, GL_UNSIGNED_BYTE, data);
+        glPixelStorei(GL_UNPACK_ALIGNMENT, 4);
+        glGenerateMipmap(GL_TEXTURE_2D);
+        glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_WRAP_S, GL_REPEAT);
+        glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_WRAP_T, GL_REPEAT);
+        glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_MIN_FILTER, GL_LINEAR_MIPMAP_LINEAR);
+        glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_MAG_FILTER, GL_LINEAR);
+        glBindTexture(GL_TEXTURE_2D, 0);
+        stbi_image_free(data);
+        return id;
+    }
+};
+
+// Registra en la TextureCache las texturas de un Model de learnopengl, cambia las que ya tenia otro
+// modelo por la compartida y las que tienen .ktx por la cocinada (hace lo mismo que
+// useCookedTextures, que ya no hay que llamar). Llamar justo despues de cargar el modelo y antes de
+// copiar sus texturas (StaticGeometry, LodModel). Devuelve cuantas se cambiaron.
+template <typename ModelType>
+unsigned int shareModelTextures(ModelType& model)
+{
+    std::map<unsigned int, unsigned int> replaced;
+    for (auto& texture : model.textures_loaded)
+    {
+        GLuint shared = TextureCache::instance().adopt(model.directory + '/' + texture.path, texture.id);
+        if (shared == texture.id)
+            continue;
+        replaced[texture.id] = shared;
+        texture.id = shared;
+    }
+    for (auto& mesh : model.meshes)
+        for (auto& texture : mesh.textures)
+        {
+            auto it = replaced.find(texture.id);
+            if (it != replaced.end())
+                texture.id = it->second;
+        }
+    if (!replaced.empty())
+        std::cout << "TEXTURE_CACHE::" << replaced.size() << " texturas de " << model.directory << " compartidas o cocinadas" << std::endl;
+    return (unsigned int)replaced.size();
+}
+
+// Suelta las referencias de un modelo (cuando deja de usarse)
+template <typename ModelType>
+void releaseModelTextures(ModelType& model)
+{
+    for (auto& texture : model.textures_loaded)
+        TextureCache::instance().release(texture.id);
+}
+
+#endif
@@ -0,0 +1,345 @@
+#ifndef TEXTURE_STREAMER_H
+#define TEXTURE_STREAMER_H
+
+#include <glad/glad.h>
+
+#include <vector>
+#include <deque>
+#include <string>
+#include <functional>
+#include <thread>
+#include <mutex>
+#include <condition_variable>
+#include <chrono>
+#include <algorithm>
+#include <utility>
+#include <iostream>
+#include <cstring>
+
+// Imagen ya decodificada lista para subir. Sin comprimir solo se sube el nivel 0 (format = GL_RED,
+// GL_RGB o GL_RGBA, un byte por canal) y los mips los hace quien la pidio; comprimida (compressed
+// = formato interno de ktx_texture.h) trae sus niveles desde firstLevel (width y height son los del
+// nivel 0 aunque no venga).
+struct StreamImage
+{
+    int width = 0, height = 0;
+    GLenum format = 0;
+    GLenum compressed = 0;
+    int firstLevel = 0;
+    std::vector<std::vector<unsigned char>> levels;
+};
+
+// Carga de texturas en segundo plano.
+//
+// enqueue() manda la decodificacion (stbi_load, lectura de un ktx...) a un grupo de hilos y
+// vuelve enseguida. El hilo de render llama a update() una vez por frame: copia las imagenes ya
+// decodificadas a un anillo de pixel buffer objects que se crean una sola vez y de ahi a la
+// textura con glTexSubImage3D, por trozos de filas y solo mientras quede presupuesto de tiempo
+// del frame. Antes de reutilizar un PBO se comprueba su fence sin esperar, asi que la subida
+// nunca para a la CPU: si la GPU va atrasada se sigue en el frame siguiente. Cuando una imagen
+// termina de subirse se llama a su callback, tambien en el hilo de render.
+//
+// El destino es una capa de un GL_TEXTURE_2D_ARRAY o una GL_TEXTURE_2D con los niveles ya creados
+// con su tamano y formato. Mientras no termina se ve lo que tuviera antes la textura (ver
+// TextureArrays: un color de relleno; MipStreamer: los mips pequenos, con GL_TEXTURE_BASE_LEVEL).
+class TextureStreamer
+{
+public:
+    typedef std::function<bool(StreamImage&)> DecodeFunction;   // en un hilo del grupo
+    typedef std::function<void(bool ok)> DoneFunction;          // en el hilo de render
+
+    static const int PBO_COUNT = 4;
+    static const size_t PBO_SIZE = 4 * 1024 * 1024;
+
+    // Estadisticas
+    size_t uploadedBytes = 0;
+    float lastUpdateMs = 0.0f;
+
+    explicit TextureStreamer(unsigned int threadCount = 0)
+    {
+        if (threadCount == 0)
+            threadCount = std::max(2u, std::thread::hardware_concurrency()) - 1;   // uno queda para el render
+        for (unsigned int i = 0; i < threadCount; i++)
+            workers.emplace_back([this]() { run(); });
+
+        glGenBuffers(PBO_COUNT, pbos);
+        for (int i = 0; i < PBO_COUNT; i++)
+        {
+            glBindBuffer(GL_PIXEL_UNPACK_BUFFER, pbos[i]);
+            glBufferData(GL_PIXEL_UNPACK_BUFFER, PBO_SIZE, nullptr, GL_STREAM_DRAW);
+            fences[i] = nullptr;
+        }
+        glBindBuffer(GL_PIXEL_UNPACK_BUFFER, 0);
+    }
+
+    ~TextureStreamer()
+    {
+        {
+            std::lock_guard<std::mutex> lock(mutex);
+            stopping = true;
+        }
+        wakeWorkers.notify_all();
+        for (std::thread& worker : workers)
+            worker.join();
+        for (int i = 0; i < PBO_COUNT; i++)
+            if (fences[i])
+                glDeleteSync(fences[i]);
+        glDeleteBuffers(PBO_COUNT, pbos);
+    }
+
+    TextureStreamer(const TextureStreamer&) = delete;
+    TextureStreamer& operator=(const TextureStreamer&) = delete;
+
+    void enqueue(GLuint texture, int layer, DecodeFunction decode, DoneFunction done, GLenum target = GL_TEXTURE_2D_ARRAY)
+    {
+        Job job;
+        job.target = target;
+        job.texture = texture;
+        job.layer = layer;
+        job.decode = decode;
+        job.done = done;
+        {
+            std::lock_guard<std::mutex> lock(mutex);
+            job.serial = nextSerial++;
+            waiting.push_back(std::move(job));
+            pendingCount++;
+        }
+        wakeWorkers.notify_one();
+    }
+
+    // Descarta todo lo que quede para esa textura (sin llamar a sus callbacks): lo que espera a un
+    // hilo, lo ya decodificado y lo que se esta subiendo. Lo que un hilo esta decodificando ahora se
+    // tira cuando acabe. Hay que llamarlo antes de borrar la textura, o la subida iria a un id borrado
+    // (o que glGenTextures ya ha dado a otra).
+    void cancel(GLuint texture)
+    {
+        auto sameTexture = [texture](const Job& job) { return job.texture == texture; };
+        std::lock_guard<std::mutex> lock(mutex);
+        size_t before = waiting.size() + decoded.size();
+        waiting.erase(std::remove_if(waiting.begin(), waiting.end(), sameTexture), waiting.end());
+        decoded.erase(std::remove_if(decoded.begin(), decoded.end(), sameTexture), decoded.end());
+        pendingCount -= before - waiting.size() - decoded.size();
+        for (const std::pair<unsigned long, GLuint>& job : decoding)
+            if (job.second == texture)
+                cancelled.push_back(job.first);
+        if (current.active && current.job.texture == texture)
+        {
+            current.active = false;
+            current.job = Job();
+            pendingCount--;
+        }
+    }
+
+    // Imagenes que todavia no estan en la GPU
+    size_t pending() const
+    {
+        std::lock_guard<std::mutex> lock(mutex);
+        return pendingCount;
+    }
+
+    // Sube trozos durante como mucho budgetMs. Llamar una vez por frame desde el hilo de render.
+    void update(float budgetMs)
+    {
+        auto start = std::chrono::steady_clock::now();
+        auto elapsedMs = [&]() { return std::chrono::duration<float, std::milli>(std::chrono::steady_clock::now() - start).count(); };
+
+        glPixelStorei(GL_UNPACK_ALIGNMENT, 1);
+        while (elapsedMs() < budgetMs)
+        {
+            if (!current.active && !nextDecoded())
+                break;
+            if (!uploadChunk())
+                break;   // ningun PBO libre: la GPU todavia no ha consumido los anteriores
+        }
+        glBindBuffer(GL_PIXEL_UNPACK_BUFFER, 0);
+        glBindTexture(GL_TEXTURE_2D_ARRAY, 0);
+        glBindTexture(GL_TEXTURE_2D, 0);
+        glPixelStorei(GL_UNPACK_ALIGNMENT, 4);
+        lastUpdateMs = elapsedMs();
+    }
+
+    // Sube todo lo pendiente (esperando a los hilos y a la GPU si hace falta)
+    void finish()
+    {
+        while (pending() > 0)
+        {
+            update(1000.0f);
+            if (pending() > 0)
+            {
+                glFlush();   // para que avancen los fences de los PBO
+                std::this_thread::sleep_for(std::chrono::milliseconds(1));
+            }
+        }
+    }
+
+private:
+    struct Job
+    {
+        GLenum target = GL_TEXTURE_2D_ARRAY;
+        GLuint texture = 0;
+        int layer = 0;
+        unsigned long serial = 0;
+        DecodeFunction decode;
+        DoneFunction done;
+        StreamImage image;
+        bool ok = false;
+    };
+
+    // Imagen que se esta subiendo: nivel y fila (en bloques de 4 si es comprimida) por los que va
+    struct Upload
+    {
+        bool active = false;
+        Job job;
+        size_t level = 0;
+        int row = 0;
+    };
+
+    std::vector<std::thread> workers;
+    mutable std::mutex mutex;
+    std::condition_variable wakeWorkers;
+    std::deque<Job> waiting;    // sin decodificar
+    std::deque<Job> decoded;    // listas para subir
+    size_t pendingCount = 0;
+    bool stopping = false;
+    unsigned long nextSerial = 0;
+    std::vector<std::pair<unsigned long, GLuint>> decoding;   // serial y textura de lo que hay en los hilos
+    std::vector<unsigned long> cancelled;                     // de esos, los que hay que tirar al acabar
+
+    GLuint pbos[PBO_COUNT];
+    GLsync fences[PBO_COUNT];
+    int nextPbo = 0;
+    Upload current;
+
+    void run()
+    {
+        for (;;)
+        {
+            Job job;
+            {
+                std::unique_lock<std::mutex> lock(mutex);
+                wakeWorkers.wait(lock, [this]() { return stopping || !waiting.empty(); });
+                if (stopping)
+                    return;
+                job = std::move(waiting.front());
+                waiting.pop_front();
+                decoding.push_back(std::make_pair(job.serial, job.texture));
+            }
+            job.ok = job.decode(job.image) && !job.image.levels.empty();
+            std::lock_guard<std::mutex> lock(mutex);
+            decoding.erase(std::find(decoding.begin(), decoding.end(), std::make_pair(job.serial, job.texture)));
+            auto wasCancelled = std::find(cancelled.begin(), cancelled.end(), job.serial);
+            if (wasCancelled != cancelled.end())
+            {
+                cancelled.erase(wasCancelled);
+                pendingCount--;
+                continue;
+            }
+            decoded.push_back(std::move(job));
+        }
+    }
+
+    // Pasa la siguiente imagen decodificada a current; las que fallaron se terminan aqui
+    bool nextDecoded()
+    {
+        for (;;)
+        {
+            Job job;
+            {
+                std::lock_guard<std::mutex> lock(mutex);
+                if (decoded.empty())
+                    return false;
+                job = std::move(decoded.front());
+                decoded.pop_front();
+            }
+            if (job.ok)
+            {
+                current.active = true;
+                current.job = std::move(job);
+                current.level = 0;
+                current.row = 0;
+                return true;
+            }
+            complete(job);
+        }
+    }
+
+    void complete(Job& job)
+    {
+        glBindBuffer(GL_PIXEL_UNPACK_BUFFER, 0);   // el callback puede subir datos desde memoria
+        if (job.done)
+            job.done(job.ok);
+        std::lock_guard<std::mutex> lock(mutex);
+        pendingCount--;
+    }
+
+    // Un trozo de filas del nivel actual a traves del siguiente PBO del anillo
+    bool uploadChunk()
+    {
+        GLsync& fence = fences[nextPbo];
+        if (fence)
+        {
+            if (glClientWaitSync(fence, 0, 0) == GL_TIMEOUT_EXPIRED)
+                return false;
+            glDeleteSync(fence);
+            fence = nullptr;
+        }
+
+        const StreamImage& image = current.job.image;
+        GLint level = image.firstLevel + (GLint)current.level;
+        int width = std::max(1, image.width >> level);
+        int height = std::max(1, image.height >> level);
+        const std::vector<unsigned char>& data = image.levels[current.level];
+
+        // Filas de pixels, o de bloques de 4x4 si es comprimida
+        int rowCount = image.compressed ? (height + 3) / 4 : height;
+        size_t rowBytes = data.size() / rowCount;
+        int rows = std::max(1, std::min(rowCount - current.row, (int)(PBO_SIZE / rowBytes)));
+        size_t bytes = rows * rowBytes;
+
+        glBindBuffer(GL_PIXEL_UNPACK_BUFFER, pbos[nextPbo]);
+        void* mapped = glMapBufferRange(GL_PIXEL_UNPACK_BUFFER, 0, bytes,
+                                        GL_MAP_WRITE_BIT | GL_MAP_INVALIDATE_RANGE_BIT | GL_MAP_UNSYNCHRONIZED_BIT);
+        if (!mapped)
+            return false;
+        std::memcpy(mapped, data.data() + current.row * rowBytes, bytes);
+        glUnmapBuffer(GL_PIXEL_UNPACK_BUFFER);
+
+        GLenum target = current.job.target;
+        glBindTexture(target, current.job.texture);
+        if (image.compressed)
+        {
+            int y = current.row * 4;
+            int h = std::min(rows * 4, height - y);
+            if (target == GL_TEXTURE_2D)
+                glCompressedTexSubImage2D(target, level, 0, y, width, h, image.compressed, (GLsizei)bytes, nullptr);
+            else
+                glCompressedTexSubImage3D(target, level, 0, y, current.job.layer, width, h, 1, image.compressed, (GLsizei)bytes, nullptr);
+        }
+        else
+        {
+            if (target == GL_TEXTURE_2D)
+                glTexSubImage2D(target, level, 0, current.row, width, rows, image.format, GL_UNSIGNED_BYTE, nullptr);
+            else
+                glTexSubImage3D(target, level, 0, current.row, current.job.layer, width, rows, 1, image.format, GL_UNSIGNED_BYTE, nullptr);
+        }
+        fence = glFenceSync(GL_SYNC_GPU_COMMANDS_COMPLETE, 0);
+        nextPbo = (nextPbo + 1) % PBO_COUNT;
+        uploadedBytes += bytes;
+
+        current.row += rows;
+        if (current.row >= rowCount)
+        {
+            current.row = 0;
+            current.level++;
+            if (current.level >= image.levels.size())
+            {
+                current.active = false;
+                complete(current.job);
+                current.job = Job();   // libera la imagen decodificada
+            }
+        }
+        return true;
+    }
+};
+
+#endif